@@ -0,0 +1,222 @@
+/*
+ * bloom.c: Blocked Bloom filter in C
+ *
+ * St: 2026-10-17 Sat 07:16 AM
+ * Up: 2026-10-17 Sat 07:16 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * A blocked Bloom filter: the bit array is cut into blocks of one
+ * 64 byte cache line (BLOOM_BLOCK_WORDS 64 bit words). A key sets
+ * one bit in every word of a single block, picked by its hash, so
+ * adding or checking a key touches exactly one cache line. This is
+ * the "split block" layout of Impala and Parquet, widened to 64 bit
+ * words.
+ *
+ * The filter works on hash values, not keys, so a hash table can
+ * pass the hash it has already computed. Keys cannot be removed;
+ * the owner rebuilds the filter instead.
+ *
+ * With 10 bits per key the false positive rate is about 1%.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/* Odd multipliers picking the bit of each word of a block */
+static const uint64_t bloom_salt[BLOOM_BLOCK_WORDS] = {
+	0x47b6137b44974d91ULL, 0x8824ad5ba2b7289dULL,
+	0x705495c72df1424bULL, 0x9efc49475c6bfb31ULL,
+	0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL,
+	0x94d049bb133111ebULL, 0xd6e8feb86659fd93ULL
+};
+
+/*
+ * Return the block of a hash.
+ *
+ * @b:    Pointer to the bloom filter structure
+ * @hash: Hash of a key
+ */
+static uint64_t *bloom_block(struct bloom *b, uint64_t hash)
+{
+	/* Mix so that hashes differing only in low bits spread */
+	hash *= 0x9e3779b97f4a7c15ULL;
+
+	return b->blocks + ((hash >> 32) & (b->nblocks - 1)) *
+	       BLOOM_BLOCK_WORDS;
+}
+
+/*
+ * Return the bit set by a hash in word `i' of its block.
+ *
+ * @hash: Hash of a key
+ * @i:    Word index in block
+ */
+static uint64_t bloom_bit(uint64_t hash, int i)
+{
+	return (uint64_t) 1 << ((hash * bloom_salt[i]) >> 58);
+}
+
+/*
+ * Create a bloom filter for about `nkeys' keys.
+ *
+ * @nkeys:        Number of keys the filter is sized for
+ * @bits_per_key: Filter bits per key; more bits, fewer false
+ *                positives
+ */
+struct bloom *bloom_create(size_t nkeys, int bits_per_key)
+{
+	size_t nbits;
+	struct bloom *b;
+
+	b = malloc(sizeof(struct bloom));
+	assert(b);
+
+	if (nkeys == 0)
+		nkeys = 1;
+	if (bits_per_key <= 0)
+		bits_per_key = BLOOM_BITS_PER_KEY;
+
+	/* Round block count up to a power of 2 */
+	nbits = nkeys * bits_per_key;
+	b->nblocks = 1;
+	while (b->nblocks * BLOOM_BLOCK_WORDS * 64 < nbits)
+		b->nblocks *= 2;
+
+	/* Align blocks to cache lines */
+	b->blocks = aligned_alloc(BLOOM_BLOCK_WORDS * sizeof(uint64_t),
+	                          b->nblocks * BLOOM_BLOCK_WORDS *
+	                          sizeof(uint64_t));
+	assert(b->blocks);
+	memset(b->blocks, 0, b->nblocks * BLOOM_BLOCK_WORDS *
+	       sizeof(uint64_t));
+
+	b->cap = nkeys;
+	b->bits_per_key = bits_per_key;
+	b->nkeys = 0;
+	b->nneg = 0;
+	b->nfp = 0;
+
+	return b;
+}
+
+/*
+ * Add a key to bloom filter.
+ *
+ * @b:    Pointer to the bloom filter structure
+ * @hash: Hash of the key
+ */
+void bloom_add(struct bloom *b, uint64_t hash)
+{
+	int i;
+	uint64_t *block;
+
+	block = bloom_block(b, hash);
+
+	for (i = 0; i < BLOOM_BLOCK_WORDS; i++)
+		block[i] |= bloom_bit(hash, i);
+
+	b->nkeys++;
+}
+
+/*
+ * Check a key against bloom filter. Return 0 if the key was surely
+ * never added, 1 if it may have been.
+ *
+ * @b:    Pointer to the bloom filter structure
+ * @hash: Hash of the key
+ */
+int bloom_may_contain(struct bloom *b, uint64_t hash)
+{
+	int i;
+	int retval;
+	uint64_t miss;
+	uint64_t bit;
+	uint64_t *block;
+
+	block = bloom_block(b, hash);
+
+	/* No early exit; the whole line is already loaded */
+	miss = 0;
+	for (i = 0; i < BLOOM_BLOCK_WORDS; i++) {
+		bit = bloom_bit(hash, i);
+		miss |= (block[i] & bit) ^ bit;
+	}
+
+	retval = (miss == 0);
+	if (retval == 0)
+		b->nneg++;
+
+	return retval;
+}
+
+/*
+ * Report that a key bloom_may_contain let through was not there
+ * after all, for bloom_fp_rate.
+ *
+ * @b: Pointer to the bloom filter structure
+ */
+void bloom_false_pos(struct bloom *b)
+{
+	b->nfp++;
+}
+
+/*
+ * Return observed false positive rate: the fraction of checked
+ * keys that were absent, but were let through. 0 if no absent key
+ * was checked yet.
+ *
+ * @b: Pointer to the bloom filter structure
+ */
+double bloom_fp_rate(struct bloom *b)
+{
+	if (b->nfp + b->nneg == 0)
+		return 0;
+
+	return (double) b->nfp / (b->nfp + b->nneg);
+}
+
+/*
+ * Destroy a bloom filter.
+ *
+ * @b: Pointer to the bloom filter structure
+ */
+void bloom_destroy(struct bloom *b)
+{
+	free(b->blocks);
+
+	free(b);
+}
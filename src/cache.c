@@ -0,0 +1,647 @@
+/*
+ * cache.c: Sharded bounded cache with CLOCK and W-TinyLFU eviction
+ *
+ * St: 2026-10-17 Sat 07:25 AM
+ * Up: 2026-10-17 Sat 07:25 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * The cache is cut into shards by the top bits of the key hash.
+ * Each shard is a complete cache with its own mutex, a struct ht
+ * indexing its entries, and capacity cap / nshards. Threads
+ * working on different shards do not contend.
+ *
+ * Every put has a charge (1 for counting entries, or a byte size),
+ * and a shard evicts until the charges fit in its capacity.
+ *
+ * Eviction uses CLOCK rather than LRU. Entries of a region form a
+ * circular list, and a hit only sets the entry's ref bit; the list
+ * is never reordered on a hit. To evict, the hand walks the ring,
+ * clearing ref bits, and takes the first entry whose bit was clear.
+ *
+ * CACHE_TINYLFU follows W-TinyLFU (Einziger et al., "TinyLFU: A
+ * Highly Efficient Cache Admission Policy"). New entries go to a
+ * small window region (CACHE_WINDOW_PCT of capacity). An entry
+ * pushed out of the window is admitted to the main region only if
+ * its estimated access frequency is higher than that of the main
+ * region's CLOCK victim. Frequencies come from a count-min sketch of
+ * 4 rows of counters that saturate at 15, with conservative
+ * update. All counters are halved every 10 * width adds, so old
+ * popularity fades. This keeps one time scans from flushing a
+ * frequently used working set, while the window still lets new
+ * popular keys in.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<pthread.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/* Regions, index into ring[] of a shard */
+#define CACHE_WINDOW 0
+#define CACHE_MAIN 1
+
+#define CACHE_SKETCH_ROWS 4
+#define CACHE_SKETCH_MAX_COUNT 15
+
+/*
+ * Copy an entry pointer; the val copy function of shard indexes.
+ *
+ * @ptr: Pointer to a struct cache_entry pointer
+ */
+static void *cache_ptr_cpy(void *ptr)
+{
+	struct cache_entry **dest;
+
+	dest = malloc(sizeof(struct cache_entry *));
+	assert(dest);
+
+	*dest = *(struct cache_entry **) ptr;
+
+	return dest;
+}
+
+/*
+ * Round up to a power of 2, at least `min'.
+ *
+ * @n:   Number to round
+ * @min: Smallest result, a power of 2
+ */
+static size_t cache_round(size_t n, size_t min)
+{
+	size_t r;
+
+	r = min;
+	while (r < n)
+		r *= 2;
+
+	return r;
+}
+
+/*
+ * Return the shard of a key, and set *hashp to the key's hash.
+ *
+ * @c:     Pointer to the cache structure
+ * @key:   Key
+ * @hashp: Set to hash of key
+ */
+static union cache_shard *cache_shard_of(struct cache *c, void *key,
+                                         uint64_t *hashp)
+{
+	*hashp = hash_key(key, c->get_key_size(key), HASH_SEED);
+
+	/* Top bits; the shard's ht uses the low bits */
+	return &c->shards[(*hashp >> 32) & (c->nshards - 1)];
+}
+
+/*
+ * Link an entry to a ring, just behind the hand, so that it is
+ * looked at last.
+ *
+ * @r: Pointer to the ring
+ * @e: Entry to link
+ */
+static void cache_ring_link(struct cache_ring *r, struct cache_entry *e)
+{
+	if (r->hand == NULL) {
+		e->next = e;
+		e->prev = e;
+		r->hand = e;
+	} else {
+		e->next = r->hand;
+		e->prev = r->hand->prev;
+		r->hand->prev->next = e;
+		r->hand->prev = e;
+	}
+
+	r->charge += e->charge;
+}
+
+/*
+ * Unlink an entry from a ring.
+ *
+ * @r: Pointer to the ring
+ * @e: Entry to unlink
+ */
+static void cache_ring_unlink(struct cache_ring *r, struct cache_entry *e)
+{
+	if (e->next == e) {
+		r->hand = NULL;
+	} else {
+		e->prev->next = e->next;
+		e->next->prev = e->prev;
+		if (r->hand == e)
+			r->hand = e->next;
+	}
+
+	r->charge -= e->charge;
+}
+
+/*
+ * Return the CLOCK victim of a ring, without unlinking it: the first
+ * entry from the hand on whose ref bit is clear. Ref bits passed on
+ * the way are cleared. NULL if the ring is empty.
+ *
+ * @r: Pointer to the ring
+ */
+static struct cache_entry *cache_ring_victim(struct cache_ring *r)
+{
+	if (r->hand == NULL)
+		return NULL;
+
+	while (r->hand->ref) {
+		r->hand->ref = 0;
+		r->hand = r->hand->next;
+	}
+
+	return r->hand;
+}
+
+/*
+ * Return counter of a hash in row `i' of the sketch.
+ *
+ * @s:    Pointer to the shard
+ * @hash: Hash of a key
+ * @i:    Row
+ */
+static unsigned char *cache_sketch_counter(union cache_shard *s,
+                                           uint64_t hash, int i)
+{
+	uint64_t h2;
+
+	/* Double hashing gives the 4 rows their own index */
+	h2 = (hash >> 32) | 1;
+
+	return &s->s.sketch[i * s->s.sketch_width +
+	                    ((hash + i * h2) & (s->s.sketch_width - 1))];
+}
+
+/*
+ * Return estimated access count of a hash: the smallest of its
+ * counters.
+ *
+ * @s:    Pointer to the shard
+ * @hash: Hash of a key
+ */
+static unsigned cache_sketch_freq(union cache_shard *s, uint64_t hash)
+{
+	int i;
+	unsigned n;
+	unsigned min;
+
+	min = CACHE_SKETCH_MAX_COUNT;
+	for (i = 0; i < CACHE_SKETCH_ROWS; i++) {
+		n = *cache_sketch_counter(s, hash, i);
+		if (n < min)
+			min = n;
+	}
+
+	return min;
+}
+
+/*
+ * Count an access of a hash. Only the counters equal to the
+ * smallest are incremented (conservative update). Every 10 * width
+ * adds, all counters are halved.
+ *
+ * @s:    Pointer to the shard
+ * @hash: Hash of a key
+ */
+static void cache_sketch_add(union cache_shard *s, uint64_t hash)
+{
+	int i;
+	size_t j;
+	unsigned min;
+	unsigned char *ctr;
+
+	min = cache_sketch_freq(s, hash);
+	if (min < CACHE_SKETCH_MAX_COUNT)
+		for (i = 0; i < CACHE_SKETCH_ROWS; i++) {
+			ctr = cache_sketch_counter(s, hash, i);
+			if (*ctr == min)
+				(*ctr)++;
+		}
+
+	if (++s->s.sketch_adds < 10 * s->s.sketch_width)
+		return;
+
+	for (j = 0; j < CACHE_SKETCH_ROWS * s->s.sketch_width; j++)
+		s->s.sketch[j] >>= 1;
+	s->s.sketch_adds = 0;
+}
+
+/*
+ * Create a cache.
+ *
+ * @cap:          Capacity, in the unit of charges given to
+ *                cache_put. Split evenly among shards.
+ * @nshards:      Total shards. Rounded up to a power of 2.
+ * @policy:       CACHE_CLOCK or CACHE_TINYLFU
+ * @k_cpy:        Function to copy key
+ * @v_cpy:        Function to copy val
+ * @k_cmp:        Function to compare key
+ * @v_cmp:        Function to compare val
+ * @get_key_size: Function to get key size
+ */
+struct cache *cache_create(size_t cap, size_t nshards, int policy,
+                           void *(*k_cpy) (void *),
+			   void *(*v_cpy) (void *),
+			   int (*k_cmp) (void *, void *),
+			   int (*v_cmp) (void *, void *),
+			   int (*get_key_size) (void *))
+{
+	size_t i;
+	size_t shard_cap;
+	size_t win_cap;
+	union cache_shard *s;
+	struct cache *c;
+
+	assert(policy == CACHE_CLOCK || policy == CACHE_TINYLFU);
+
+	c = malloc(sizeof(struct cache));
+	assert(c);
+
+	c->nshards = cache_round(nshards, 1);
+	c->policy = policy;
+
+	shard_cap = cap / c->nshards;
+	if (shard_cap == 0)
+		shard_cap = 1;
+
+	win_cap = 0;
+	if (policy == CACHE_TINYLFU) {
+		win_cap = shard_cap * CACHE_WINDOW_PCT / 100;
+		if (win_cap == 0)
+			win_cap = 1;
+	}
+
+	c->shards = malloc(c->nshards * sizeof(union cache_shard));
+	assert(c->shards);
+
+	for (i = 0; i < c->nshards; i++) {
+		s = &c->shards[i];
+		pthread_mutex_init(&s->s.lock, NULL);
+		s->s.index = ht_create(16, k_cpy, cache_ptr_cpy, k_cmp,
+		                       NULL, get_key_size);
+
+		memset(s->s.ring, 0, sizeof(s->s.ring));
+		s->s.ring[CACHE_WINDOW].cap = win_cap;
+		s->s.ring[CACHE_MAIN].cap = (shard_cap > win_cap) ?
+		                            shard_cap - win_cap : 1;
+
+		s->s.sketch = NULL;
+		s->s.sketch_width = 0;
+		s->s.sketch_adds = 0;
+		if (policy == CACHE_TINYLFU) {
+			s->s.sketch_width = (shard_cap < CACHE_SKETCH_MAX) ?
+			                    shard_cap : CACHE_SKETCH_MAX;
+			s->s.sketch_width = cache_round(s->s.sketch_width, 16);
+			s->s.sketch = calloc(CACHE_SKETCH_ROWS,
+			                     s->s.sketch_width);
+			assert(s->s.sketch);
+		}
+
+		s->s.hits = 0;
+		s->s.misses = 0;
+	}
+
+	c->k_cpy = k_cpy;
+	c->v_cpy = v_cpy;
+
+	c->k_cmp = k_cmp;
+	c->v_cmp = v_cmp;
+
+	c->get_key_size = get_key_size;
+
+	return c;
+}
+
+/*
+ * Find the entry of a key in a shard. Return NULL if the key is
+ * not cached.
+ *
+ * @s:   Pointer to the shard, locked
+ * @key: Key to find
+ */
+static struct cache_entry *cache_find(union cache_shard *s, void *key)
+{
+	void *vptr;
+
+	vptr = ht_get(s->s.index, key);
+	if (vptr == NULL)
+		return NULL;
+
+	return *(struct cache_entry **) vptr;
+}
+
+/*
+ * Remove an unlinked entry from the index and destroy it.
+ *
+ * @s: Pointer to the shard, locked
+ * @e: Entry, not on any ring
+ */
+static void cache_drop(union cache_shard *s, struct cache_entry *e)
+{
+	ht_delete(s->s.index, e->key);
+
+	free(e->key);
+	free(e->val);
+	free(e);
+}
+
+/*
+ * Evict CLOCK victims of a ring until `need' more charge fits in it.
+ *
+ * @s:    Pointer to the shard, locked
+ * @r:    Ring
+ * @need: Charge to make room for
+ */
+static void cache_make_room(union cache_shard *s, struct cache_ring *r,
+                            size_t need)
+{
+	struct cache_entry *victim;
+
+	while (r->charge + need > r->cap &&
+	       (victim = cache_ring_victim(r)) != NULL) {
+		cache_ring_unlink(r, victim);
+		cache_drop(s, victim);
+	}
+}
+
+/*
+ * Move entries out of the window while it is over capacity. Each
+ * one goes to the main region if there is room, or if it is
+ * accessed more often than the main region's victim, which is then
+ * evicted. Else it is evicted.
+ *
+ * @s: Pointer to the shard, locked
+ */
+static void cache_drain_window(union cache_shard *s)
+{
+	struct cache_ring *win;
+	struct cache_ring *mainr;
+	struct cache_entry *cand;
+	struct cache_entry *victim;
+
+	win = &s->s.ring[CACHE_WINDOW];
+	mainr = &s->s.ring[CACHE_MAIN];
+
+	while (win->charge > win->cap) {
+		cand = cache_ring_victim(win);
+		cache_ring_unlink(win, cand);
+
+		if (mainr->charge + cand->charge > mainr->cap) {
+			victim = cache_ring_victim(mainr);
+			if (cand->charge > mainr->cap || victim == NULL ||
+			    cache_sketch_freq(s, cand->hash) <=
+			    cache_sketch_freq(s, victim->hash)) {
+				cache_drop(s, cand);
+				continue;
+			}
+			cache_make_room(s, mainr, cand->charge);
+		}
+
+		cand->region = CACHE_MAIN;
+		cache_ring_link(mainr, cand);
+	}
+}
+
+/*
+ * Get a copy of the val cached for a key, made with v_cpy. Caller
+ * owns the copy. Return NULL if key is not cached.
+ *
+ * @c:   Pointer to the cache structure
+ * @key: Key of the data to get
+ */
+void *cache_get(struct cache *c, void *key)
+{
+	void *retval;
+	uint64_t hash;
+	union cache_shard *s;
+	struct cache_entry *e;
+
+	s = cache_shard_of(c, key, &hash);
+	retval = NULL;
+
+	pthread_mutex_lock(&s->s.lock);
+
+	if (c->policy == CACHE_TINYLFU)
+		cache_sketch_add(s, hash);
+
+	e = cache_find(s, key);
+	if (e != NULL) {
+		e->ref = 1;
+		retval = c->v_cpy(e->val);
+		s->s.hits++;
+	} else {
+		s->s.misses++;
+	}
+
+	pthread_mutex_unlock(&s->s.lock);
+
+	return retval;
+}
+
+/*
+ * Cache a val for a key, replacing the val if the key is already
+ * cached, and evicting as needed. A val whose charge is more than
+ * the capacity of a shard is not cached.
+ *
+ * @c:      Pointer to the cache structure
+ * @key:    Key of the data
+ * @val:    Val of the data
+ * @charge: Capacity the data uses, e.g. 1 or its size in bytes
+ */
+void cache_put(struct cache *c, void *key, void *val, size_t charge)
+{
+	uint64_t hash;
+	union cache_shard *s;
+	struct cache_ring *r;
+	struct cache_entry *e;
+
+	s = cache_shard_of(c, key, &hash);
+
+	pthread_mutex_lock(&s->s.lock);
+
+	if (c->policy == CACHE_TINYLFU)
+		cache_sketch_add(s, hash);
+
+	/* Replace val; the entry may now be too big for its ring */
+	e = cache_find(s, key);
+	if (e != NULL) {
+		free(e->val);
+		e->val = c->v_cpy(val);
+		e->ref = 1;
+		r = &s->s.ring[e->region];
+		r->charge = r->charge - e->charge + charge;
+		e->charge = charge;
+		/* The window is drained through admission, not evicted */
+		if (e->region == CACHE_MAIN)
+			cache_make_room(s, r, 0);
+		if (c->policy == CACHE_TINYLFU)
+			cache_drain_window(s);
+		goto out;
+	}
+
+	if (charge > s->s.ring[CACHE_MAIN].cap)
+		goto out;
+
+	e = malloc(sizeof(struct cache_entry));
+	assert(e);
+
+	e->key = c->k_cpy(key);
+	e->val = c->v_cpy(val);
+	e->charge = charge;
+	e->hash = hash;
+	e->ref = 0;
+
+	ht_upsert(s->s.index, key, &e);
+
+	if (c->policy == CACHE_CLOCK) {
+		e->region = CACHE_MAIN;
+		cache_make_room(s, &s->s.ring[CACHE_MAIN], charge);
+		cache_ring_link(&s->s.ring[CACHE_MAIN], e);
+	} else {
+		e->region = CACHE_WINDOW;
+		cache_ring_link(&s->s.ring[CACHE_WINDOW], e);
+		cache_drain_window(s);
+	}
+
+out:
+	pthread_mutex_unlock(&s->s.lock);
+}
+
+/*
+ * Remove a key from cache. Has no effect if key is not cached.
+ *
+ * @c:   Pointer to the cache structure
+ * @key: Key to remove
+ */
+void cache_erase(struct cache *c, void *key)
+{
+	uint64_t hash;
+	union cache_shard *s;
+	struct cache_entry *e;
+
+	s = cache_shard_of(c, key, &hash);
+
+	pthread_mutex_lock(&s->s.lock);
+
+	e = cache_find(s, key);
+	if (e != NULL) {
+		cache_ring_unlink(&s->s.ring[e->region], e);
+		cache_drop(s, e);
+	}
+
+	pthread_mutex_unlock(&s->s.lock);
+}
+
+/*
+ * Return the total cached members count.
+ *
+ * @c: Pointer to the cache structure
+ */
+size_t cache_tot_memb(struct cache *c)
+{
+	size_t i;
+	size_t retval;
+
+	retval = 0;
+	for (i = 0; i < c->nshards; i++) {
+		pthread_mutex_lock(&c->shards[i].s.lock);
+		retval += ht_tot_memb(c->shards[i].s.index);
+		pthread_mutex_unlock(&c->shards[i].s.lock);
+	}
+
+	return retval;
+}
+
+/*
+ * Return fraction of cache_get calls that were hits, 0 if there
+ * were none.
+ *
+ * @c: Pointer to the cache structure
+ */
+double cache_hit_rate(struct cache *c)
+{
+	size_t i;
+	size_t hits;
+	size_t misses;
+
+	hits = 0;
+	misses = 0;
+	for (i = 0; i < c->nshards; i++) {
+		pthread_mutex_lock(&c->shards[i].s.lock);
+		hits += c->shards[i].s.hits;
+		misses += c->shards[i].s.misses;
+		pthread_mutex_unlock(&c->shards[i].s.lock);
+	}
+
+	if (hits + misses == 0)
+		return 0;
+
+	return (double) hits / (hits + misses);
+}
+
+/*
+ * Destroy a cache.
+ *
+ * @c: Pointer to the cache structure
+ */
+void cache_destroy(struct cache *c)
+{
+	int j;
+	size_t i;
+	union cache_shard *s;
+	struct cache_entry *e;
+
+	for (i = 0; i < c->nshards; i++) {
+		s = &c->shards[i];
+		for (j = 0; j < 2; j++)
+			while ((e = s->s.ring[j].hand) != NULL) {
+				cache_ring_unlink(&s->s.ring[j], e);
+				free(e->key);
+				free(e->val);
+				free(e);
+			}
+		ht_destroy(s->s.index);
+		free(s->s.sketch);
+		pthread_mutex_destroy(&s->s.lock);
+	}
+
+	free(c->shards);
+
+	free(c);
+}
@@ -0,0 +1,419 @@
+/*
+ * conc_hash_table.c: Lock striped concurrent hash table in C
+ *
+ * St: 2026-10-17 Sat 07:08 AM
+ * Up: 2026-10-17 Sat 07:08 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * The slot array is split into `nstripes' lock stripes, slot i
+ * belonging to stripe i % nstripes. Since both counts are powers of
+ * 2 and tot_slots >= nstripes, the stripe of a key depends only on
+ * the low bits of its hash, and does not change when the table
+ * grows. So a thread first locks the stripe of its key, and only
+ * then reads h->table and h->tot_slots.
+ *
+ * Lookups take the read lock of their stripe, so lookups of any
+ * keys and updates of keys in other stripes go on in parallel.
+ *
+ * Each stripe counts its members. When an insert takes a stripe
+ * beyond max_load, the table is doubled: the inserting thread drops
+ * its lock and takes the write lock of every stripe, in order, so
+ * no two growers can deadlock. If some other thread grew the table
+ * in between, there is nothing left to do.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<pthread.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/*
+ * Hash function.
+ *
+ * @h:   Pointer to the hash table structure. Needed to get
+ *       the key size.
+ * @key: Key whose hash value is to be calculated
+ */
+static size_t cht_hash_func(struct cht *h, void *key)
+{
+	return hash_key(key, h->get_key_size(key), HASH_SEED);
+}
+
+/*
+ * Return the stripe of a hash.
+ *
+ * @h:    Pointer to the hash table structure
+ * @hash: Hash value
+ */
+static union cht_stripe *cht_stripe_of(struct cht *h, size_t hash)
+{
+	return &h->stripes[hash & (h->nstripes - 1)];
+}
+
+/*
+ * Round up a count to a power of 2, at least `min'.
+ *
+ * @n:   Count to round up
+ * @min: Smallest result
+ */
+static size_t cht_round(size_t n, size_t min)
+{
+	size_t retval;
+
+	retval = 1;
+	while (retval < n || retval < min)
+		retval *= 2;
+
+	return retval;
+}
+
+/*
+ * Create a concurrent hash table.
+ *
+ * @tot_slots:    Total slots in the hash table. Rounded up to a
+ *                power of 2, at least nstripes.
+ * @nstripes:     Total lock stripes. Rounded up to a power of 2.
+ * @k_cpy:        Function to copy key
+ * @v_cpy:        Function to copy val
+ * @k_cmp:        Function to compare key
+ * @v_cmp:        Function to compare val
+ * @get_key_size: Function to get key size
+ */
+struct cht *cht_create(size_t tot_slots, size_t nstripes,
+                       void *(*k_cpy) (void *),
+		       void *(*v_cpy) (void *),
+		       int (*k_cmp) (void *, void *),
+		       int (*v_cmp) (void *, void *),
+		       int (*get_key_size) (void *))
+{
+	size_t i;
+	struct cht *h;
+
+	h = malloc(sizeof(struct cht));
+	assert(h);
+
+	h->nstripes = cht_round(nstripes, 1);
+	h->tot_slots = cht_round(tot_slots, h->nstripes);
+
+	h->table = calloc(h->tot_slots, sizeof(struct cht_node *));
+	assert(h->table);
+
+	h->stripes = malloc(h->nstripes * sizeof(union cht_stripe));
+	assert(h->stripes);
+	for (i = 0; i < h->nstripes; i++) {
+		pthread_rwlock_init(&h->stripes[i].s.lock, NULL);
+		h->stripes[i].s.nmemb = 0;
+	}
+
+	h->max_load = CHT_MAX_LOAD;
+
+	h->k_cpy = k_cpy;
+	h->v_cpy = v_cpy;
+
+	h->k_cmp = k_cmp;
+	h->v_cmp = v_cmp;
+
+	h->get_key_size = get_key_size;
+
+	return h;
+}
+
+/*
+ * Find the chain link pointing to the node of a key, or the link
+ * at the end of its chain if the key is not there. Caller must hold
+ * the lock of the key's stripe.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key to find
+ * @hash: Hash of the key
+ */
+static struct cht_node **cht_find(struct cht *h, void *key, size_t hash)
+{
+	struct cht_node **link;
+
+	link = &h->table[hash & (h->tot_slots - 1)];
+	while (*link != NULL) {
+		if ((*link)->hash == hash && h->k_cmp((*link)->key, key) == 0)
+			break;
+		link = &(*link)->next;
+	}
+
+	return link;
+}
+
+/*
+ * Double the table, unless some other thread has done so since the
+ * caller saw it at `seen_slots' slots.
+ *
+ * @h:          Pointer to the hash table structure
+ * @seen_slots: tot_slots as seen by the caller
+ */
+static void cht_grow(struct cht *h, size_t seen_slots)
+{
+	size_t i;
+	size_t idx;
+	size_t new_tot_slots;
+	struct cht_node *node;
+	struct cht_node *next;
+	struct cht_node **new_table;
+
+	for (i = 0; i < h->nstripes; i++)
+		pthread_rwlock_wrlock(&h->stripes[i].s.lock);
+
+	if (h->tot_slots == seen_slots) {
+		new_tot_slots = h->tot_slots * 2;
+		new_table = calloc(new_tot_slots, sizeof(struct cht_node *));
+		assert(new_table);
+
+		/* Relink every node, hashes are cached */
+		for (i = 0; i < h->tot_slots; i++) {
+			for (node = h->table[i]; node != NULL; node = next) {
+				next = node->next;
+				idx = node->hash & (new_tot_slots - 1);
+				node->next = new_table[idx];
+				new_table[idx] = node;
+			}
+		}
+
+		free(h->table);
+		h->table = new_table;
+		h->tot_slots = new_tot_slots;
+	}
+
+	for (i = h->nstripes; i > 0; i--)
+		pthread_rwlock_unlock(&h->stripes[i - 1].s.lock);
+}
+
+/*
+ * Insert a new data to hash table. If the key is already present
+ * its val is replaced. Return 1 if a new member was inserted, 0 if
+ * a val was replaced.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to be inserted
+ * @val: Val of the data to be inserted
+ */
+int cht_insert(struct cht *h, void *key, void *val)
+{
+	int retval;
+	int grow;
+	size_t hash;
+	size_t seen_slots;
+	union cht_stripe *st;
+	struct cht_node **link;
+	struct cht_node *node;
+
+	hash = cht_hash_func(h, key);
+	st = cht_stripe_of(h, hash);
+	grow = 0;
+	seen_slots = 0;
+
+	pthread_rwlock_wrlock(&st->s.lock);
+
+	link = cht_find(h, key, hash);
+	if (*link != NULL) {
+		free((*link)->val);
+		(*link)->val = h->v_cpy(val);
+		retval = 0;
+	} else {
+		node = malloc(sizeof(struct cht_node));
+		assert(node);
+		node->key = h->k_cpy(key);
+		node->val = h->v_cpy(val);
+		node->hash = hash;
+		node->next = NULL;
+		*link = node;
+
+		st->s.nmemb++;
+		seen_slots = h->tot_slots;
+		if (st->s.nmemb > h->max_load * (seen_slots / h->nstripes))
+			grow = 1;
+		retval = 1;
+	}
+
+	pthread_rwlock_unlock(&st->s.lock);
+
+	if (grow == 1)
+		cht_grow(h, seen_slots);
+
+	return retval;
+}
+
+/*
+ * Search for a data in hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to be searched
+ */
+int cht_search(struct cht *h, void *key)
+{
+	int retval;
+	size_t hash;
+	union cht_stripe *st;
+
+	hash = cht_hash_func(h, key);
+	st = cht_stripe_of(h, hash);
+
+	pthread_rwlock_rdlock(&st->s.lock);
+
+	if (*cht_find(h, key, hash) != NULL)
+		retval = 1;
+	else
+		retval = 0;
+
+	pthread_rwlock_unlock(&st->s.lock);
+
+	return retval;
+}
+
+/*
+ * Get a copy of the val stored for a key, made with v_cpy. Caller
+ * owns the copy. Return NULL if key is not in the table.
+ *
+ * A copy is returned as the stored val may be replaced or freed by
+ * another thread as soon as the lock is dropped.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to get
+ */
+void *cht_get(struct cht *h, void *key)
+{
+	void *retval;
+	size_t hash;
+	union cht_stripe *st;
+	struct cht_node **link;
+
+	hash = cht_hash_func(h, key);
+	st = cht_stripe_of(h, hash);
+
+	pthread_rwlock_rdlock(&st->s.lock);
+
+	link = cht_find(h, key, hash);
+	if (*link != NULL)
+		retval = h->v_cpy((*link)->val);
+	else
+		retval = NULL;
+
+	pthread_rwlock_unlock(&st->s.lock);
+
+	return retval;
+}
+
+/*
+ * Delete an item from hash table. Has no effect if item is not
+ * found in the hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Pointer to key of the item to delete
+ */
+void cht_delete(struct cht *h, void *key)
+{
+	size_t hash;
+	union cht_stripe *st;
+	struct cht_node **link;
+	struct cht_node *node;
+
+	hash = cht_hash_func(h, key);
+	st = cht_stripe_of(h, hash);
+
+	pthread_rwlock_wrlock(&st->s.lock);
+
+	link = cht_find(h, key, hash);
+	node = *link;
+	if (node != NULL) {
+		*link = node->next;
+		st->s.nmemb--;
+	}
+
+	pthread_rwlock_unlock(&st->s.lock);
+
+	/* Node is unreachable now, free it outside the lock */
+	if (node != NULL) {
+		free(node->key);
+		free(node->val);
+		free(node);
+	}
+}
+
+/*
+ * Return the total members count. Only a snapshot if other threads
+ * are changing the table.
+ *
+ * @h: Pointer to the hash table structure
+ */
+size_t cht_tot_memb(struct cht *h)
+{
+	size_t i;
+	size_t nmemb;
+
+	nmemb = 0;
+	for (i = 0; i < h->nstripes; i++) {
+		pthread_rwlock_rdlock(&h->stripes[i].s.lock);
+		nmemb += h->stripes[i].s.nmemb;
+		pthread_rwlock_unlock(&h->stripes[i].s.lock);
+	}
+
+	return nmemb;
+}
+
+/*
+ * Destroy a hash table. No other thread may be using it.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void cht_destroy(struct cht *h)
+{
+	size_t i;
+	struct cht_node *node;
+	struct cht_node *next;
+
+	for (i = 0; i < h->tot_slots; i++) {
+		for (node = h->table[i]; node != NULL; node = next) {
+			next = node->next;
+			free(node->key);
+			free(node->val);
+			free(node);
+		}
+	}
+
+	for (i = 0; i < h->nstripes; i++)
+		pthread_rwlock_destroy(&h->stripes[i].s.lock);
+
+	free(h->stripes);
+	free(h->table);
+
+	free(h);
+}
@@ -0,0 +1,234 @@
+/*
+ * count_min.c: Count-min sketch with conservative update
+ *
+ * St: 2026-10-17 Sat 07:40 AM
+ * Up: 2026-10-17 Sat 07:40 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * Count-min sketch (Cormode and Muthukrishnan, 2005). The sketch
+ * has depth rows of width counters; a key maps to one counter per
+ * row, and its count estimate is the least of those counters.
+ * Counters only ever over count, so an estimate is never below the
+ * true count. Sized with width >= e / eps and depth >= ln(1 / delta),
+ * an estimate is at most eps * total above the true count with
+ * probability at least 1 - delta, total being the sum of all
+ * counts added. Memory is fixed: 4 * width * depth bytes.
+ *
+ * Rows are indexed by double hashing of the 64 bit hash_key() hash,
+ * h1 + i * h2, so a key is hashed once whatever the depth.
+ *
+ * Adds use conservative update (Estan and Varghese): a row counter
+ * is only raised as far as the new estimate, min + count, so
+ * counters shared with heavier keys are not inflated further. This
+ * keeps the bounds above and cuts the error a lot on skewed streams.
+ *
+ * Sketches of the same size merge by adding counters. Each counter
+ * of a conservative sketch is still at least the true count of every
+ * key mapping to it, and at most the plain count-min counter, so
+ * the merged sketch keeps both bounds for the combined stream.
+ * Threads can each fill their own sketch and merge at the end.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<math.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/*
+ * Create a count-min sketch.
+ *
+ * @eps:          Error bound, relative to the total count,
+ *                0 < eps < 1
+ * @delta:        Chance the bound is missed, 0 < delta < 1
+ * @get_key_size: Function to get key size
+ */
+struct cms *cms_create(double eps, double delta,
+                       int (*get_key_size) (void *))
+{
+	size_t width;
+	struct cms *c;
+
+	assert(eps > 0 && eps < 1 && delta > 0 && delta < 1);
+
+	c = malloc(sizeof(struct cms));
+	assert(c);
+
+	/* Power of 2 width, so a row index is a mask */
+	width = 1;
+	while (width < ceil(exp(1.0) / eps))
+		width *= 2;
+
+	c->width = width;
+	c->depth = (int) ceil(log(1 / delta));
+	if (c->depth < 1)
+		c->depth = 1;
+	c->total = 0;
+	c->get_key_size = get_key_size;
+
+	c->counters = calloc(c->width * c->depth, sizeof(uint32_t));
+	assert(c->counters);
+
+	return c;
+}
+
+/*
+ * Return counter of a hash in row `i'.
+ *
+ * @c:    Pointer to the cms structure
+ * @hash: Hash of a key
+ * @i:    Row
+ */
+static uint32_t *cms_counter(struct cms *c, uint64_t hash, int i)
+{
+	uint64_t h2;
+
+	h2 = (hash >> 32) | 1;
+
+	return &c->counters[i * c->width +
+	                    ((hash + i * h2) & (c->width - 1))];
+}
+
+/*
+ * Return the estimated count of a hash.
+ *
+ * @c:    Pointer to the cms structure
+ * @hash: 64 bit hash of a key
+ */
+uint32_t cms_estimate_hash(struct cms *c, uint64_t hash)
+{
+	int i;
+	uint32_t n;
+	uint32_t retval;
+
+	retval = UINT32_MAX;
+	for (i = 0; i < c->depth; i++) {
+		n = *cms_counter(c, hash, i);
+		if (n < retval)
+			retval = n;
+	}
+
+	return retval;
+}
+
+/*
+ * Add `count' occurrences of a hash, with conservative update.
+ * Counters saturate at UINT32_MAX. Hashes must come from hash_key()
+ * with HASH_SEED, as cms_add makes them, for sketches to be
+ * mergeable.
+ *
+ * @c:     Pointer to the cms structure
+ * @hash:  64 bit hash of a key
+ * @count: Occurrences to add
+ */
+void cms_add_hash(struct cms *c, uint64_t hash, uint32_t count)
+{
+	int i;
+	uint32_t est;
+	uint32_t *ctr;
+
+	est = cms_estimate_hash(c, hash);
+	est = (est > UINT32_MAX - count) ? UINT32_MAX : est + count;
+
+	for (i = 0; i < c->depth; i++) {
+		ctr = cms_counter(c, hash, i);
+		if (*ctr < est)
+			*ctr = est;
+	}
+
+	c->total += count;
+}
+
+/*
+ * Add `count' occurrences of a key.
+ *
+ * @c:     Pointer to the cms structure
+ * @key:   Key to count
+ * @count: Occurrences to add
+ */
+void cms_add(struct cms *c, void *key, uint32_t count)
+{
+	cms_add_hash(c, hash_key(key, c->get_key_size(key), HASH_SEED), count);
+}
+
+/*
+ * Return the estimated count of a key: never less than the true
+ * count, and with probability 1 - delta at most eps * c->total more.
+ *
+ * @c:   Pointer to the cms structure
+ * @key: Key to look up
+ */
+uint32_t cms_estimate(struct cms *c, void *key)
+{
+	uint64_t hash;
+
+	hash = hash_key(key, c->get_key_size(key), HASH_SEED);
+
+	return cms_estimate_hash(c, hash);
+}
+
+/*
+ * Merge src into dst by adding counters, so that dst counts both
+ * streams. Both must have been made with the same eps and delta.
+ * src is not changed.
+ *
+ * @dst: Pointer to the cms structure to merge into
+ * @src: Pointer to the cms structure to merge from
+ */
+void cms_merge(struct cms *dst, struct cms *src)
+{
+	size_t i;
+
+	assert(dst->width == src->width && dst->depth == src->depth);
+
+	for (i = 0; i < dst->width * dst->depth; i++)
+		dst->counters[i] =
+		(dst->counters[i] > UINT32_MAX - src->counters[i]) ?
+		UINT32_MAX : dst->counters[i] + src->counters[i];
+
+	dst->total += src->total;
+}
+
+/*
+ * Destroy a count-min sketch.
+ *
+ * @c: Pointer to the cms structure
+ */
+void cms_destroy(struct cms *c)
+{
+	free(c->counters);
+
+	free(c);
+}
@@ -0,0 +1,517 @@
+/*
+ * cuckoo_hash_table.c: Bucketized cuckoo hash table in C
+ *
+ * St: 2026-10-17 Sat 07:18 AM
+ * Up: 2026-10-17 Sat 08:22 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * Buckets of CKT_BUCKET_SLOTS slots. Every key has two candidate
+ * buckets, from the low and high 32 bits of its hash, and is always
+ * in one of them. A lookup looks at those two buckets and nothing
+ * else, so its cost does not grow with the load factor or with bad
+ * luck, unlike a chain in struct ht.
+ *
+ * Insert puts the key in a free slot of either bucket if there is
+ * one. If both are full, a breadth first search over buckets finds
+ * the shortest chain of members that can each move to their other
+ * bucket, ending at a free slot. The chain is then shifted one step
+ * from the free end, so the table is never in a state where a key
+ * is missing. The search gives up after CKT_BFS_MAX buckets, and
+ * the table doubles.
+ *
+ * Cached hashes give both buckets of a member without calling the
+ * hash function again, when displacing and when growing.
+ *
+ * A bucket is one cache line: the cached hashes and the keys of its
+ * slots, allocated CKT_LINE aligned. Slots are compared on the hash
+ * first, so a miss reads two lines and no key. Vals live in a
+ * separate array and cost one more line, only on a hit.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/* Slot p, counted over the whole table, as bucket and index */
+#define Ckt_b(p) ((p) / CKT_BUCKET_SLOTS)
+#define Ckt_i(p) ((p) % CKT_BUCKET_SLOTS)
+
+/* A bucket visited by the displacement search */
+struct ckt_bfs_node {
+	size_t bucket;      /* bucket index */
+	int parent;         /* index of parent node, -1 for a root */
+	int pslot;          /* slot of parent's bucket whose member
+	                       would move here */
+};
+
+/*
+ * Hash function.
+ *
+ * @h:   Pointer to the hash table structure. Needed to get
+ *       the key size.
+ * @key: Key whose hash value is to be calculated
+ */
+static size_t ckt_hash_func(struct ckt *h, void *key)
+{
+	return hash_key(key, h->get_key_size(key), HASH_SEED);
+}
+
+/*
+ * Return first candidate bucket of a hash.
+ *
+ * @h:    Pointer to the hash table structure
+ * @hash: Hash of a key
+ */
+static size_t ckt_bucket1(struct ckt *h, size_t hash)
+{
+	return hash & (h->tot_buckets - 1);
+}
+
+/*
+ * Return second candidate bucket of a hash; never the same as the
+ * first one.
+ *
+ * @h:    Pointer to the hash table structure
+ * @hash: Hash of a key
+ */
+static size_t ckt_bucket2(struct ckt *h, size_t hash)
+{
+	size_t b1;
+	size_t b2;
+
+	b1 = ckt_bucket1(h, hash);
+	b2 = ((uint64_t) hash >> 32) & (h->tot_buckets - 1);
+	if (b2 == b1)
+		b2 = b1 ^ 1;
+
+	return b2;
+}
+
+/*
+ * Return the candidate bucket of a member other than `b'.
+ *
+ * @h:    Pointer to the hash table structure
+ * @hash: Hash of the member
+ * @b:    Bucket the member is in
+ */
+static size_t ckt_alt_bucket(struct ckt *h, size_t hash, size_t b)
+{
+	size_t b1;
+
+	b1 = ckt_bucket1(h, hash);
+
+	return (b == b1) ? ckt_bucket2(h, hash) : b1;
+}
+
+/*
+ * Return index of a free slot of a bucket, or -1 if it is full.
+ *
+ * @h: Pointer to the hash table structure
+ * @b: Bucket index
+ */
+static int ckt_free_slot(struct ckt *h, size_t b)
+{
+	int i;
+
+	for (i = 0; i < CKT_BUCKET_SLOTS; i++)
+		if (h->buckets[b].key[i] == NULL)
+			return i;
+
+	return -1;
+}
+
+/*
+ * Allocate the bucket and val arrays for h->tot_buckets buckets,
+ * every slot empty. Buckets are CKT_LINE aligned, so that each one
+ * is exactly one cache line.
+ *
+ * @h: Pointer to the hash table structure
+ */
+static void ckt_alloc(struct ckt *h)
+{
+	size_t size;
+
+	size = h->tot_buckets * sizeof(struct ckt_bucket);
+	size = (size + CKT_LINE - 1) / CKT_LINE * CKT_LINE;
+
+	h->buckets = aligned_alloc(CKT_LINE, size);
+	assert(h->buckets);
+	memset(h->buckets, 0, size);
+
+	h->vals = calloc(h->tot_buckets * CKT_BUCKET_SLOTS, sizeof(void *));
+	assert(h->vals);
+}
+
+/*
+ * Store a member in slot `p'.
+ *
+ * @h:    Pointer to the hash table structure
+ * @p:    Slot, counted over the whole table
+ * @key:  Key of the member, owned by the table
+ * @val:  Val of the member, owned by the table
+ * @hash: Hash of the key
+ */
+static void ckt_set(struct ckt *h, size_t p, void *key, void *val,
+                    size_t hash)
+{
+	h->buckets[Ckt_b(p)].hash[Ckt_i(p)] = hash;
+	h->buckets[Ckt_b(p)].key[Ckt_i(p)] = key;
+	h->vals[p] = val;
+}
+
+/*
+ * Create a cuckoo hash table.
+ *
+ * @tot_slots:    Total slots in the hash table. Rounded up so
+ *                that the bucket count is a power of 2, at least 2.
+ * @k_cpy:        Function to copy key
+ * @v_cpy:        Function to copy val
+ * @k_cmp:        Function to compare key
+ * @v_cmp:        Function to compare val
+ * @get_key_size: Function to get key size
+ */
+struct ckt *ckt_create(size_t tot_slots,
+                       void *(*k_cpy) (void *),
+		       void *(*v_cpy) (void *),
+		       int (*k_cmp) (void *, void *),
+		       int (*v_cmp) (void *, void *),
+		       int (*get_key_size) (void *))
+{
+	struct ckt *h;
+
+	h = malloc(sizeof(struct ckt));
+	assert(h);
+
+	h->tot_buckets = 2;
+	while (h->tot_buckets * CKT_BUCKET_SLOTS < tot_slots)
+		h->tot_buckets *= 2;
+
+	ckt_alloc(h);
+
+	h->nmemb = 0;
+
+	h->k_cpy = k_cpy;
+	h->v_cpy = v_cpy;
+
+	h->k_cmp = k_cmp;
+	h->v_cmp = v_cmp;
+
+	h->get_key_size = get_key_size;
+
+	return h;
+}
+
+/*
+ * Find slot holding a key. Return 1 and set *p to it, or return 0
+ * if the key is not in the table. Looks at two buckets at most, and
+ * only at keys whose cached hash matches.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key to find
+ * @hash: Hash of the key
+ * @p:    Set to the slot, counted over the whole table
+ */
+static int ckt_find(struct ckt *h, void *key, size_t hash, size_t *p)
+{
+	int i;
+	int j;
+	size_t b[2];
+	struct ckt_bucket *bkt;
+
+	b[0] = ckt_bucket1(h, hash);
+	b[1] = ckt_bucket2(h, hash);
+
+	for (j = 0; j < 2; j++) {
+		bkt = &h->buckets[b[j]];
+		for (i = 0; i < CKT_BUCKET_SLOTS; i++)
+			if (bkt->key[i] != NULL && bkt->hash[i] == hash &&
+			    h->k_cmp(bkt->key[i], key) == 0) {
+				*p = b[j] * CKT_BUCKET_SLOTS + i;
+				return 1;
+			}
+	}
+
+	return 0;
+}
+
+/*
+ * Return 1 if bucket `b' is node `n' or one of its ancestors in
+ * the displacement search; a chain must not pass a bucket twice.
+ *
+ * @q: Search nodes
+ * @n: Node index
+ * @b: Bucket index
+ */
+static int ckt_on_path(struct ckt_bfs_node *q, int n, size_t b)
+{
+	for (; n >= 0; n = q[n].parent)
+		if (q[n].bucket == b)
+			return 1;
+
+	return 0;
+}
+
+/*
+ * Place a member whose key is not in the table. If both its
+ * buckets are full, make room by moving a chain of members to
+ * their other bucket, found by breadth first search. Return 1 on
+ * success, 0 if no chain was found within CKT_BFS_MAX buckets;
+ * the table is then unchanged.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key of the member to place, a copy owned by the table
+ * @val:  Val of the member to place, a copy owned by the table
+ * @hash: Hash of the key
+ */
+static int ckt_place(struct ckt *h, void *key, void *val, size_t hash)
+{
+	int i;
+	int n;
+	int head;
+	int tail;
+	int free_slot;
+	size_t alt;
+	size_t from;
+	struct ckt_bucket *fb;
+	struct ckt_bfs_node q[CKT_BFS_MAX];
+
+	/* Roots: the two candidate buckets */
+	q[0].bucket = ckt_bucket1(h, hash);
+	q[1].bucket = ckt_bucket2(h, hash);
+	q[0].parent = q[1].parent = -1;
+	q[0].pslot = q[1].pslot = -1;
+	tail = 2;
+
+	for (head = 0; head < tail; head++) {
+		free_slot = ckt_free_slot(h, q[head].bucket);
+		if (free_slot >= 0)
+			break;
+
+		/* Each member here could move to its other bucket */
+		for (i = 0; i < CKT_BUCKET_SLOTS && tail < CKT_BFS_MAX; i++) {
+			alt = ckt_alt_bucket(h,
+			      h->buckets[q[head].bucket].hash[i],
+			      q[head].bucket);
+			if (ckt_on_path(q, head, alt))
+				continue;
+			q[tail].bucket = alt;
+			q[tail].parent = head;
+			q[tail].pslot = i;
+			tail++;
+		}
+	}
+
+	if (head == tail)
+		return 0;
+
+	/* Shift the chain, starting at the free slot */
+	n = head;
+	while (q[n].parent >= 0) {
+		from = q[q[n].parent].bucket * CKT_BUCKET_SLOTS + q[n].pslot;
+		fb = &h->buckets[Ckt_b(from)];
+		ckt_set(h, q[n].bucket * CKT_BUCKET_SLOTS + free_slot,
+		        fb->key[Ckt_i(from)], h->vals[from],
+		        fb->hash[Ckt_i(from)]);
+		free_slot = q[n].pslot;
+		n = q[n].parent;
+	}
+
+	ckt_set(h, q[n].bucket * CKT_BUCKET_SLOTS + free_slot, key, val,
+	        hash);
+
+	return 1;
+}
+
+/*
+ * Double the bucket array and place every member again. If some
+ * member still does not fit, double again.
+ *
+ * @h: Pointer to the hash table structure
+ */
+static void ckt_grow(struct ckt *h)
+{
+	int placed;
+	size_t p;
+	size_t old_tot_buckets;
+	struct ckt_bucket *ob;
+	struct ckt_bucket *old_buckets;
+	void **old_vals;
+
+	old_buckets = h->buckets;
+	old_vals = h->vals;
+	old_tot_buckets = h->tot_buckets;
+
+	do {
+		h->tot_buckets *= 2;
+		ckt_alloc(h);
+
+		placed = 1;
+		for (p = 0; p < old_tot_buckets * CKT_BUCKET_SLOTS &&
+		     placed; p++) {
+			ob = &old_buckets[Ckt_b(p)];
+			if (ob->key[Ckt_i(p)] != NULL)
+				placed = ckt_place(h, ob->key[Ckt_i(p)],
+				         old_vals[p], ob->hash[Ckt_i(p)]);
+		}
+
+		if (!placed) {
+			free(h->buckets);
+			free(h->vals);
+		}
+	} while (!placed);
+
+	free(old_buckets);
+	free(old_vals);
+}
+
+/*
+ * Insert a new data to hash table. If the key is already present
+ * its val is replaced. Return 1 if a new member was inserted, 0 if
+ * a val was replaced.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to be inserted
+ * @val: Val of the data to be inserted
+ */
+int ckt_insert(struct ckt *h, void *key, void *val)
+{
+	size_t p;
+	size_t hash;
+	void *new_key;
+	void *new_val;
+
+	hash = ckt_hash_func(h, key);
+
+	/* Replace val if key is already present */
+	if (ckt_find(h, key, hash, &p)) {
+		free(h->vals[p]);
+		h->vals[p] = h->v_cpy(val);
+		return 0;
+	}
+
+	new_key = h->k_cpy(key);
+	new_val = h->v_cpy(val);
+
+	while (!ckt_place(h, new_key, new_val, hash))
+		ckt_grow(h);
+
+	h->nmemb++;
+
+	return 1;
+}
+
+/*
+ * Search for a data in hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to be searched
+ */
+int ckt_search(struct ckt *h, void *key)
+{
+	size_t p;
+
+	return ckt_find(h, key, ckt_hash_func(h, key), &p);
+}
+
+/*
+ * Get the val stored for a key. Return pointer to the val in the
+ * table (not a copy), or NULL if the key is not in the table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to get
+ */
+void *ckt_get(struct ckt *h, void *key)
+{
+	size_t p;
+
+	if (!ckt_find(h, key, ckt_hash_func(h, key), &p))
+		return NULL;
+
+	return h->vals[p];
+}
+
+/*
+ * Delete an item from hash table. Has no effect if item is not
+ * found in the hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Pointer to key of the item to delete
+ */
+void ckt_delete(struct ckt *h, void *key)
+{
+	size_t p;
+
+	if (!ckt_find(h, key, ckt_hash_func(h, key), &p))
+		return;
+
+	free(h->buckets[Ckt_b(p)].key[Ckt_i(p)]);
+	free(h->vals[p]);
+	h->buckets[Ckt_b(p)].key[Ckt_i(p)] = NULL;
+	h->vals[p] = NULL;
+
+	h->nmemb--;
+}
+
+/*
+ * Return the total members count.
+ *
+ * @h: Pointer to the hash table structure
+ */
+size_t ckt_tot_memb(struct ckt *h)
+{
+	return h->nmemb;
+}
+
+/*
+ * Destroy a hash table.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void ckt_destroy(struct ckt *h)
+{
+	size_t p;
+
+	for (p = 0; p < h->tot_buckets * CKT_BUCKET_SLOTS; p++)
+		if (h->buckets[Ckt_b(p)].key[Ckt_i(p)] != NULL) {
+			free(h->buckets[Ckt_b(p)].key[Ckt_i(p)]);
+			free(h->vals[p]);
+		}
+
+	free(h->buckets);
+	free(h->vals);
+
+	free(h);
+}
@@ -0,0 +1,338 @@
+/*
+ * dary_heap.c: Cache line aware d-ary heap with inline int64 keys
+ *
+ * St: 2026-10-17 Sat 07:49 AM
+ * Up: 2026-10-17 Sat 07:49 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * struct heap keeps an array of pointers to hp_data, each pointing
+ * to its own key and value, so every compare chases three pointers
+ * to three different allocations. This heap instead keeps int64
+ * keys inline in one array, and the values (pointers the caller
+ * owns) in a parallel array that is only touched when members move.
+ *
+ * The arity d is 4 or 8. The children of node i are d * i + 1 to
+ * d * i + d, and the key array is laid out so that every such group
+ * of children falls in one cache line: the buffer is cache line
+ * aligned and the keys start d - 1 slots into it, which puts key 1
+ * on a d * 8 byte boundary. Finding the least child is one line
+ * fetch, and is done as a small tournament of compares whose
+ * results are used as indexes, so there are no branches to mispredict
+ * on random keys. A wider node means a shallower heap: log_d(n)
+ * levels instead of log_2(n).
+ *
+ * Sifting moves a hole instead of swapping, so each level costs one
+ * key and one value store. A max heap stores the bitwise NOT of each
+ * key, which reverses the order of int64 without overflow, so the
+ * inner loops are the same for both types.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"mylib.h"
+
+#define SKIP
+#define DH_LINE 64
+
+/* Key as stored: min heaps keep it, max heaps flip its order */
+#define Dh_ord(h, k) ((h)->type == MAX_HEAP ? ~(k) : (k))
+
+/*
+ * Allocate the key buffer for cap members; set h->kbuf and h->keys.
+ *
+ * @h:   Pointer to the d-ary heap
+ * @cap: Number of members the buffer must hold
+ */
+static void dh_alloc_keys(struct dheap *h, size_t cap)
+{
+	size_t size;
+
+	size = (cap + h->arity - 1) * sizeof(int64_t);
+	size = (size + DH_LINE - 1) / DH_LINE * DH_LINE;
+
+	h->kbuf = aligned_alloc(DH_LINE, size);
+	assert(h->kbuf);
+	h->keys = h->kbuf + h->arity - 1;
+}
+
+/*
+ * Create a d-ary heap.
+ *
+ * @cap:   Initial capacity
+ * @arity: Children per node, 4 or 8
+ * @type:  MIN_HEAP or MAX_HEAP
+ */
+struct dheap *dh_create(size_t cap, int arity, char type)
+{
+	struct dheap *h;
+
+	assert(arity == 4 || arity == 8);
+	assert(type == MIN_HEAP || type == MAX_HEAP);
+
+	h = malloc(sizeof(struct dheap));
+	assert(h);
+
+	if (cap == 0)
+		cap = 1;
+
+	h->arity = arity;
+	h->type = type;
+	h->nmemb = 0;
+	h->cap = cap;
+	dh_alloc_keys(h, cap);
+	h->vals = malloc(cap * sizeof(void *));
+	assert(h->vals);
+
+	return h;
+}
+
+/*
+ * Double the capacity of a d-ary heap.
+ *
+ * @h: Pointer to the d-ary heap
+ */
+static void dh_grow(struct dheap *h)
+{
+	int64_t *old_kbuf;
+	int64_t *old_keys;
+
+	old_kbuf = h->kbuf;
+	old_keys = h->keys;
+
+	h->cap *= GROWTH_RATE;
+	dh_alloc_keys(h, h->cap);
+	memcpy(h->keys, old_keys, h->nmemb * sizeof(int64_t));
+	free(old_kbuf);
+
+	h->vals = realloc(h->vals, h->cap * sizeof(void *));
+	assert(h->vals);
+}
+
+/*
+ * Index of the least of the 4 keys starting at c, found without
+ * branches.
+ *
+ * @k: Key array
+ * @c: Index of the first child
+ */
+static inline size_t dh_min_child4(const int64_t *k, size_t c)
+{
+	size_t a;
+	size_t b;
+
+	a = c + (k[c + 1] < k[c]);
+	b = c + 2 + (k[c + 3] < k[c + 2]);
+
+	return a + (b - a) * (k[b] < k[a]);
+}
+
+/*
+ * Index of the least of the 8 keys starting at c, found without
+ * branches.
+ *
+ * @k: Key array
+ * @c: Index of the first child
+ */
+static inline size_t dh_min_child8(const int64_t *k, size_t c)
+{
+	size_t a;
+	size_t b;
+
+	a = dh_min_child4(k, c);
+	b = dh_min_child4(k, c + 4);
+
+	return a + (b - a) * (k[b] < k[a]);
+}
+
+/*
+ * Move the hole at pos up until key can be put in it.
+ *
+ * @h:   Pointer to the d-ary heap
+ * @pos: Position of the hole
+ * @key: Stored (ordered) key to place
+ * @val: Value to place
+ */
+static void dh_sift_up(struct dheap *h, size_t pos, int64_t key, void *val)
+{
+	size_t parent;
+
+	while (pos > 0) {
+		parent = (pos - 1) / h->arity;
+		if (h->keys[parent] <= key)
+			break;
+		h->keys[pos] = h->keys[parent];
+		h->vals[pos] = h->vals[parent];
+		pos = parent;
+	}
+
+	h->keys[pos] = key;
+	h->vals[pos] = val;
+}
+
+/*
+ * Move the hole at pos down until key can be put in it.
+ *
+ * @h:   Pointer to the d-ary heap
+ * @pos: Position of the hole
+ * @key: Stored (ordered) key to place
+ * @val: Value to place
+ */
+static void dh_sift_down(struct dheap *h, size_t pos, int64_t key, void *val)
+{
+	int64_t *k;
+	size_t n;
+	size_t d;
+	size_t c;
+	size_t m;
+	size_t i;
+
+	k = h->keys;
+	n = h->nmemb;
+	d = h->arity;
+
+	while ((c = d * pos + 1) < n) {
+		if (c + d <= n) {
+			/* All children present: one line, no branches */
+			if (d == 4)
+				m = dh_min_child4(k, c);
+			else
+				m = dh_min_child8(k, c);
+		} else {
+			/* Last, partly filled group */
+			m = c;
+			for (i = c + 1; i < n; i++)
+				if (k[i] < k[m])
+					m = i;
+		}
+
+		if (key <= k[m])
+			break;
+
+		k[pos] = k[m];
+		h->vals[pos] = h->vals[m];
+		pos = m;
+	}
+
+	k[pos] = key;
+	h->vals[pos] = val;
+}
+
+/*
+ * Insert a key and its value into a d-ary heap. The value is kept
+ * as given, not copied.
+ *
+ * @h:   Pointer to the d-ary heap
+ * @key: Key
+ * @val: Value
+ */
+void dh_insert(struct dheap *h, int64_t key, void *val)
+{
+	if (h->nmemb == h->cap)
+		dh_grow(h);
+
+	h->nmemb++;
+	dh_sift_up(h, h->nmemb - 1, Dh_ord(h, key), val);
+}
+
+/*
+ * Get the min/max member without removing it. Return 1, or 0 if
+ * the heap is empty.
+ *
+ * @h:   Pointer to the d-ary heap
+ * @key: Gets the key, if not NULL
+ * @val: Gets the value, if not NULL
+ */
+int dh_find_m(struct dheap *h, int64_t *key, void **val)
+{
+	if (h->nmemb == 0)
+		return 0;
+
+	if (key)
+		*key = Dh_ord(h, h->keys[0]);
+	if (val)
+		*val = h->vals[0];
+
+	return 1;
+}
+
+/*
+ * Remove the min/max member. Return 1, or 0 if the heap is empty.
+ *
+ * @h:   Pointer to the d-ary heap
+ * @key: Gets the key, if not NULL
+ * @val: Gets the value, if not NULL
+ */
+int dh_extract_m(struct dheap *h, int64_t *key, void **val)
+{
+	if (dh_find_m(h, key, val) == 0)
+		return 0;
+
+	h->nmemb--;
+	if (h->nmemb > 0)
+		dh_sift_down(h, 0, h->keys[h->nmemb], h->vals[h->nmemb]);
+
+	return 1;
+}
+
+/*
+ * Find out if a d-ary heap is empty.
+ *
+ * @h: Pointer to the d-ary heap
+ */
+int dh_is_empty(struct dheap *h)
+{
+	return h->nmemb == 0;
+}
+
+/*
+ * Get the number of members in a d-ary heap.
+ *
+ * @h: Pointer to the d-ary heap
+ */
+size_t dh_get_size(struct dheap *h)
+{
+	return h->nmemb;
+}
+
+/*
+ * Destroy a d-ary heap. Values are not freed.
+ *
+ * @h: Pointer to the d-ary heap
+ */
+void dh_destroy(struct dheap *h)
+{
+	free(h->kbuf);
+	free(h->vals);
+	free(h);
+}
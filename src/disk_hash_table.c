@@ -0,0 +1,474 @@
+/*
+ * disk_hash_table.c: Hash table dump file, read through mmap
+ *
+ * St: 2026-10-17 Sat 07:21 AM
+ * Up: 2026-10-17 Sat 08:08 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * ht_dump writes the members of a struct ht to a file laid out as
+ * described above struct dht_header in mylib.h. The file is a hash
+ * table by itself: entries are grouped by slot (hash & (tot_slots -
+ * 1)), and slot_start says where the group of each slot begins, so
+ * a lookup reads one slot_start pair and scans a few entries.
+ *
+ * Entries and blobs are referred to by file offsets, so dht_open
+ * only mmaps the file read only and checks the header. Nothing is
+ * copied or fixed up, startup cost does not depend on the table
+ * size, and processes mapping the same file share its pages in the
+ * page cache.
+ *
+ * A file may still be damaged past its header. So that a damaged
+ * file can not make a lookup read outside the mapping, dht_find
+ * checks the slot_start pair and the offsets of each entry it uses
+ * against the file size; a bad entry is taken as no match. These
+ * are a few compares on memory the lookup touches anyway.
+ *
+ * Keys are hashed with hash_key and the seed in the header, not
+ * with h->hash_func, as a reader can not call the writer's hash
+ * function. Keys are compared with memcmp of get_key_size bytes.
+ *
+ * The file is written under a temporary name and renamed, so a
+ * reader never maps a half written file.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+#define Dht_align(x)  (((x) + 7) & ~(uint64_t) 7)
+
+/* Space for a blob and at least one 0 byte after it */
+#define Dht_blob_size(len)  Dht_align((uint64_t) (len) + 1)
+
+/* A member of the table being dumped */
+struct dht_rec {
+	void *key;
+	void *val;
+	uint64_t hash;
+	uint32_t key_len;
+	uint32_t val_len;
+};
+
+/*
+ * Add all members of a table to `recs', in the order ht_find looks
+ * at them. Return the new member count.
+ *
+ * @recs:      Array to add to
+ * @n:         Members already in the array
+ * @table:     Table of linked lists
+ * @tot_slots: Total slots in table
+ */
+static size_t dht_collect(struct dht_rec *recs, size_t n, struct ll **table,
+                          size_t tot_slots)
+{
+	size_t i;
+	struct ll_node *lln;
+	struct ht_data *data;
+
+	for (i = 0; i < tot_slots; i++) {
+		if (table[i] == NULL)
+			continue;
+		for (lln = table[i]->head; lln != NULL; lln = lln->next) {
+			data = (struct ht_data *) lln->val;
+			recs[n].key = data->key;
+			recs[n].val = data->val;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+/*
+ * Return 1 if two members have the same key.
+ *
+ * @a: First member
+ * @b: Second member
+ */
+static int dht_rec_eq(struct dht_rec *a, struct dht_rec *b)
+{
+	return a->hash == b->hash && a->key_len == b->key_len &&
+	       memcmp(a->key, b->key, a->key_len) == 0;
+}
+
+/*
+ * Write `len' bytes and the 0 bytes padding them to
+ * Dht_blob_size(len). Return 0 on success, -1 on error.
+ *
+ * @fp:   File to write to
+ * @blob: Bytes to write
+ * @len:  Number of bytes
+ */
+static int dht_write_blob(FILE *fp, const void *blob, uint32_t len)
+{
+	static const char zero[8];
+
+	if (len > 0 && fwrite(blob, len, 1, fp) != 1)
+		return -1;
+
+	if (fwrite(zero, Dht_blob_size(len) - len, 1, fp) != 1)
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Write members of a hash table to a dump file, to be read with
+ * dht_open. Where `h' holds a key more than once, the val ht_get
+ * would return is written. Return 0 on success, -1 if the file
+ * could not be written.
+ *
+ * @h:            Pointer to the hash table structure
+ * @path:         Path of the file to write
+ * @get_val_size: Function to get val size
+ */
+int ht_dump(struct ht *h, const char *path, int (*get_val_size)(void *))
+{
+	int retval;
+	size_t i;
+	size_t j;
+	size_t n;
+	size_t slot;
+	size_t nkept;
+	size_t first;
+	uint64_t off;
+	uint64_t *slot_start;
+	char *tmp_path;
+	FILE *fp;
+	struct dht_rec *recs;
+	struct dht_rec *sorted;
+	struct dht_entry entry;
+	struct dht_header hdr;
+
+	recs = malloc((h->nmemb + 1) * sizeof(struct dht_rec));
+	sorted = malloc((h->nmemb + 1) * sizeof(struct dht_rec));
+	assert(recs && sorted);
+
+	/* Newer members are in new_table, take them first */
+	n = 0;
+	if (h->rehash_idx >= 0)
+		n = dht_collect(recs, n, h->new_table, h->new_tot_slots);
+	n = dht_collect(recs, n, h->table, h->tot_slots);
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, DHT_MAGIC, sizeof(hdr.magic));
+	hdr.seed = HASH_SEED;
+	hdr.tot_slots = 1;
+	while (hdr.tot_slots < n)
+		hdr.tot_slots *= 2;
+
+	slot_start = calloc(hdr.tot_slots + 1, sizeof(uint64_t));
+	assert(slot_start);
+
+	/* Group by slot, keeping the order found in (counting sort) */
+	for (i = 0; i < n; i++) {
+		recs[i].key_len = h->get_key_size(recs[i].key);
+		recs[i].val_len = get_val_size(recs[i].val);
+		recs[i].hash = hash_key(recs[i].key, recs[i].key_len, hdr.seed);
+		slot_start[(recs[i].hash & (hdr.tot_slots - 1)) + 1]++;
+	}
+	for (slot = 0; slot < hdr.tot_slots; slot++)
+		slot_start[slot + 1] += slot_start[slot];
+	for (i = 0; i < n; i++)
+		sorted[slot_start[recs[i].hash & (hdr.tot_slots - 1)]++] =
+		recs[i];
+
+	/*
+	 * Drop later duplicates; they are all in one slot. Turn
+	 * slot_start, now the end of every slot, into its start.
+	 */
+	nkept = 0;
+	i = 0;
+	for (slot = 0; slot < hdr.tot_slots; slot++) {
+		first = nkept;
+		for (; i < slot_start[slot]; i++) {
+			for (j = first; j < nkept; j++)
+				if (dht_rec_eq(&recs[j], &sorted[i]))
+					break;
+			if (j == nkept)
+				recs[nkept++] = sorted[i];
+		}
+		slot_start[slot] = first;
+	}
+	slot_start[hdr.tot_slots] = nkept;
+	free(sorted);
+
+	hdr.nmemb = nkept;
+	/* Header is 7 * 8 bytes, so slot_start is aligned */
+	hdr.slots_off = sizeof(struct dht_header);
+	hdr.entries_off = hdr.slots_off +
+	                  (hdr.tot_slots + 1) * sizeof(uint64_t);
+	off = hdr.entries_off + nkept * sizeof(struct dht_entry);
+	for (i = 0; i < nkept; i++)
+		off += Dht_blob_size(recs[i].key_len) +
+		       Dht_blob_size(recs[i].val_len);
+	hdr.file_size = off;
+
+	tmp_path = malloc(strlen(path) + sizeof(".tmp"));
+	assert(tmp_path);
+	sprintf(tmp_path, "%s.tmp", path);
+
+	retval = -1;
+	fp = fopen(tmp_path, "wb");
+	if (fp == NULL)
+		goto out;
+
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    fwrite(slot_start, sizeof(uint64_t), hdr.tot_slots + 1, fp) !=
+	    hdr.tot_slots + 1)
+		goto out_close;
+
+	/* Entries, with offsets of blobs written after them */
+	off = hdr.entries_off + nkept * sizeof(struct dht_entry);
+	for (i = 0; i < nkept; i++) {
+		memset(&entry, 0, sizeof(entry));
+		entry.hash = recs[i].hash;
+		entry.key_len = recs[i].key_len;
+		entry.val_len = recs[i].val_len;
+		entry.key_off = off;
+		off += Dht_blob_size(entry.key_len);
+		entry.val_off = off;
+		off += Dht_blob_size(entry.val_len);
+		if (fwrite(&entry, sizeof(entry), 1, fp) != 1)
+			goto out_close;
+	}
+
+	for (i = 0; i < nkept; i++)
+		if (dht_write_blob(fp, recs[i].key, recs[i].key_len) != 0 ||
+		    dht_write_blob(fp, recs[i].val, recs[i].val_len) != 0)
+			goto out_close;
+
+	if (fclose(fp) == 0 && rename(tmp_path, path) == 0)
+		retval = 0;
+	fp = NULL;
+
+out_close:
+	if (fp != NULL)
+		fclose(fp);
+	if (retval != 0)
+		remove(tmp_path);
+out:
+	free(tmp_path);
+	free(slot_start);
+	free(recs);
+
+	return retval;
+}
+
+/*
+ * Map a file written by ht_dump. Return NULL if the file can not be
+ * opened or mapped, or is not a dump file.
+ *
+ * @path:         Path of the file
+ * @get_key_size: Function to get key size, same as the dumped
+ *                table's
+ */
+struct dht *dht_open(const char *path, int (*get_key_size)(void *))
+{
+	int fd;
+	void *map;
+	struct stat st;
+	struct dht *d;
+	const struct dht_header *hdr;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) != 0 ||
+	    (size_t) st.st_size < sizeof(struct dht_header)) {
+		close(fd);
+		return NULL;
+	}
+
+	/* The mapping stays valid after closing fd */
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	/*
+	 * Check header, so the slot index and entries are inside the
+	 * file. Sizes are checked against the file size before they
+	 * are multiplied, so nothing can overflow.
+	 */
+	hdr = map;
+	if (memcmp(hdr->magic, DHT_MAGIC, sizeof(hdr->magic)) != 0 ||
+	    hdr->file_size != (uint64_t) st.st_size ||
+	    hdr->tot_slots == 0 ||
+	    (hdr->tot_slots & (hdr->tot_slots - 1)) != 0 ||
+	    hdr->tot_slots >= hdr->file_size / sizeof(uint64_t) ||
+	    hdr->nmemb > hdr->file_size / sizeof(struct dht_entry) ||
+	    hdr->slots_off % 8 != 0 || hdr->entries_off % 8 != 0 ||
+	    hdr->slots_off < sizeof(struct dht_header) ||
+	    hdr->slots_off > hdr->entries_off ||
+	    hdr->entries_off > hdr->file_size ||
+	    (hdr->tot_slots + 1) * sizeof(uint64_t) >
+	    hdr->entries_off - hdr->slots_off ||
+	    hdr->nmemb * sizeof(struct dht_entry) >
+	    hdr->file_size - hdr->entries_off) {
+		munmap(map, st.st_size);
+		return NULL;
+	}
+
+	d = malloc(sizeof(struct dht));
+	assert(d);
+
+	d->map = map;
+	d->map_size = st.st_size;
+	d->hdr = hdr;
+	d->slot_start = (const uint64_t *) (d->map + hdr->slots_off);
+	d->entries = (const struct dht_entry *) (d->map + hdr->entries_off);
+	d->get_key_size = get_key_size;
+
+	return d;
+}
+
+/*
+ * Return 1 if a blob of len bytes at off, and the 0 byte after it,
+ * are inside the mapped file.
+ *
+ * @d:   Pointer to the disk hash table structure
+ * @off: File offset of the blob
+ * @len: Size of the blob
+ */
+static int dht_blob_ok(struct dht *d, uint64_t off, uint64_t len)
+{
+	return off < d->map_size && len < d->map_size - off &&
+	       d->map[off + len] == 0;
+}
+
+/*
+ * Find entry of a key. Return pointer to it in the mapping, or NULL
+ * if the key is not in the table. Entries pointing outside the
+ * file are skipped.
+ *
+ * @d:   Pointer to the disk hash table structure
+ * @key: Key to find
+ */
+static const struct dht_entry *dht_find(struct dht *d, void *key)
+{
+	uint32_t len;
+	uint64_t i;
+	uint64_t start;
+	uint64_t end;
+	uint64_t hash;
+	uint64_t slot;
+	const struct dht_entry *e;
+
+	len = d->get_key_size(key);
+	hash = hash_key(key, len, d->hdr->seed);
+	slot = hash & (d->hdr->tot_slots - 1);
+
+	start = d->slot_start[slot];
+	end = d->slot_start[slot + 1];
+	if (start > end || end > d->hdr->nmemb)
+		return NULL;
+
+	for (i = start; i < end; i++) {
+		e = &d->entries[i];
+		if (e->hash == hash && e->key_len == len &&
+		    dht_blob_ok(d, e->key_off, len) &&
+		    memcmp(d->map + e->key_off, key, len) == 0 &&
+		    dht_blob_ok(d, e->val_off, e->val_len))
+			return e;
+	}
+
+	return NULL;
+}
+
+/*
+ * Search for a data in disk hash table.
+ *
+ * @d:   Pointer to the disk hash table structure
+ * @key: key of the data to be searched
+ */
+int dht_search(struct dht *d, void *key)
+{
+	int retval;
+
+	if (dht_find(d, key) != NULL)
+		retval = 1;
+	else
+		retval = 0;
+
+	return retval;
+}
+
+/*
+ * Get the val stored for a key. Return pointer to the val bytes in
+ * the mapping, followed by a 0 byte, or NULL if the key is not in
+ * the table. Valid until dht_close.
+ *
+ * @d:   Pointer to the disk hash table structure
+ * @key: key of the data to get
+ */
+const void *dht_get(struct dht *d, void *key)
+{
+	const struct dht_entry *e;
+
+	e = dht_find(d, key);
+	if (e == NULL)
+		return NULL;
+
+	return d->map + e->val_off;
+}
+
+/*
+ * Return the total members count.
+ *
+ * @d: Pointer to the disk hash table structure
+ */
+size_t dht_tot_memb(struct dht *d)
+{
+	return d->hdr->nmemb;
+}
+
+/*
+ * Unmap a disk hash table.
+ *
+ * @d: Pointer to the disk hash table structure
+ */
+void dht_close(struct dht *d)
+{
+	munmap((void *) d->map, d->map_size);
+
+	free(d);
+}
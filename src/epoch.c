@@ -0,0 +1,349 @@
+/*
+ * epoch.c: Epoch based memory reclamation
+ *
+ * St: 2026-10-17 Sat 07:12 AM
+ * Up: 2026-10-17 Sat 08:40 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * Every thread using an ebr gets a record (found through a pthread
+ * key) the first time it enters. On entering, the thread copies the
+ * global epoch into its record; on leaving it stores EBR_IDLE.
+ * Neither does an atomic read-modify-write. Records are cache line
+ * aligned and the epoch word has its line to itself, so threads
+ * entering and leaving never write to a line another thread writes.
+ *
+ * The announcement must be visible before the thread's first shared
+ * read. A full fence in ebr_enter would do, but it is a locked
+ * instruction on x86, paid on every read. Instead the fence is made
+ * asymmetric, as in userspace RCU: readers only keep the compiler
+ * from reordering, and the thread advancing the epoch, which is
+ * rare, calls membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED). That
+ * runs a full barrier on every running thread of the process
+ * before the records are read, so a reader's announcement is seen,
+ * or its reads come after the barrier and so after the unlink that
+ * was retired. Where membarrier is missing (not Linux, or an old
+ * kernel), ebr_enter falls back to the full fence.
+ *
+ * A writer that unlinks a node retires it, tagged with the global
+ * epoch at that time. The global epoch moves from g to g + 1 only
+ * when every thread inside a critical section has announced g. So
+ * once the global epoch is tag + 2, every thread that was inside a
+ * critical section when the node was unlinked has left, and the node
+ * can be freed.
+ *
+ * Retired nodes stay in the retiring thread's own limbo lists (one
+ * per epoch % 3), so retiring needs no shared state. Every
+ * EBR_ADVANCE_FREQ retires the thread tries to advance the global
+ * epoch and frees what has become safe.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<stdatomic.h>
+#include<pthread.h>
+#ifdef __linux__
+#include<unistd.h>
+#include<sys/syscall.h>
+#include<linux/membarrier.h>
+#endif
+
+#include"mylib.h"
+
+#define SKIP
+
+/*
+ * Register the process for private expedited membarrier. Return 1
+ * if it can be used, else 0.
+ */
+static int ebr_membarrier_init(void)
+{
+#if defined(__linux__) && defined(__NR_membarrier)
+	long cmds;
+
+	cmds = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+	if (cmds < 0 ||
+	    !(cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) ||
+	    !(cmds & MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED))
+		return 0;
+
+	return syscall(__NR_membarrier,
+	               MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Run a full memory barrier on every running thread of the process.
+ * Only called once ebr_membarrier_init returned 1.
+ */
+static void ebr_membarrier(void)
+{
+#if defined(__linux__) && defined(__NR_membarrier)
+	if (syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED,
+	            0, 0) == 0)
+		return;
+#endif
+	/* Can not happen once registered */
+	assert(0);
+}
+
+/*
+ * Create an epoch based reclamation domain.
+ */
+struct ebr *ebr_create(void)
+{
+	struct ebr *e;
+
+	e = malloc(sizeof(struct ebr));
+	assert(e);
+
+	atomic_init(&e->epoch, 0);
+	atomic_init(&e->threads, NULL);
+	e->asym = ebr_membarrier_init();
+
+	if (pthread_key_create(&e->key, NULL) != 0)
+		assert(0);
+
+	return e;
+}
+
+/*
+ * Return record of the calling thread, registering it if this is
+ * the first call from the thread.
+ *
+ * @e: Pointer to the ebr structure
+ */
+static struct ebr_thread *ebr_self(struct ebr *e)
+{
+	int i;
+	struct ebr_thread *t;
+	struct ebr_thread *head;
+
+	t = pthread_getspecific(e->key);
+	if (t != NULL)
+		return t;
+
+	/* A cache line of its own, see struct ebr_thread */
+	t = aligned_alloc(EBR_LINE, (sizeof(struct ebr_thread) + EBR_LINE - 1) /
+	                  EBR_LINE * EBR_LINE);
+	assert(t);
+
+	atomic_init(&t->epoch, EBR_IDLE);
+	t->depth = 0;
+	for (i = 0; i < 3; i++) {
+		t->limbo[i].head = NULL;
+		t->limbo[i].epoch = 0;
+	}
+	t->nretired = 0;
+
+	/* Push to registry */
+	head = atomic_load(&e->threads);
+	do {
+		t->next = head;
+	} while (!atomic_compare_exchange_weak(&e->threads, &head, t));
+
+	pthread_setspecific(e->key, t);
+
+	return t;
+}
+
+/*
+ * Enter a critical section. Shared nodes read from here on are not
+ * freed before the matching ebr_exit. Sections may nest; only the
+ * outermost one announces an epoch.
+ *
+ * @e: Pointer to the ebr structure
+ */
+void ebr_enter(struct ebr *e)
+{
+	struct ebr_thread *t;
+
+	t = ebr_self(e);
+	if (t->depth++ > 0)
+		return;
+
+	atomic_store_explicit(&t->epoch,
+	                      atomic_load_explicit(&e->epoch,
+	                                           memory_order_relaxed),
+	                      memory_order_relaxed);
+
+	/*
+	 * Announcement must be visible before any shared read. With
+	 * membarrier the advancer enforces that, and only the compiler
+	 * must be kept from moving reads up.
+	 */
+	if (e->asym)
+		atomic_signal_fence(memory_order_seq_cst);
+	else
+		atomic_thread_fence(memory_order_seq_cst);
+}
+
+/*
+ * Leave a critical section. The thread goes idle only when it
+ * leaves the outermost one.
+ *
+ * @e: Pointer to the ebr structure
+ */
+void ebr_exit(struct ebr *e)
+{
+	struct ebr_thread *t;
+
+	t = pthread_getspecific(e->key);
+	assert(t->depth > 0);
+	if (--t->depth > 0)
+		return;
+
+	atomic_store_explicit(&t->epoch, EBR_IDLE, memory_order_release);
+}
+
+/*
+ * Free all pointers in a limbo list.
+ *
+ * @limbo: Limbo list to free
+ */
+static void ebr_free_limbo(struct ebr_limbo *limbo)
+{
+	struct ebr_node *n;
+	struct ebr_node *next;
+
+	for (n = limbo->head; n != NULL; n = next) {
+		next = n->next;
+		n->fn(n->ptr);
+		free(n);
+	}
+
+	limbo->head = NULL;
+}
+
+/*
+ * Advance the global epoch if every thread inside a critical section
+ * has announced the current one.
+ *
+ * @e: Pointer to the ebr structure
+ */
+static void ebr_try_advance(struct ebr *e)
+{
+	uint64_t cur;
+	uint64_t epoch;
+	struct ebr_thread *t;
+
+	/* Pairs with ebr_enter: see every announcement made so far */
+	if (e->asym)
+		ebr_membarrier();
+	else
+		atomic_thread_fence(memory_order_seq_cst);
+
+	cur = atomic_load(&e->epoch);
+
+	for (t = atomic_load(&e->threads); t != NULL; t = t->next) {
+		epoch = atomic_load(&t->epoch);
+		if (epoch != EBR_IDLE && epoch != cur)
+			return;
+	}
+
+	/* Someone else may have advanced it already, that is fine */
+	atomic_compare_exchange_strong(&e->epoch, &cur, cur + 1);
+}
+
+/*
+ * Retire a pointer unlinked from a shared structure. It is freed with
+ * `fn' once no thread can still be reading it. Must be called inside
+ * a critical section.
+ *
+ * @e:   Pointer to the ebr structure
+ * @ptr: Pointer to retire
+ * @fn:  Function to free it
+ */
+void ebr_retire(struct ebr *e, void *ptr, void (*fn)(void *))
+{
+	int i;
+	uint64_t epoch;
+	struct ebr_node *n;
+	struct ebr_limbo *limbo;
+	struct ebr_thread *t;
+
+	t = ebr_self(e);
+
+	n = malloc(sizeof(struct ebr_node));
+	assert(n);
+	n->ptr = ptr;
+	n->fn = fn;
+
+	epoch = atomic_load(&e->epoch);
+	limbo = &t->limbo[epoch % 3];
+
+	/* An older list in this slot is at least 3 epochs old: safe */
+	if (limbo->epoch != epoch) {
+		ebr_free_limbo(limbo);
+		limbo->epoch = epoch;
+	}
+
+	n->next = limbo->head;
+	limbo->head = n;
+
+	if (++t->nretired < EBR_ADVANCE_FREQ)
+		return;
+
+	t->nretired = 0;
+	ebr_try_advance(e);
+
+	epoch = atomic_load(&e->epoch);
+	for (i = 0; i < 3; i++)
+		if (t->limbo[i].epoch + 2 <= epoch)
+			ebr_free_limbo(&t->limbo[i]);
+}
+
+/*
+ * Destroy an ebr, freeing everything still retired. No thread may be
+ * inside a critical section.
+ *
+ * @e: Pointer to the ebr structure
+ */
+void ebr_destroy(struct ebr *e)
+{
+	int i;
+	struct ebr_thread *t;
+	struct ebr_thread *next;
+
+	for (t = atomic_load(&e->threads); t != NULL; t = next) {
+		next = t->next;
+		for (i = 0; i < 3; i++)
+			ebr_free_limbo(&t->limbo[i]);
+		free(t);
+	}
+
+	pthread_key_delete(e->key);
+
+	free(e);
+}
@@ -2,7 +2,7 @@
  * src/graph.c:
  *
  * St: 2016-10-01 Sat 06:24 PM
- * Up: 2016-10-05 Wed 01:47 AM
+ * Up: 2026-10-17 Sat 08:10 AM
  *
  * Author: SPS
  * 
@@ -52,7 +52,7 @@ static void dfs_process_cur(struct graph *g,
 static void *dfs_cpy_edge(void *val);
 static void graph_destroy_edge(void *edge);
 static struct graph_edge *graph_create_edge(int src, int sink);
-static void init_priq(struct graph *g, struct heap *priq, int src);
+static struct heap *init_priq(struct graph *g, int src);
 void djk_relax(struct hp_data *par, int vtx, struct heap *priq);
 void release_dijkstra_search_setup(struct heap *priq, int *visited, int *dist);
 void init_dijkstra_search(struct graph *g, struct heap **priqp,
@@ -398,7 +398,11 @@ int graph_dijkstra(struct graph *g, void *src, void *dest)
 	int *visited;
 	int *dist;
 	void *ll_itr;
-	struct hp_data *cur;
+	const void *key;
+	const void *val;
+	int cur_dist;
+	int cur_vtx;
+	struct hp_data cur;
 
 	/* Change labels to int equivalent if needed */
 	isrc = conv_label_to_int(g, src);
@@ -409,26 +413,29 @@ int graph_dijkstra(struct graph *g, void *src, void *dest)
 
 	/* While queue is not empty */
 	while (!hp_is_empty(priq)) {
-		/* Get node with min dist in priq */
-		cur = hp_extract_m(priq);
+		/* Get node with min dist in priq, without copying it */
+		hp_peek_ref(priq, &key, &val);
+		cur_dist = *(const int *)key;
+		cur_vtx = *(const int *)val;
+		hp_pop_into(priq, NULL, NULL);
+		cur.key = &cur_dist;
+		cur.val = &cur_vtx;
+
 		/* Mark it as visited */
-		visited[*(int *)cur->val] = 1;
+		visited[cur_vtx] = 1;
 		/* Record its distance - it is the minimum distance */
-		if (*(int *)cur->key != DJK_INF)
-			dist[*(int *)cur->val] = *(int *)cur->key;
+		if (cur_dist != DJK_INF)
+			dist[cur_vtx] = cur_dist;
 
 		/* for all neighbors of cur */
-		ll_itr = ll_first(g->alist[*(int *)cur->val]->l);
+		ll_itr = ll_first(g->alist[cur_vtx]->l);
 		while (!ll_done(ll_itr)) {
-			nbr_vtx = ll_next(g->alist[*(int *)cur->val]->l, &ll_itr);
+			nbr_vtx = ll_next(g->alist[cur_vtx]->l, &ll_itr);
 			/* if not already visited */
 			if (visited[*(int *)nbr_vtx] == 0)
-				djk_relax(cur, *(int *)nbr_vtx, priq);
+				djk_relax(&cur, *(int *)nbr_vtx, priq);
 			free(nbr_vtx); 
 		}
-		dval_i(cur->val);
-		dval_i(cur->key);
-		free(cur);
 	}
 
 	/* Update retval to show distance */
@@ -713,9 +720,7 @@ void init_dijkstra_search(struct graph *g, struct heap **priqp,
 	int i;
 
 	/* Create and initialize priority queue */
-	*priqp = hp_create(g->nvert, MIN_HEAP,
-			   cpy_i, cpy_i, cmp_i, cmp_i, dval_i, dval_i);
-	init_priq(g, *priqp, src);
+	*priqp = init_priq(g, src);
 
 	/* Create and initiallize visited array */
 	*visitedp = calloc(g->nvert , sizeof(int));
@@ -755,8 +760,10 @@ void djk_relax(struct hp_data *par, int vtx, struct heap *priq)
 	int old_dist;
 	int new_dist;
 
-	/* Get the index of node in priq heap */
-	idx = hp_get_index_val(priq, &vtx);
+	/* Handle of a vertex is the vertex number, see init_priq */
+	idx = hp_get_pos(priq, vtx);
+	if (idx < 0)
+		return;
 
 	/* Get old distance and new distance */
 	old_dist = *(int *)(priq->hparr[idx]->key);
@@ -770,42 +777,33 @@ void djk_relax(struct hp_data *par, int vtx, struct heap *priq)
 
 
 /*
- * Initialize priority queue for Dijkstras search
+ * Create the priority queue for Dijkstras search, holding every
+ * vertex, in one O(nvert) heapify. Vertex i gets handle i, which
+ * djk_relax relies on. Distances and vertex numbers are two plain
+ * int arrays, which the queue takes over whole.
  *
  * @g:    Pointer to the graph structure
- * @priq: Pointer to priority queue
  * @src:  Source vertex for search 
  */
-static void init_priq(struct graph *g, struct heap *priq, int src)
+static struct heap *init_priq(struct graph *g, int src)
 {
 	int i;
-	int key;
-	int val;
-
-	/*
-	 * Put each vertex into queue
-	 */
-
-	/* All vertex whose vtx num is less than src */
-	for (i = 0; i < src; i++) {
-		val = i;
-		key = DJK_INF;
-		hp_insert(priq, &key, &val);
-	}
+	int *keys;
+	int *vals;
 
-	/* Src vertex */
-	val = src;
-	key = 0;
-	hp_insert(priq, &key, &val);
+	keys = malloc(g->nvert * sizeof(int));
+	vals = malloc(g->nvert * sizeof(int));
+	assert(keys && vals);
 
-	/* All vertex whose vtx num is more than src */
 	for (i = 0; i < g->nvert; i++) {
-		val = i;
-		key = DJK_INF;
-		hp_insert(priq, &key, &val);
+		keys[i] = (i == src) ? 0 : DJK_INF;
+		vals[i] = i;
 	}
-}
 
+	return hp_build_block(g->nvert, MIN_HEAP, keys, sizeof(int),
+	                      vals, sizeof(int), g->nvert,
+	                      cpy_i, cpy_i, cmp_i, cmp_i, dval_i, dval_i);
+}
 
 /*
  * Important design TODO:
@@ -0,0 +1,260 @@
+/*
+ * hash.c: Seeded hash functions shared by the hash tables
+ *
+ * St: 2026-10-17 Sat 07:05 AM
+ * Up: 2026-10-17 Sat 07:05 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * hash_bytes() follows wyhash (Wang Yi, public domain): input is
+ * consumed 8 or 16 bytes at a time and mixed with a 64x64->128 bit
+ * multiply whose two halves are folded together ("mum"). Every
+ * output bit depends on every input bit, and byte order matters,
+ * so "ab" and "ba" hash differently.
+ *
+ * hash_u32() and hash_u64() are fast paths for int sized keys; they
+ * skip the length dispatch and do two multiplies. hash_key() picks
+ * the fast path by key size, so hash tables should call hash_key().
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/* wyhash secret constants */
+static const uint64_t hash_p0 = 0xa0761d6478bd642fULL;
+static const uint64_t hash_p1 = 0xe7037ed1a0b428dbULL;
+static const uint64_t hash_p2 = 0x8ebc6af09c88c6e3ULL;
+static const uint64_t hash_p3 = 0x589965cc75374cc3ULL;
+
+/*
+ * Multiply a and b to 128 bits. Low half is left in *a, high half
+ * in *b.
+ *
+ * @a: Pointer to first operand
+ * @b: Pointer to second operand
+ */
+static void hash_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+	__extension__ unsigned __int128 r;
+
+	r = *a;
+	r *= *b;
+	*a = (uint64_t) r;
+	*b = (uint64_t) (r >> 64);
+#else
+	uint64_t ha, hb, la, lb;
+	uint64_t rh, rm0, rm1, rl, t, lo;
+	int c;
+
+	ha = *a >> 32;
+	hb = *b >> 32;
+	la = (uint32_t) *a;
+	lb = (uint32_t) *b;
+
+	rh = ha * hb;
+	rm0 = ha * lb;
+	rm1 = hb * la;
+	rl = la * lb;
+
+	t = rl + (rm0 << 32);
+	c = t < rl;
+	lo = t + (rm1 << 32);
+	c += lo < t;
+
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/*
+ * Multiply a and b to 128 bits and fold the halves together.
+ *
+ * @a: First operand
+ * @b: Second operand
+ */
+static uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+	hash_mum(&a, &b);
+
+	return a ^ b;
+}
+
+/* Read 8 bytes */
+static uint64_t hash_r8(const unsigned char *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, 8);
+
+	return v;
+}
+
+/* Read 4 bytes */
+static uint64_t hash_r4(const unsigned char *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, 4);
+
+	return v;
+}
+
+/* Read 1 to 3 bytes */
+static uint64_t hash_r3(const unsigned char *p, size_t k)
+{
+	return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) |
+	       p[k - 1];
+}
+
+/*
+ * Hash `len' bytes of key with seed.
+ *
+ * @key:  Pointer to bytes to hash
+ * @len:  Number of bytes
+ * @seed: Seed. Different seeds give unrelated hash values.
+ */
+uint64_t hash_bytes(const void *key, size_t len, uint64_t seed)
+{
+	const unsigned char *p;
+	uint64_t a;
+	uint64_t b;
+	uint64_t see1;
+	uint64_t see2;
+	size_t i;
+
+	p = (const unsigned char *) key;
+
+	seed ^= hash_mix(seed ^ hash_p0, hash_p1);
+
+	if (len <= 16) {
+		if (len >= 4) {
+			a = (hash_r4(p) << 32) | hash_r4(p + ((len >> 3) << 2));
+			b = (hash_r4(p + len - 4) << 32) |
+			    hash_r4(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = hash_r3(p, len);
+			b = 0;
+		} else {
+			a = 0;
+			b = 0;
+		}
+	} else {
+		i = len;
+		if (i > 48) {
+			see1 = seed;
+			see2 = seed;
+			do {
+				seed = hash_mix(hash_r8(p) ^ hash_p1,
+				                hash_r8(p + 8) ^ seed);
+				see1 = hash_mix(hash_r8(p + 16) ^ hash_p2,
+				                hash_r8(p + 24) ^ see1);
+				see2 = hash_mix(hash_r8(p + 32) ^ hash_p3,
+				                hash_r8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = hash_mix(hash_r8(p) ^ hash_p1,
+			                hash_r8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = hash_r8(p + i - 16);
+		b = hash_r8(p + i - 8);
+	}
+
+	a ^= hash_p1;
+	b ^= seed;
+	hash_mum(&a, &b);
+
+	return hash_mix(a ^ hash_p0 ^ len, b ^ hash_p1);
+}
+
+/*
+ * Hash a 64 bit integer with seed.
+ *
+ * @key:  Integer to hash
+ * @seed: Seed
+ */
+uint64_t hash_u64(uint64_t key, uint64_t seed)
+{
+	uint64_t a;
+	uint64_t b;
+
+	a = key ^ hash_p0;
+	b = seed ^ hash_p1;
+	hash_mum(&a, &b);
+
+	return hash_mix(a ^ hash_p0, b ^ hash_p1);
+}
+
+/*
+ * Hash a 32 bit integer with seed.
+ *
+ * @key:  Integer to hash
+ * @seed: Seed
+ */
+uint64_t hash_u32(uint32_t key, uint64_t seed)
+{
+	return hash_u64(((uint64_t) key << 32) | key, seed);
+}
+
+/*
+ * Hash a key, using the integer fast paths for 4 and 8 byte keys.
+ *
+ * @key:  Pointer to key
+ * @len:  Size of key in bytes
+ * @seed: Seed
+ */
+uint64_t hash_key(const void *key, size_t len, uint64_t seed)
+{
+	uint32_t k4;
+	uint64_t k8;
+
+	switch (len) {
+	case 4:
+		memcpy(&k4, key, 4);
+		return hash_u32(k4, seed);
+	case 8:
+		memcpy(&k8, key, 8);
+		return hash_u64(k8, seed);
+	default:
+		return hash_bytes(key, len, seed);
+	}
+}
@@ -2,7 +2,7 @@
  * ht.c: Hash table implementaion in C
  *
  * St: 2016-09-27 Tue 01:23 PM
- * Up: 2016-09-27 Tue 11:22 PM
+ * Up: 2026-10-17 Sat 08:37 AM
  *
  * Author: SPS
  *
@@ -34,11 +34,34 @@
 #include<stdlib.h>
 #include<string.h>
 #include<assert.h>
+#include<pthread.h>
 
 #include"mylib.h"
 
 #define SKIP
 
+/* Prefetch for read, a no-op where the builtin is missing */
+#ifdef __GNUC__
+#define Ht_prefetch(p) __builtin_prefetch((p), 0, 3)
+#else
+#define Ht_prefetch(p) ((void) (p))
+#endif
+
+/* Round up to a multiple of 8 */
+#define Ht_align8(n) (((n) + 7) & ~(size_t) 7)
+
+/*
+ * Bump an operation counter of a table, only if built with HT_STATS.
+ * Not while a walk is running, as ht_parallel_for_each may look up
+ * from many threads.
+ */
+#ifdef HT_STATS
+#define Ht_count(h, field) ((h)->walkers == 0 ? (void) (h)->field++ \
+                                              : (void) 0)
+#else
+#define Ht_count(h, field) ((void) 0)
+#endif
+
 /*
  * Different hash table types
  */
@@ -47,6 +70,32 @@
 #define KSTR_VINT 12      /* str key and int val */
 #define KSTR_VSTR 13      /* str key and str val */
 
+/* Share of an ht_parallel_for_each scan done by one thread */
+struct ht_scan_work {
+	struct ht *h;
+	int worker;                        /* index of the worker */
+	int nthreads;                      /* total workers */
+	void (*fn) (void *, void *, void *, int);
+	void *arg;                         /* passed on to fn */
+};
+
+/* Share of an ht_build_bulk done by one thread */
+struct ht_bulk_work {
+	struct ht *h;
+	void **keys;                       /* keys to load */
+	void **vals;                       /* vals to load */
+	size_t *hash;                      /* hashes of keys */
+	size_t *perm;                      /* key indexes by partition */
+	size_t *counts;                    /* nthreads * nparts counts,
+	                                      then scatter offsets */
+	size_t *part_off;                  /* nparts + 1 start offsets */
+	size_t n;                          /* total keys */
+	size_t nparts;                     /* total partitions */
+	int shift;                         /* slot >> shift = partition */
+	int worker;                        /* index of the worker */
+	int nthreads;                      /* total workers */
+};
+
 /*
  * Structure which contains a pointer to hash table,
  * and pointer to ht_data.
@@ -73,6 +122,95 @@ static void ht_ll_dval(void *val)
 	free(data);
 }
 
+/*
+ * Destroy a val in hash table linked list node, when its key is in
+ * the table's arena and must not be freed.
+ *
+ * @val: Val of a node in hash table linked list
+ */
+static void ht_ll_dval_arena(void *val)
+{
+	struct ht_data *data;
+
+	data = (struct ht_data *) val;
+
+	free(data->val);
+
+	free(data);
+}
+
+/*
+ * Return the arena header of a key stored in an arena.
+ *
+ * @key: Key stored in an arena
+ */
+static struct ht_arena_key *ht_arena_hdr(void *key)
+{
+	return (struct ht_arena_key *) key - 1;
+}
+
+/*
+ * Copy a key into the arena of a hash table, followed by a 0 byte.
+ * A key too big for a chunk gets a chunk of its own. Return
+ * pointer to the copy.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key to copy
+ * @hash: Hash of the key
+ */
+static void *ht_arena_key_cpy(struct ht *h, void *key, size_t hash)
+{
+	size_t len;
+	size_t need;
+	struct ht_arena *a;
+	struct ht_arena_chunk *c;
+	struct ht_arena_key *hdr;
+
+	a = h->arena;
+	len = h->get_key_size(key);
+	/* One more byte, so str keys stay 0 terminated */
+	need = Ht_align8(sizeof(struct ht_arena_key) + len + 1);
+
+	c = a->chunks;
+	if (c == NULL || c->size - c->used < need) {
+		c = malloc(sizeof(struct ht_arena_chunk) +
+		           ((need > a->chunk_size) ? need : a->chunk_size));
+		assert(c);
+		c->size = (need > a->chunk_size) ? need : a->chunk_size;
+		c->used = 0;
+		c->next = a->chunks;
+		a->chunks = c;
+		a->nchunks++;
+	}
+
+	hdr = (struct ht_arena_key *) ((char *) (c + 1) + c->used);
+	c->used += need;
+	a->used += need;
+
+	hdr->hash = hash;
+	hdr->len = len;
+	memcpy(hdr + 1, key, len);
+	((char *) (hdr + 1))[len] = '\0';
+
+	return hdr + 1;
+}
+
+/*
+ * Note that a key in the arena of a hash table is no longer used.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key stored in the arena
+ */
+static void ht_arena_key_free(struct ht *h, void *key)
+{
+	size_t need;
+
+	need = Ht_align8(sizeof(struct ht_arena_key) +
+	                 ht_arena_hdr(key)->len + 1);
+	h->arena->used -= need;
+	h->arena->dead += need;
+}
+
 /*
  * Copy a data to hash table linked list. This will be the copy
  * function for hash table linked list.
@@ -99,8 +237,12 @@ static void *ht_data_cpy(void *h_n_d)
 	dest = malloc(sizeof(struct ht_data));
 	assert(dest);
 
-	dest->key = h->k_cpy(data->key);
+	if (h->arena != NULL)
+		dest->key = ht_arena_key_cpy(h, data->key, data->hash);
+	else
+		dest->key = h->k_cpy(data->key);
 	dest->val = h->v_cpy(data->val);
+	dest->hash = data->hash;
 
 	return dest;
 }
@@ -134,44 +276,42 @@ static int ht_data_cmp(void *val, void *h_n_d)
 }
 
 /*
- * Hash function.
+ * Default hash function. Returns the hash value of key; callers
+ * mask it to a slot index of whichever table they are looking at.
  *
  * @h:   Pointer to the hash table structure. This is needed
  *       because it has pointer to the function to get the 
- *       key size. TODO: Change design where passing of hash
- *       table structure is not needed.
+ *       key size, and the seed.
  *
  * @key: Key whose hash value is to be calculated
  */
-static int hash_func(struct ht *h, void *key)
+static size_t ht_default_hash(struct ht *h, void *key)
 {
-	int i;
-	int hash_val;
-	int key_size;
-	char *key_char;
-
-	key_size = h->get_key_size(key);
-	key_char = (char *) key;
-
-	hash_val = 0;
+	return hash_key(key, h->get_key_size(key), h->seed);
+}
 
-	/*
-	 * TODO: Is it better not to do a modulo divisin with
-	 * h->tot_slots here and do it in the caller instead? 
-	 */
+/*
+ * Round up the slot count to a power of 2, so that a hash value
+ * can be reduced to a slot index with a mask.
+ *
+ * @tot_slots: Requested slot count
+ */
+static size_t ht_round_slots(size_t tot_slots)
+{
+	size_t n;
 
-	for (i = 0; i < key_size; i++) {
-		hash_val += ((*key_char) * 31) % h->tot_slots;
-		key_char++;
-	}
+	n = 1;
+	while (n < tot_slots)
+		n *= 2;
 
-	return hash_val % h->tot_slots;
+	return n;
 }
 
 /*
  * Create a hash table.
  *
- * @tot_slots:    Total slots in the hash table
+ * @tot_slots:    Total slots in the hash table. Rounded up to
+ *                a power of 2.
  * @k_cpy:        Function to copy key
  * @v_cpy:        Function to copy val 
  * @k_cmp:        Function to compare key
@@ -192,11 +332,21 @@ struct ht *ht_create(size_t tot_slots,
 	h = malloc(sizeof(struct ht));
 	assert(h);
 
+	tot_slots = ht_round_slots(tot_slots);
+
 	h->table = calloc(tot_slots, sizeof(struct ll *));
 	assert(h->table);
 
 	h->tot_slots = tot_slots;
 
+	h->new_table = NULL;
+	h->new_tot_slots = 0;
+	h->rehash_idx = -1;
+	h->walkers = 0;
+
+	h->nmemb = 0;
+	h->max_load = HT_MAX_LOAD;
+
 	h->k_cpy = k_cpy;
 	h->v_cpy = v_cpy;
 
@@ -205,91 +355,374 @@ struct ht *ht_create(size_t tot_slots,
 
 	h->get_key_size = get_key_size;
 
-	h->hash_func = hash_func;
+	h->hash_func = ht_default_hash;
+	h->seed = HASH_SEED;
+
+	h->bloom = NULL;
+	h->bloom_stale = 0;
+
+	h->arena = NULL;
+
+	h->n_lookups = 0;
+	h->n_hits = 0;
+	h->n_cmps = 0;
+	h->n_resizes = 0;
 
 	return h;
 }
 
 /*
- * Encapsulate hash table structure and data (key and val) in a single
- * structure.
+ * Create the linked list for a slot of a table if there is none.
+ *
+ * @h:     Pointer to the hash table structure
+ * @table: Table of linked lists
+ * @idx:   Slot index
+ */
+static struct ll *ht_slot_list(struct ht *h, struct ll **table, size_t idx)
+{
+	if (table[idx] == NULL)
+		table[idx] = ll_create(ht_data_cpy, ht_data_cmp,
+		                       (h->arena != NULL) ?
+		                       ht_ll_dval_arena : ht_ll_dval, NULL);
+
+	return table[idx];
+}
+
+/*
+ * Move all nodes of one slot of h->table to h->new_table. Nodes
+ * are relinked, not copied. A moved node is appended to the tail
+ * of its new list, so nodes inserted to h->new_table while growing
+ * (which are newer) still come first, and duplicate keys keep their
+ * newest first order that ht_find relies on.
  *
- * @h:   Pointer to hash table structure
- * @key: Pointer to key
- * @val: Pointer to val 
+ * The nodes of one slot go to at most HT_GROWTH_RATE new lists. The
+ * tail of each is found once and then kept, so a move is O(1) per
+ * node however long the lists are.
+ *
+ * @h:   Pointer to the hash table structure
+ * @idx: Slot of h->table to move
  */
-static struct ht_and_data *ht_n_d_encap(struct ht *h, void *key, void *val)
+static void ht_move_slot(struct ht *h, size_t idx)
 {
+	int i;
+	int ndest;
+	struct ll *src;
+	struct ll *dest;
+	struct ll_node *lln;
 	struct ht_data *data;
-	struct ht_and_data *htnd;
+	struct ll *dests[HT_GROWTH_RATE];
+	struct ll_node **tails[HT_GROWTH_RATE];
+
+	src = h->table[idx];
+	ndest = 0;
+
+	while (src->head != NULL) {
+		/* Unlink from old list */
+		lln = src->head;
+		src->head = lln->next;
+		src->nmemb--;
+
+		/* Find tail of new list, walking it only the first time */
+		data = (struct ht_data *) lln->val;
+		dest = ht_slot_list(h, h->new_table,
+		                    data->hash & (h->new_tot_slots - 1));
+		for (i = 0; i < ndest && dests[i] != dest; i++)
+			;
+		if (i == ndest) {
+			assert(ndest < HT_GROWTH_RATE);
+			dests[i] = dest;
+			tails[i] = &dest->head;
+			while (*tails[i] != NULL)
+				tails[i] = &(*tails[i])->next;
+			ndest++;
+		}
 
-	/* Encapsulate key and val in ht_data structure */
-	data = malloc(sizeof(struct ht_data));
-	assert(data);
-	data->key = key;
-	data->val = val;
+		/* Link at tail of new list */
+		lln->next = NULL;
+		*tails[i] = lln;
+		tails[i] = &lln->next;
+		dest->nmemb++;
+	}
 
-	/*
-	 * Encapsulate hash table structure and insert/search 
-	 * ht_data in ht_and_data structure
-	 */
-	htnd = malloc(sizeof(struct ht_and_data));
-	assert(htnd);
-	htnd->h = h;
-	htnd->data = data;
+	ll_destroy(src);
+	h->table[idx] = NULL;
+}
+
+/*
+ * Perform one step of incremental rehash, moving up to `n' non
+ * empty slots from h->table to h->new_table. Like Redis, a step
+ * also gives up after visiting 10 * n empty slots, so that a
+ * sparse table does not make a single call slow.
+ *
+ * When the last slot is moved, h->new_table becomes h->table.
+ *
+ * Nothing is moved while a cursor or scan is walking the table,
+ * so lookups made during a walk do not disturb it.
+ *
+ * @h: Pointer to the hash table structure
+ * @n: Number of slots to move
+ */
+static void ht_rehash_step(struct ht *h, int n)
+{
+	int empty_visits;
+
+	if (h->rehash_idx < 0 || h->walkers > 0)
+		return;
 
-	return htnd;
+	empty_visits = n * 10;
+
+	while (n > 0 && h->rehash_idx < h->tot_slots) {
+		if (h->table[h->rehash_idx] == NULL) {
+			h->rehash_idx++;
+			if (--empty_visits == 0)
+				break;
+			continue;
+		}
+		ht_move_slot(h, h->rehash_idx);
+		h->rehash_idx++;
+		n--;
+	}
+
+	/* Done growing, switch to new table */
+	if (h->rehash_idx == h->tot_slots) {
+		free(h->table);
+		h->table = h->new_table;
+		h->tot_slots = h->new_tot_slots;
+		h->new_table = NULL;
+		h->new_tot_slots = 0;
+		h->rehash_idx = -1;
+	}
 }
 
+/*
+ * Start growing the table if the load factor is beyond limit.
+ * The members are moved later, a few slots per operation.
+ *
+ * @h: Pointer to the hash table structure
+ */
+static void ht_grow_if_needed(struct ht *h)
+{
+	if (h->rehash_idx >= 0 || h->max_load <= 0)
+		return;
+
+	if (h->nmemb <= h->max_load * h->tot_slots)
+		return;
+
+	h->new_tot_slots = h->tot_slots * HT_GROWTH_RATE;
+	h->new_table = calloc(h->new_tot_slots, sizeof(struct ll *));
+	assert(h->new_table);
+
+	h->rehash_idx = 0;
+	Ht_count(h, n_resizes);
+}
 
 /*
- * Destroy temporary encapsulation structure 
+ * Return 1 if a key of the table is equal to `key'. Keys in the
+ * arena are compared by length and then bytes, else with k_cmp.
  *
- * @htnd: Encapsulation structure to destory
+ * @h:    Pointer to the hash table structure
+ * @tkey: Key stored in the table
+ * @key:  Key looked for
+ * @klen: Size of key, used only with an arena
  */
-static void ht_n_d_dencap(struct ht_and_data *htnd)
+static int ht_key_eq(struct ht *h, void *tkey, void *key, size_t klen)
 {
-	free(htnd->data);
-	free(htnd);
+	if (h->arena != NULL)
+		return ht_arena_hdr(tkey)->len == klen &&
+		       memcmp(tkey, key, klen) == 0;
+
+	return h->k_cmp(tkey, key) == 0;
 }
 
 /*
- * Insert a new data to Hash table.
+ * Find the list node holding a key. Return pointer to the link
+ * pointing to that node (so the caller can unlink it), or NULL if
+ * the key is not in the table. While growing, newer members are in
+ * the new table, so that is looked at first.
  *
- * @h:   Pointer to the hash table structure
- * @key: Key of the data to be inserted
- * @val: Val of the data to be inserted
+ * Cached hashes are compared before calling k_cmp, and nothing is
+ * allocated.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key to find
+ * @hash: Hash of the key
+ * @lp:   If not NULL, set to the list holding the node
  */
-int ht_insert(struct ht *h, void *key, void *val)
+static struct ll_node **ht_find(struct ht *h, void *key, size_t hash,
+                                struct ll **lp)
+{
+	int i;
+	size_t klen;
+	struct ll *l;
+	struct ll_node **link;
+	struct ht_data *data;
+
+	Ht_count(h, n_lookups);
+
+	klen = (h->arena != NULL) ? h->get_key_size(key) : 0;
+
+	/* Most absent keys stop here, after one cache line */
+	if (h->bloom != NULL && !bloom_may_contain(h->bloom, hash))
+		return NULL;
+
+	for (i = 0; i < 2; i++) {
+		if (i == 0 && h->rehash_idx < 0)
+			continue;
+		if (i == 0)
+			l = h->new_table[hash & (h->new_tot_slots - 1)];
+		else
+			l = h->table[hash & (h->tot_slots - 1)];
+		if (l == NULL)
+			continue;
+
+		link = &l->head;
+		while (*link != NULL) {
+			data = (struct ht_data *) (*link)->val;
+			if (data->hash == hash &&
+			    (Ht_count(h, n_cmps),
+			     ht_key_eq(h, data->key, key, klen))) {
+				if (lp != NULL)
+					*lp = l;
+				Ht_count(h, n_hits);
+				return link;
+			}
+			link = &(*link)->next;
+		}
+	}
+
+	if (h->bloom != NULL && h->walkers == 0)
+		bloom_false_pos(h->bloom);
+
+	return NULL;
+}
+
+/*
+ * Add hashes of all members of a table to a bloom filter.
+ *
+ * @b:         Pointer to the bloom filter structure
+ * @table:     Table of linked lists
+ * @tot_slots: Total slots in table
+ */
+static void ht_bloom_fill(struct bloom *b, struct ll **table,
+                          size_t tot_slots)
+{
+	size_t i;
+	struct ll_node *lln;
+
+	for (i = 0; i < tot_slots; i++) {
+		if (table[i] == NULL)
+			continue;
+		for (lln = table[i]->head; lln != NULL; lln = lln->next)
+			bloom_add(b, ((struct ht_data *) lln->val)->hash);
+	}
+}
+
+/*
+ * Build the bloom filter again from the members, sized for twice
+ * as many keys as there are now. Done when the filter fills up,
+ * and when too many of its keys were deleted, since bits can not
+ * be removed. Counters of the old filter are kept.
+ *
+ * @h:            Pointer to the hash table structure
+ * @bits_per_key: Filter bits per key
+ */
+static void ht_bloom_rebuild(struct ht *h, int bits_per_key)
+{
+	struct bloom *b;
+
+	b = bloom_create(2 * h->nmemb, bits_per_key);
+
+	ht_bloom_fill(b, h->table, h->tot_slots);
+	if (h->rehash_idx >= 0)
+		ht_bloom_fill(b, h->new_table, h->new_tot_slots);
+
+	if (h->bloom != NULL) {
+		b->nneg = h->bloom->nneg;
+		b->nfp = h->bloom->nfp;
+		bloom_destroy(h->bloom);
+	}
+
+	h->bloom = b;
+	h->bloom_stale = 0;
+}
+
+/*
+ * Add a new node for key and val, whose hash is known. Return index
+ * of the slot the node went to.
+ *
+ * The key and val are handed to ht_data_cpy through structures on
+ * the stack, so the only allocations are the copies themselves.
+ *
+ * @h:     Pointer to the hash table structure
+ * @key:   Key of the data to be inserted
+ * @val:   Val of the data to be inserted
+ * @hash:  Hash of the key
+ * @datap: If not NULL, set to the new ht_data
+ */
+static int ht_add(struct ht *h, void *key, void *val, size_t hash,
+                  struct ht_data **datap)
 {
 	int idx;
-	struct ht_and_data *htnd;
+	struct ll *l;
+	struct ht_data data;
+	struct ht_and_data htnd;
 
-	/* Encapsulate hash table and search data in single struct */
-	htnd = ht_n_d_encap(h, key, val);
+	data.key = key;
+	data.val = val;
+	data.hash = hash;
 
-	/* Get the hash value for key */
-	idx = h->hash_func(h, key);
+	htnd.h = h;
+	htnd.data = &data;
 
 	/* 
-	 * Insert new data to correct slot
+	 * Insert new data to correct slot. While growing, new data
+	 * always goes to the new table.
 	 */
-
-	/* Create a linked list if none at this slot */
-	if (h->table[idx] == NULL) {
-		h->table[idx] =
-		ll_create(ht_data_cpy, ht_data_cmp, ht_ll_dval, NULL);
+	if (h->rehash_idx >= 0) {
+		idx = hash & (h->new_tot_slots - 1);
+		l = ht_slot_list(h, h->new_table, idx);
+	} else {
+		idx = hash & (h->tot_slots - 1);
+		l = ht_slot_list(h, h->table, idx);
 	}
 
-	/* Insert data to the list */
-	ll_insert(h->table[idx], htnd);
+	ll_insert(l, &htnd);
 
-	/* Destroy the temporary encapsulation structure */
-	ht_n_d_dencap(htnd);
+	if (datap != NULL)
+		*datap = (struct ht_data *) l->head->val;
+
+	h->nmemb++;
+
+	if (h->bloom != NULL) {
+		bloom_add(h->bloom, hash);
+		if (h->bloom->nkeys > h->bloom->cap)
+			ht_bloom_rebuild(h, h->bloom->bits_per_key);
+	}
+
+	ht_grow_if_needed(h);
 
 	return idx;
 }
 
+/*
+ * Insert a new data to Hash table. Return index of the slot where
+ * data was inserted. If the table is growing, this is a slot of
+ * h->new_table.
+ *
+ * The key is not looked up first, so inserting a key twice keeps
+ * two members; see ht_upsert for replacing.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to be inserted
+ * @val: Val of the data to be inserted
+ */
+int ht_insert(struct ht *h, void *key, void *val)
+{
+	ht_rehash_step(h, HT_REHASH_STEP);
+
+	return ht_add(h, key, val, h->hash_func(h, key), NULL);
+}
+
 /*
  * Search for a data in hash table.
  *
@@ -298,24 +731,242 @@ int ht_insert(struct ht *h, void *key, void *val)
  */
 int ht_search(struct ht *h, void *key)
 {
-	int idx;
 	int retval;
-	struct ht_and_data *htnd;
-
-	/* Encapsulate hash table and search data in single struct */
-	htnd = ht_n_d_encap(h, key, NULL);
 
-	/* Get the hash value for key */
-	idx = h->hash_func(h, key);
+	ht_rehash_step(h, HT_REHASH_STEP);
 
-	/* Search for the key in linked list in that slot */
-	if (h->table[idx] == NULL)
-		retval = 0;
+	if (ht_find(h, key, h->hash_func(h, key), NULL) != NULL)
+		retval = 1;
 	else
-		retval = ll_search(h->table[idx], htnd);
+		retval = 0;
+
+	return retval;
+}
+
+/*
+ * Get the val stored for a key. Return pointer to the val in the
+ * table (not a copy), or NULL if the key is not in the table.
+ *
+ * The pointer stays valid, also while the table grows, until the
+ * key is deleted or its val replaced by ht_upsert.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to get
+ */
+void *ht_get(struct ht *h, void *key)
+{
+	struct ll_node **link;
+
+	ht_rehash_step(h, HT_REHASH_STEP);
+
+	link = ht_find(h, key, h->hash_func(h, key), NULL);
+	if (link == NULL)
+		return NULL;
+
+	return ((struct ht_data *) (*link)->val)->val;
+}
+
+/*
+ * Insert a data, or replace the val in place if key is already in
+ * the table. Return 1 if a new member was inserted, 0 if a val was
+ * replaced.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data
+ * @val: New val
+ */
+int ht_upsert(struct ht *h, void *key, void *val)
+{
+	size_t hash;
+	struct ll_node **link;
+	struct ht_data *data;
+
+	ht_rehash_step(h, HT_REHASH_STEP);
+
+	hash = h->hash_func(h, key);
+
+	link = ht_find(h, key, hash, NULL);
+	if (link == NULL) {
+		ht_add(h, key, val, hash, NULL);
+		return 1;
+	}
+
+	data = (struct ht_data *) (*link)->val;
+	free(data->val);
+	data->val = h->v_cpy(val);
+
+	return 0;
+}
+
+/*
+ * Get the val stored for a key, inserting key and val first if the
+ * key is not in the table. Return pointer to the val in the table.
+ * The key is hashed once and looked up once.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data
+ * @val: Val to insert if key is not found
+ */
+void *ht_get_or_insert(struct ht *h, void *key, void *val)
+{
+	size_t hash;
+	struct ll_node **link;
+	struct ht_data *data;
+
+	ht_rehash_step(h, HT_REHASH_STEP);
+
+	hash = h->hash_func(h, key);
+
+	link = ht_find(h, key, hash, NULL);
+	if (link != NULL)
+		return ((struct ht_data *) (*link)->val)->val;
+
+	ht_add(h, key, val, hash, &data);
+
+	return data->val;
+}
+
+/*
+ * Look up a group of at most HT_BATCH_GROUP keys, writing the
+ * ht_data of every key (NULL if not found) to `out'.
+ *
+ * A lookup follows a chain of dependent loads: slot, list, first
+ * node, data, key. Instead of taking the misses of one key after
+ * the other, every stage is run for all keys of the group, and
+ * prefetches the next hop of each, so the misses of a stage
+ * overlap (group prefetching). The final walk then mostly hits
+ * the cache.
+ *
+ * @h:    Pointer to the hash table structure
+ * @keys: Keys to find
+ * @n:    Number of keys, at most HT_BATCH_GROUP
+ * @out:  Array of n pointers to fill
+ */
+static void ht_find_group(struct ht *h, void **keys, size_t n,
+                          struct ht_data **out)
+{
+	size_t i;
+	size_t j;
+	size_t nl;
+	size_t hash[HT_BATCH_GROUP];
+	struct ll_node **link;
+	struct ll *l[2 * HT_BATCH_GROUP];
+	struct ll **slot[2 * HT_BATCH_GROUP];
+
+	/* Stage 1: hash keys, prefetch slots of both tables */
+	nl = (h->rehash_idx >= 0) ? 2 : 1;
+	for (i = 0; i < n; i++) {
+		hash[i] = h->hash_func(h, keys[i]);
+		slot[i * nl] = &h->table[hash[i] & (h->tot_slots - 1)];
+		if (nl == 2)
+			slot[i * nl + 1] =
+			&h->new_table[hash[i] & (h->new_tot_slots - 1)];
+		for (j = i * nl; j < (i + 1) * nl; j++)
+			Ht_prefetch(slot[j]);
+	}
+
+	/* Stage 2: load lists, prefetch them */
+	for (j = 0; j < n * nl; j++) {
+		l[j] = *slot[j];
+		if (l[j] != NULL)
+			Ht_prefetch(l[j]);
+	}
+
+	/* Stage 3: prefetch first node of each list */
+	for (j = 0; j < n * nl; j++)
+		if (l[j] != NULL && l[j]->head != NULL)
+			Ht_prefetch(l[j]->head);
+
+	/* Stage 4: prefetch data of first node */
+	for (j = 0; j < n * nl; j++)
+		if (l[j] != NULL && l[j]->head != NULL)
+			Ht_prefetch(l[j]->head->val);
+
+	/* Stage 5: prefetch key of first node */
+	for (j = 0; j < n * nl; j++)
+		if (l[j] != NULL && l[j]->head != NULL)
+			Ht_prefetch(((struct ht_data *) l[j]->head->val)->key);
+
+	/* Stage 6: resolve */
+	for (i = 0; i < n; i++) {
+		link = ht_find(h, keys[i], hash[i], NULL);
+		if (link != NULL)
+			out[i] = (struct ht_data *) (*link)->val;
+		else
+			out[i] = NULL;
+	}
+}
 
-	/* Destroy the temporary encapsulation structure */
-	ht_n_d_dencap(htnd);
+/*
+ * Search for many keys at once. found[i] is set to 1 if keys[i] is
+ * in the table, else 0. Return number of keys found.
+ *
+ * Faster than calling ht_search for each key once the table does
+ * not fit in cache, as cache misses of different keys overlap.
+ *
+ * @h:     Pointer to the hash table structure
+ * @keys:  Keys to be searched
+ * @n:     Number of keys
+ * @found: Array of n ints to fill
+ */
+size_t ht_search_batch(struct ht *h, void **keys, size_t n, int *found)
+{
+	size_t i;
+	size_t g;
+	size_t cnt;
+	size_t retval;
+	struct ht_data *data[HT_BATCH_GROUP];
+
+	retval = 0;
+
+	for (g = 0; g < n; g += HT_BATCH_GROUP) {
+		ht_rehash_step(h, HT_REHASH_STEP);
+
+		cnt = (n - g < HT_BATCH_GROUP) ? n - g : HT_BATCH_GROUP;
+		ht_find_group(h, keys + g, cnt, data);
+		for (i = 0; i < cnt; i++) {
+			found[g + i] = (data[i] != NULL);
+			retval += found[g + i];
+		}
+	}
+
+	return retval;
+}
+
+/*
+ * Get the vals stored for many keys at once. vals[i] is set to the
+ * val of keys[i] in the table (not a copy, see ht_get), or NULL if
+ * keys[i] is not in the table. Return number of keys found.
+ *
+ * @h:    Pointer to the hash table structure
+ * @keys: Keys of the data to get
+ * @n:    Number of keys
+ * @vals: Array of n pointers to fill
+ */
+size_t ht_get_batch(struct ht *h, void **keys, size_t n, void **vals)
+{
+	size_t i;
+	size_t g;
+	size_t cnt;
+	size_t retval;
+	struct ht_data *data[HT_BATCH_GROUP];
+
+	retval = 0;
+
+	for (g = 0; g < n; g += HT_BATCH_GROUP) {
+		ht_rehash_step(h, HT_REHASH_STEP);
+
+		cnt = (n - g < HT_BATCH_GROUP) ? n - g : HT_BATCH_GROUP;
+		ht_find_group(h, keys + g, cnt, data);
+		for (i = 0; i < cnt; i++) {
+			if (data[i] != NULL) {
+				vals[g + i] = data[i]->val;
+				retval++;
+			} else {
+				vals[g + i] = NULL;
+			}
+		}
+	}
 
 	return retval;
 }
@@ -329,24 +980,49 @@ int ht_search(struct ht *h, void *key)
  */
 void ht_delete(struct ht *h, void *key)
 {
-	int idx;
-	struct ht_and_data *htnd;
+	struct ll *l;
+	struct ll_node *lln;
+	struct ll_node **link;
 
-	/* Encapsulate hash table and search data in single struct */
-	htnd = ht_n_d_encap(h, key, NULL);
+	ht_rehash_step(h, HT_REHASH_STEP);
 
-	/* Get the hash value for key */
-	idx = h->hash_func(h, key);
-	
-	/*
-	 * Delete item from the list. This will delete the item only
-	 * if it is present in the list. Else there is no effect.
-	 */
-	if (h->table[idx] != NULL)
-		ll_delete(h->table[idx], htnd);
+	link = ht_find(h, key, h->hash_func(h, key), &l);
+	if (link == NULL)
+		return;
 
-	/* Destroy the temporary encapsulation structure */
-	ht_n_d_dencap(htnd);
+	/* Unlink the node and destroy it */
+	lln = *link;
+	*link = lln->next;
+	if (h->arena != NULL)
+		ht_arena_key_free(h, ((struct ht_data *) lln->val)->key);
+	l->dval(lln->val);
+	free(lln);
+	l->nmemb--;
+
+	h->nmemb--;
+
+	/* Rebuild once half the keys in the filter are gone */
+	if (h->bloom != NULL &&
+	    ++h->bloom_stale * 2 > h->bloom->nkeys)
+		ht_bloom_rebuild(h, h->bloom->bits_per_key);
+}
+
+/*
+ * Destroy all linked lists of a table and the table itself.
+ *
+ * @table:     Table of linked lists
+ * @tot_slots: Total slots in table
+ */
+static void ht_destroy_table(struct ll **table, size_t tot_slots)
+{
+	size_t i;
+
+	for (i = 0; i < tot_slots; i++)
+		if (table[i] != NULL) {
+			ll_destroy(table[i]);
+		}
+
+	free(table);
 }
 
 /*
@@ -360,31 +1036,699 @@ void ht_delete(struct ht *h, void *key)
  * 2. Free memory occupied by h->table.
  *    i.e: free(h->table)
  *
- * 3. Free memory occupied by hash table structure itself.
+ * 3. Do 1 and 2 for h->new_table as well, if the table is
+ *    growing.
+ *
+ * 4. Free memory occupied by hash table structure itself.
  *    i.e: free(h)
  *
  * @h: Pointer to the hash table structure
  */
 void ht_destroy(struct ht *h)
 {
-	int i;
+	struct ht_arena_chunk *c;
 
-	for (i = 0; i < h->tot_slots; i++)
-		if (h->table[i] != NULL) {
-			ll_destroy(h->table[i]);
-		}
+	ht_destroy_table(h->table, h->tot_slots);
+
+	if (h->new_table != NULL)
+		ht_destroy_table(h->new_table, h->new_tot_slots);
 
-	free(h->table);
+	if (h->bloom != NULL)
+		bloom_destroy(h->bloom);
+
+	if (h->arena != NULL) {
+		while (h->arena->chunks != NULL) {
+			c = h->arena->chunks;
+			h->arena->chunks = c->next;
+			free(c);
+		}
+		free(h->arena);
+	}
 
 	free(h);
 }
 
 /*
- * Print hash table.
+ * Set the max load factor. Once nmemb / tot_slots goes beyond
+ * this, the table starts growing. A value <= 0 turns off growing.
+ *
+ * @h:        Pointer to the hash table structure
+ * @max_load: New max load factor
+ */
+void ht_set_max_load(struct ht *h, double max_load)
+{
+	h->max_load = max_load;
+}
+
+/*
+ * Set the hash function and its seed. Must be called while the
+ * table is empty, as hash values of members are cached.
+ *
+ * @h:         Pointer to the hash table structure
+ * @hash_func: New hash function, NULL for the default one
+ * @seed:      Seed passed to hash_func through h->seed
+ */
+void ht_set_hash(struct ht *h, size_t (*hash_func) (struct ht *, void *),
+                 uint64_t seed)
+{
+	assert(h->nmemb == 0);
+
+	if (hash_func == NULL)
+		hash_func = ht_default_hash;
+
+	h->hash_func = hash_func;
+	h->seed = seed;
+}
+
+/*
+ * Put a bloom filter in front of lookups, or remove it. Keys that
+ * are not in the table are then mostly rejected by reading one
+ * cache line of the filter. Worth it when most lookups miss.
+ *
+ * @h:            Pointer to the hash table structure
+ * @bits_per_key: Filter bits per key, 0 to remove the filter
+ */
+void ht_set_bloom(struct ht *h, int bits_per_key)
+{
+	if (bits_per_key > 0) {
+		ht_bloom_rebuild(h, bits_per_key);
+		return;
+	}
+
+	if (h->bloom != NULL)
+		bloom_destroy(h->bloom);
+	h->bloom = NULL;
+	h->bloom_stale = 0;
+}
+
+/*
+ * Return false positive rate observed by the bloom filter: the
+ * fraction of lookups of absent keys the filter did not reject.
+ * 0 if there is no filter.
  *
  * @h: Pointer to the hash table structure
  */
-void ht_print(struct ht *h, int type)
+double ht_bloom_fp_rate(struct ht *h)
+{
+	if (h->bloom == NULL)
+		return 0;
+
+	return bloom_fp_rate(h->bloom);
+}
+
+/*
+ * Find out if the table is in the middle of growing.
+ *
+ * @h: Pointer to the hash table structure
+ */
+int ht_is_rehashing(struct ht *h)
+{
+	int retval;
+
+	if (h->rehash_idx >= 0)
+		retval = 1;
+	else
+		retval = 0;
+
+	return retval;
+}
+
+/*
+ * Return the total members count
+ *
+ * @h: Pointer to the hash table structure
+ */
+size_t ht_tot_memb(struct ht *h)
+{
+	return h->nmemb;
+}
+
+/*
+ * Keep keys in an arena owned by the table rather than in one
+ * k_cpy allocation each. Keys are stored back to back in chunks of
+ * `chunk_size' bytes, with their hash and length, and compared by
+ * length and bytes instead of k_cmp, so keys must be equal exactly
+ * when their get_key_size bytes are (true for int and str keys).
+ * ht_destroy frees whole chunks. Space of deleted keys is only
+ * given back by ht_destroy, so this suits tables that mostly grow.
+ *
+ * Must be called before the first insert.
+ *
+ * @h:          Pointer to the hash table structure
+ * @chunk_size: Bytes per chunk, 0 for HT_ARENA_CHUNK
+ */
+void ht_set_key_arena(struct ht *h, size_t chunk_size)
+{
+	size_t i;
+
+	assert(h->nmemb == 0 && h->arena == NULL);
+
+	h->arena = malloc(sizeof(struct ht_arena));
+	assert(h->arena);
+
+	h->arena->chunks = NULL;
+	h->arena->chunk_size = (chunk_size > 0) ? chunk_size : HT_ARENA_CHUNK;
+	h->arena->nchunks = 0;
+	h->arena->used = 0;
+	h->arena->dead = 0;
+
+	/* Lists left empty by deletes must not free arena keys */
+	for (i = 0; i < h->tot_slots; i++)
+		if (h->table[i] != NULL)
+			h->table[i]->dval = ht_ll_dval_arena;
+	if (h->rehash_idx >= 0)
+		for (i = 0; i < h->new_tot_slots; i++)
+			if (h->new_table[i] != NULL)
+				h->new_table[i]->dval = ht_ll_dval_arena;
+}
+
+/*
+ * Add chain lengths of a table to the stats.
+ *
+ * @st:        Pointer to the stats to add to
+ * @table:     Table of linked lists
+ * @tot_slots: Total slots in table
+ */
+static void ht_stats_table(struct ht_stats *st, struct ll **table,
+                           size_t tot_slots)
+{
+	size_t i;
+	size_t len;
+
+	for (i = 0; i < tot_slots; i++) {
+		len = (table[i] != NULL) ? table[i]->nmemb : 0;
+		if (len > 0)
+			st->used_slots++;
+		if (len > st->max_chain)
+			st->max_chain = len;
+		if (len >= HT_STATS_HIST)
+			len = HT_STATS_HIST - 1;
+		st->chain_hist[len]++;
+	}
+}
+
+/*
+ * Fill `st' with the shape of a hash table (load, used slots, chain
+ * length histogram) and its operation counters. Walks all slots, so
+ * it takes time in proportion to the table size.
+ *
+ * A long max_chain or a high cmps_per_lookup at a sane load point
+ * to a bad hash_func; a high load to a table that should grow.
+ *
+ * @h:  Pointer to the hash table structure
+ * @st: Pointer to the stats to fill
+ */
+void ht_stats(struct ht *h, struct ht_stats *st)
+{
+	memset(st, 0, sizeof(struct ht_stats));
+
+	ht_stats_table(st, h->table, h->tot_slots);
+	st->tot_slots = h->tot_slots;
+	if (h->rehash_idx >= 0) {
+		ht_stats_table(st, h->new_table, h->new_tot_slots);
+		st->tot_slots += h->new_tot_slots;
+	}
+
+	st->nmemb = h->nmemb;
+	st->load = (double) st->nmemb / st->tot_slots;
+	if (st->used_slots > 0)
+		st->avg_chain = (double) st->nmemb / st->used_slots;
+
+	st->lookups = h->n_lookups;
+	st->hits = h->n_hits;
+	st->misses = h->n_lookups - h->n_hits;
+	st->key_cmps = h->n_cmps;
+	if (st->lookups > 0)
+		st->cmps_per_lookup = (double) st->key_cmps / st->lookups;
+	st->resizes = h->n_resizes;
+}
+
+/*
+ * Start a walk over all members of a hash table. Members are seen
+ * exactly once, also when the table is growing: the rehash is
+ * paused until the walk is done, so ht_get and ht_search may be
+ * called on the table during the walk. Nothing may be inserted or
+ * deleted. A walk stopped before ht_iter_next returns 0 must be
+ * ended with ht_iter_end, or the table never finishes growing.
+ *
+ * @h:  Pointer to the hash table structure
+ * @it: Pointer to the cursor to set up
+ */
+void ht_iter_begin(struct ht *h, struct ht_iter *it)
+{
+	h->walkers++;
+	it->h = h;
+	it->table = (h->rehash_idx < 0) ? 1 : 0;
+	it->slot = 0;
+	it->node = NULL;
+}
+
+/*
+ * Step a cursor to the next member. Pointers to the key and val
+ * stored in the table are put in *key and *val; they are not
+ * copies. Return 1 if there was a member, 0 when the walk is done.
+ *
+ * @it:  Pointer to the cursor
+ * @key: Set to key of the member, may be NULL
+ * @val: Set to val of the member, may be NULL
+ */
+int ht_iter_next(struct ht_iter *it, void **key, void **val)
+{
+	struct ll **table;
+	size_t tot_slots;
+	struct ht_data *data;
+
+	while (it->node == NULL) {
+		if (it->table == 2)
+			return 0;
+
+		if (it->table == 0) {
+			table = it->h->new_table;
+			tot_slots = it->h->new_tot_slots;
+		} else {
+			table = it->h->table;
+			tot_slots = it->h->tot_slots;
+		}
+
+		if (it->slot == tot_slots) {
+			it->table++;
+			it->slot = 0;
+			if (it->table == 2)
+				it->h->walkers--;
+			continue;
+		}
+
+		if (table[it->slot] != NULL)
+			it->node = table[it->slot]->head;
+		it->slot++;
+	}
+
+	data = (struct ht_data *) it->node->val;
+	it->node = it->node->next;
+
+	if (key != NULL)
+		*key = data->key;
+	if (val != NULL)
+		*val = data->val;
+
+	return 1;
+}
+
+/*
+ * End a walk early. Has no effect on a walk that is done.
+ *
+ * @it: Pointer to the cursor
+ */
+void ht_iter_end(struct ht_iter *it)
+{
+	if (it->table == 2)
+		return;
+
+	it->table = 2;
+	it->node = NULL;
+	it->h->walkers--;
+}
+
+/*
+ * Call fn on members in this worker's share of the slots of a table.
+ *
+ * @w:         Work of the worker
+ * @table:     Table of linked lists
+ * @tot_slots: Total slots in table
+ */
+static void ht_scan_table(struct ht_scan_work *w, struct ll **table,
+                          size_t tot_slots)
+{
+	size_t i;
+	size_t lo;
+	size_t hi;
+	struct ll_node *lln;
+	struct ht_data *data;
+
+	lo = tot_slots * w->worker / w->nthreads;
+	hi = tot_slots * (w->worker + 1) / w->nthreads;
+
+	for (i = lo; i < hi; i++) {
+		if (table[i] == NULL)
+			continue;
+		for (lln = table[i]->head; lln != NULL; lln = lln->next) {
+			data = (struct ht_data *) lln->val;
+			w->fn(data->key, data->val, w->arg, w->worker);
+		}
+	}
+}
+
+/*
+ * Thread body of ht_parallel_for_each.
+ *
+ * @arg: Pointer to the struct ht_scan_work of the thread
+ */
+static void *ht_scan_worker(void *arg)
+{
+	struct ht_scan_work *w;
+
+	w = (struct ht_scan_work *) arg;
+
+	if (w->h->rehash_idx >= 0)
+		ht_scan_table(w, w->h->new_table, w->h->new_tot_slots);
+	ht_scan_table(w, w->h->table, w->h->tot_slots);
+
+	return NULL;
+}
+
+/*
+ * Call fn(key, val, arg, worker) on every member of a hash table,
+ * with the slots split into `nthreads' equal ranges, each walked by
+ * its own thread. `worker' is the index of the thread, 0 to
+ * nthreads - 1, so fn can add into per worker results without
+ * locking. The calling thread does the share of worker 0.
+ *
+ * The rehash is paused for the scan, so fn may call ht_get and
+ * ht_search on the table from any worker; HT_STATS and bloom
+ * counters are not kept meanwhile. Nothing may be inserted or
+ * deleted until this returns.
+ *
+ * @h:        Pointer to the hash table structure
+ * @nthreads: Total threads to use
+ * @fn:       Function to call on each member
+ * @arg:      Passed to fn as is
+ */
+void ht_parallel_for_each(struct ht *h, int nthreads,
+                          void (*fn) (void *, void *, void *, int),
+                          void *arg)
+{
+	int i;
+	int err;
+	pthread_t *tid;
+	struct ht_scan_work *work;
+
+	if (nthreads < 1)
+		nthreads = 1;
+
+	tid = malloc(nthreads * sizeof(pthread_t));
+	work = malloc(nthreads * sizeof(struct ht_scan_work));
+	assert(tid && work);
+
+	for (i = 0; i < nthreads; i++) {
+		work[i].h = h;
+		work[i].worker = i;
+		work[i].nthreads = nthreads;
+		work[i].fn = fn;
+		work[i].arg = arg;
+	}
+
+	/* Set before the threads start, cleared after they end */
+	h->walkers++;
+
+	for (i = 1; i < nthreads; i++) {
+		err = pthread_create(&tid[i], NULL, ht_scan_worker, &work[i]);
+		assert(err == 0);
+	}
+
+	ht_scan_worker(&work[0]);
+
+	for (i = 1; i < nthreads; i++)
+		pthread_join(tid[i], NULL);
+
+	h->walkers--;
+
+	free(tid);
+	free(work);
+}
+
+/*
+ * Run fn on every worker of a bulk build, each on its own thread
+ * but worker 0, which runs on the calling thread.
+ *
+ * @work:     Work of all workers
+ * @nthreads: Total workers
+ * @fn:       Thread body
+ */
+static void ht_bulk_run(struct ht_bulk_work *work, int nthreads,
+                        void *(*fn) (void *))
+{
+	int i;
+	int err;
+	pthread_t *tid;
+
+	tid = malloc(nthreads * sizeof(pthread_t));
+	assert(tid);
+
+	for (i = 1; i < nthreads; i++) {
+		err = pthread_create(&tid[i], NULL, fn, &work[i]);
+		assert(err == 0);
+	}
+
+	fn(&work[0]);
+
+	for (i = 1; i < nthreads; i++)
+		pthread_join(tid[i], NULL);
+
+	free(tid);
+}
+
+/*
+ * Bulk build pass 1: hash this worker's share of the keys and count
+ * them by partition.
+ *
+ * @arg: Pointer to the struct ht_bulk_work of the thread
+ */
+static void *ht_bulk_hash(void *arg)
+{
+	size_t i;
+	size_t lo;
+	size_t hi;
+	size_t mask;
+	size_t *counts;
+	struct ht_bulk_work *w;
+
+	w = (struct ht_bulk_work *) arg;
+
+	lo = w->n * w->worker / w->nthreads;
+	hi = w->n * (w->worker + 1) / w->nthreads;
+	mask = w->h->tot_slots - 1;
+	counts = w->counts + w->worker * w->nparts;
+
+	for (i = lo; i < hi; i++) {
+		w->hash[i] = w->h->hash_func(w->h, w->keys[i]);
+		counts[(w->hash[i] & mask) >> w->shift]++;
+	}
+
+	return NULL;
+}
+
+/*
+ * Bulk build pass 2: scatter this worker's key indexes to their
+ * partitions, at the offsets worked out from pass 1. Keeps input
+ * order within a partition.
+ *
+ * @arg: Pointer to the struct ht_bulk_work of the thread
+ */
+static void *ht_bulk_scatter(void *arg)
+{
+	size_t i;
+	size_t lo;
+	size_t hi;
+	size_t mask;
+	size_t *off;
+	struct ht_bulk_work *w;
+
+	w = (struct ht_bulk_work *) arg;
+
+	lo = w->n * w->worker / w->nthreads;
+	hi = w->n * (w->worker + 1) / w->nthreads;
+	mask = w->h->tot_slots - 1;
+	off = w->counts + w->worker * w->nparts;
+
+	for (i = lo; i < hi; i++)
+		w->perm[off[(w->hash[i] & mask) >> w->shift]++] = i;
+
+	return NULL;
+}
+
+/*
+ * Bulk build pass 3: add the members of every partition p with
+ * p % nthreads == worker. A partition is a range of slots no other
+ * worker touches, so no locking is needed.
+ *
+ * @arg: Pointer to the struct ht_bulk_work of the thread
+ */
+static void *ht_bulk_fill(void *arg)
+{
+	size_t i;
+	size_t p;
+	size_t idx;
+	struct ll *l;
+	struct ht *h;
+	struct ht_data data;
+	struct ht_and_data htnd;
+	struct ht_bulk_work *w;
+
+	w = (struct ht_bulk_work *) arg;
+	h = w->h;
+	htnd.h = h;
+	htnd.data = &data;
+
+	for (p = w->worker; p < w->nparts; p += w->nthreads)
+		for (i = w->part_off[p]; i < w->part_off[p + 1]; i++) {
+			idx = w->perm[i];
+			data.key = w->keys[idx];
+			data.val = w->vals[idx];
+			data.hash = w->hash[idx];
+			l = ht_slot_list(h, h->table,
+			                 data.hash & (h->tot_slots - 1));
+			ll_insert(l, &htnd);
+		}
+
+	return NULL;
+}
+
+/*
+ * Load many members into an empty hash table at once, using
+ * `nthreads' threads. Same result as calling ht_insert for each
+ * pair in order (keys are not checked for duplicates; the last one
+ * is found first), but much faster for big loads:
+ *
+ * 1. The table is sized once for all n members, so it never grows
+ *    while loading.
+ * 2. Keys are hashed in parallel, and radix partitioned by the top
+ *    bits of their slot, so each partition is a range of slots.
+ * 3. Each thread builds the chains of its own partitions, touching
+ *    only its own part of the table.
+ *
+ * With a key arena (ht_set_key_arena), step 3 runs on one thread,
+ * as the arena is not thread safe.
+ *
+ * @h:        Pointer to the hash table structure, with no members
+ * @keys:     Keys to load
+ * @vals:     Vals to load, vals[i] going with keys[i]
+ * @n:        Number of pairs
+ * @nthreads: Total threads to use
+ */
+void ht_build_bulk(struct ht *h, void **keys, void **vals, size_t n,
+                   int nthreads)
+{
+	int i;
+	int bits;
+	int slot_bits;
+	size_t p;
+	size_t cnt;
+	size_t sum;
+	size_t tot_slots;
+	size_t nparts;
+	size_t *hash;
+	size_t *perm;
+	size_t *counts;
+	size_t *part_off;
+	struct ht_bulk_work *work;
+
+	assert(h->nmemb == 0);
+
+	if (n == 0)
+		return;
+	if (nthreads < 1)
+		nthreads = 1;
+
+	/* Start from a table big enough for everything */
+	if (h->rehash_idx >= 0) {
+		ht_destroy_table(h->new_table, h->new_tot_slots);
+		h->new_table = NULL;
+		h->new_tot_slots = 0;
+		h->rehash_idx = -1;
+	}
+	tot_slots = h->tot_slots;
+	if (h->max_load > 0 && n > h->max_load * tot_slots)
+		tot_slots = ht_round_slots((size_t) (n / h->max_load) + 1);
+	ht_destroy_table(h->table, h->tot_slots);
+	h->table = calloc(tot_slots, sizeof(struct ll *));
+	assert(h->table);
+	h->tot_slots = tot_slots;
+
+	/*
+	 * Some partitions per thread, for balance, at most one a slot.
+	 * A partition is the top `bits' bits of a slot index.
+	 */
+	nparts = 1;
+	bits = 0;
+	while (nparts < 8 * (size_t) nthreads && nparts < tot_slots) {
+		nparts *= 2;
+		bits++;
+	}
+	slot_bits = 0;
+	while (((size_t) 1 << slot_bits) < tot_slots)
+		slot_bits++;
+
+	hash = malloc(n * sizeof(size_t));
+	perm = malloc(n * sizeof(size_t));
+	counts = calloc(nthreads * nparts, sizeof(size_t));
+	part_off = malloc((nparts + 1) * sizeof(size_t));
+	work = malloc(nthreads * sizeof(struct ht_bulk_work));
+	assert(hash && perm && counts && part_off && work);
+
+	for (p = 0; p < (size_t) nthreads; p++) {
+		work[p].h = h;
+		work[p].keys = keys;
+		work[p].vals = vals;
+		work[p].hash = hash;
+		work[p].perm = perm;
+		work[p].counts = counts;
+		work[p].part_off = part_off;
+		work[p].n = n;
+		work[p].nparts = nparts;
+		work[p].shift = slot_bits - bits;
+		work[p].worker = p;
+		work[p].nthreads = nthreads;
+	}
+
+	ht_bulk_run(work, nthreads, ht_bulk_hash);
+
+	/*
+	 * Turn counts into scatter offsets: partition by partition,
+	 * and within one, worker by worker, so input order is kept.
+	 */
+	sum = 0;
+	for (p = 0; p < nparts; p++) {
+		part_off[p] = sum;
+		for (i = 0; i < nthreads; i++) {
+			cnt = counts[i * nparts + p];
+			counts[i * nparts + p] = sum;
+			sum += cnt;
+		}
+	}
+	part_off[nparts] = sum;
+
+	ht_bulk_run(work, nthreads, ht_bulk_scatter);
+
+	if (h->arena != NULL) {
+		for (p = 0; p < (size_t) nthreads; p++) {
+			work[p].worker = 0;
+			work[p].nthreads = 1;
+		}
+		ht_bulk_fill(&work[0]);
+	} else {
+		ht_bulk_run(work, nthreads, ht_bulk_fill);
+	}
+
+	h->nmemb = n;
+
+	if (h->bloom != NULL)
+		ht_bloom_rebuild(h, h->bloom->bits_per_key);
+
+	free(hash);
+	free(perm);
+	free(counts);
+	free(part_off);
+	free(work);
+}
+
+/*
+ * Print a table of linked lists.
+ *
+ * @table:     Table of linked lists
+ * @tot_slots: Total slots in table
+ * @type:      Type of hash table
+ */
+static void ht_print_table(struct ll **table, size_t tot_slots, int type)
 {
 	int i;
 	struct ht_data *data;
@@ -395,10 +1739,10 @@ void ht_print(struct ht *h, int type)
 	char *key_s;
 	char *val_s;
 
-	for (i = 0; i < h->tot_slots; i++) {
+	for (i = 0; i < tot_slots; i++) {
 		printf("==> Linked list in slot [%d] <==\n", i);
-		if (h->table[i] != NULL) {
-			lln = h->table[i]->head;
+		if (table[i] != NULL) {
+			lln = table[i]->head;
 			while (lln != NULL) {
 				data = (struct ht_data *) (lln->val);
 
@@ -437,3 +1781,18 @@ void ht_print(struct ht *h, int type)
 	}
 }
 
+/*
+ * Print hash table.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void ht_print(struct ht *h, int type)
+{
+	ht_print_table(h->table, h->tot_slots, type);
+
+	if (h->new_table != NULL) {
+		printf("==> Growing into table of %lu slots <==\n",
+		       (unsigned long) h->new_tot_slots);
+		ht_print_table(h->new_table, h->new_tot_slots, type);
+	}
+}
@@ -2,7 +2,7 @@
  * heap.c: Heap implementation
  *
  * St: 2016-09-26 Mon 09:20 PM
- * Up: 2016-10-04 Tue 08:55 PM
+ * Up: 2026-10-17 Sat 08:39 AM
  *
  * Author: SPS
  *
@@ -39,21 +39,32 @@
 
 #define SKIP
 
+/* Is pointer p inside a block of size bytes */
+#define Hp_in_block(p, block, size) \
+	((uintptr_t) (p) - (uintptr_t) (block) < (size))
+
 
 /*
- * Swap two elements of an array of struct hp_data pointers.
+ * Swap two elements of the heap array, and update the positions
+ * of their handles.
  *
- * @arr:  Array of void pointers
+ * @h:    Pointer to the heap structure
  * @pos1: Position of first element
  * @pos2: Position of second element 
  */
-static void swap(struct hp_data **arr, int pos1, int pos2)
+static void swap(struct heap *h, int pos1, int pos2)
 {
 	struct hp_data *tmp;
+	struct hp_data **arr;
+
+	arr = h->hparr;
 
 	tmp = arr[pos1];
 	arr[pos1] = arr[pos2];
 	arr[pos2] = tmp;
+
+	h->hpos[Hp_hslot(arr[pos1]->handle)] = pos1;
+	h->hpos[Hp_hslot(arr[pos2]->handle)] = pos2;
 }
 
 /*
@@ -97,6 +108,21 @@ struct heap *hp_create(size_t cap, char type,
 	h->k_dval = k_dval;
 	h->v_dval = v_dval;
 
+	h->hcap = (cap > 0) ? cap : 1;
+	h->hpos = malloc(h->hcap * sizeof(int));
+	h->hgen = calloc(h->hcap, 1);
+	h->hfree = malloc(h->hcap * sizeof(int));
+	assert(h->hpos && h->hgen && h->hfree);
+	h->nfree = 0;
+	h->hnext = 0;
+	h->slab = NULL;
+	h->nslab = 0;
+	h->spare = NULL;
+	h->kblock = NULL;
+	h->kblock_size = 0;
+	h->vblock = NULL;
+	h->vblock_size = 0;
+
 	return h;
 }
 
@@ -114,7 +140,7 @@ static void hp_float_down_min(struct heap *h, int pos)
 		    h->k_cmp(h->hparr[Child(pos, 1)]->key, h->hparr[smallest]->key) < 0)
 		 	smallest = Child(pos, 1);
 		if (smallest != pos) {
-			swap(h->hparr, pos, smallest);
+			swap(h, pos, smallest);
 			pos = smallest;
 		} else {
 			break;
@@ -136,7 +162,7 @@ static void hp_float_down_max(struct heap *h, int pos)
 		    h->k_cmp(h->hparr[Child(pos, 1)]->key, h->hparr[largest]->key) > 0)
 		 	largest = Child(pos, 1);
 		if (largest != pos) {
-			swap(h->hparr, pos, largest);
+			swap(h, pos, largest);
 			pos = largest;
 		} else {
 			break;
@@ -172,12 +198,12 @@ static void hp_float_up(struct heap *h, int pos)
 
 	if (h->type == MIN_HEAP) {
 		while (pos > 0 && h->k_cmp(hparr[Parent(pos)]->key, hparr[pos]->key) > 0) {
-			swap(hparr, Parent(pos), pos);
+			swap(h, Parent(pos), pos);
 			pos = Parent(pos);
 		}
 	} else {
 		while (pos > 0 && h->k_cmp(hparr[Parent(pos)]->key, hparr[pos]->key) < 0) {
-			swap(hparr, Parent(pos), pos);
+			swap(h, Parent(pos), pos);
 			pos = Parent(pos);
 		}
 	}
@@ -196,13 +222,285 @@ static void hp_grow(struct heap *h)
 }
 
 /*
- * Insert a new element to heap.
+ * Create a heap of n members, all made in one slab, member i with
+ * handle i at position i. The caller fills in their keys and vals,
+ * and then calls hp_heapify.
+ *
+ * @cap:  Capacity of the heap; raised to n if smaller
+ * @type: MIN_HEAP or MAX_HEAP
+ * @n:    Number of members
+ * @k_cpy, @v_cpy, @k_cmp, @v_cmp, @k_dval, @v_dval: As hp_create
+ */
+static struct heap *hp_create_slab(size_t cap, char type, size_t n,
+                                   void *(*k_cpy)(void *),
+                                   void *(*v_cpy)(void *),
+                                   int (*k_cmp)(void *, void *),
+                                   int (*v_cmp)(void *, void *),
+                                   void (*k_dval)(void *),
+                                   void (*v_dval)(void *))
+{
+	struct heap *h;
+	size_t i;
+
+	if (cap < n)
+		cap = n;
+
+	h = hp_create(cap, type, k_cpy, v_cpy, k_cmp, v_cmp,
+	              k_dval, v_dval);
+
+	if (n == 0)
+		return h;
+
+	assert(n <= (size_t) 1 << HP_HSLOT_BITS);
+	h->slab = malloc(n * sizeof(struct hp_data));
+	assert(h->slab);
+	h->nslab = n;
+
+	for (i = 0; i < n; i++) {
+		h->slab[i].handle = i;
+		h->hparr[i] = &h->slab[i];
+		h->hpos[i] = i;
+	}
+	h->nmemb = n;
+	h->hnext = n;
+
+	return h;
+}
+
+/*
+ * Give the heap property to the whole heap array in O(n), by
+ * Floyd's bottom up heapify: float down every parent, last one
+ * first.
  *
  * @h: Pointer to the heap structure
- * @k_val: Pointer to the key of new element to be inserted
- * @v_val: Pointer to the value new element to be inserted
  */
-void hp_insert(struct heap *h, void *k_val, void *v_val)
+static void hp_heapify(struct heap *h)
+{
+	size_t i;
+
+	for (i = h->nmemb / 2; i > 0; i--)
+		hp_float_down(h, i - 1);
+}
+
+/*
+ * Build a heap from arrays of keys and values in O(n), by Floyd's
+ * bottom up heapify, instead of n calls to hp_insert. Member i
+ * gets handle i. All members are made in one slab, so the build
+ * does a fixed number of allocations whatever n is.
+ *
+ * With HP_COPY, keys and values are copied with k_cpy and v_cpy.
+ * With HP_ADOPT, the heap takes over the keys and values as they
+ * are, and frees them with k_dval and v_dval later; nothing is
+ * copied. The keys and vals arrays themselves stay the caller's.
+ * NULL values are kept as NULL in both modes.
+ *
+ * @cap:  Capacity of the heap; raised to n if smaller
+ * @type: MIN_HEAP or MAX_HEAP
+ * @keys: Array of n keys
+ * @vals: Array of n values, or NULL for all NULL values
+ * @n:    Number of members
+ * @mode: HP_COPY or HP_ADOPT
+ * @k_cpy, @v_cpy, @k_cmp, @v_cmp, @k_dval, @v_dval: As hp_create
+ */
+struct heap *hp_build(size_t cap, char type,
+                      void **keys, void **vals, size_t n, int mode,
+                      void *(*k_cpy)(void *),
+                      void *(*v_cpy)(void *),
+                      int (*k_cmp)(void *, void *),
+                      int (*v_cmp)(void *, void *),
+                      void (*k_dval)(void *),
+                      void (*v_dval)(void *))
+{
+	struct heap *h;
+	struct hp_data *hpd;
+	void *val;
+	size_t i;
+
+	h = hp_create_slab(cap, type, n, k_cpy, v_cpy, k_cmp, v_cmp,
+	                   k_dval, v_dval);
+
+	for (i = 0; i < n; i++) {
+		hpd = &h->slab[i];
+		val = (vals != NULL) ? vals[i] : NULL;
+		if (mode == HP_ADOPT) {
+			hpd->key = keys[i];
+			hpd->val = val;
+		} else {
+			hpd->key = k_cpy(keys[i]);
+			hpd->val = (val != NULL) ? v_cpy(val) : NULL;
+		}
+	}
+
+	hp_heapify(h);
+
+	return h;
+}
+
+/*
+ * Build a heap in O(n) from keys and values laid out one after
+ * another in two blocks, such as plain int arrays. The heap takes
+ * over both blocks: key i and val i stay where they are, and the
+ * blocks are freed as a whole, with free, when the heap is
+ * destroyed. So the build copies nothing and does a fixed number
+ * of allocations, none per member.
+ *
+ * Keys and vals in a block are never passed to k_dval or v_dval.
+ * hp_pop_into and hp_extract_m hand out copies of them, made with
+ * k_cpy and v_cpy, as they can not be freed one by one.
+ *
+ * @cap:    Capacity of the heap; raised to n if smaller
+ * @type:   MIN_HEAP or MAX_HEAP
+ * @kblock: n keys of ksize bytes each, from malloc
+ * @ksize:  Size of a key
+ * @vblock: n vals of vsize bytes each, from malloc, or NULL for
+ *          all NULL values
+ * @vsize:  Size of a val
+ * @n:      Number of members
+ * @k_cpy, @v_cpy, @k_cmp, @v_cmp, @k_dval, @v_dval: As hp_create
+ */
+struct heap *hp_build_block(size_t cap, char type,
+                            void *kblock, size_t ksize,
+                            void *vblock, size_t vsize, size_t n,
+                            void *(*k_cpy)(void *),
+                            void *(*v_cpy)(void *),
+                            int (*k_cmp)(void *, void *),
+                            int (*v_cmp)(void *, void *),
+                            void (*k_dval)(void *),
+                            void (*v_dval)(void *))
+{
+	struct heap *h;
+	size_t i;
+
+	h = hp_create_slab(cap, type, n, k_cpy, v_cpy, k_cmp, v_cmp,
+	                   k_dval, v_dval);
+
+	h->kblock = kblock;
+	h->kblock_size = n * ksize;
+	if (vblock != NULL) {
+		h->vblock = vblock;
+		h->vblock_size = n * vsize;
+	}
+
+	for (i = 0; i < n; i++) {
+		h->slab[i].key = (char *) kblock + i * ksize;
+		h->slab[i].val = (vblock != NULL) ?
+		                 (char *) vblock + i * vsize : NULL;
+	}
+
+	hp_heapify(h);
+
+	return h;
+}
+
+/*
+ * Free a key of the heap, unless it is in the key block.
+ *
+ * @h:   Pointer to the heap structure
+ * @key: Key to free
+ */
+static void hp_key_free(struct heap *h, void *key)
+{
+	if (!Hp_in_block(key, h->kblock, h->kblock_size))
+		h->k_dval(key);
+}
+
+/*
+ * Free a val of the heap, unless it is in the val block.
+ *
+ * @h:   Pointer to the heap structure
+ * @val: Val to free
+ */
+static void hp_val_free(struct heap *h, void *val)
+{
+	if (!Hp_in_block(val, h->vblock, h->vblock_size))
+		h->v_dval(val);
+}
+
+/*
+ * Free a member; those made by hp_build are freed with the slab.
+ * Members in use are recycled with hp_data_put instead.
+ *
+ * @h:   Pointer to the heap structure
+ * @hpd: Member to free
+ */
+static void hp_data_free(struct heap *h, struct hp_data *hpd)
+{
+	if (hpd >= h->slab && hpd < h->slab + h->nslab)
+		return;
+
+	free(hpd);
+}
+
+/*
+ * Keep an unused member for the next hp_insert. Spare members are
+ * linked through their key.
+ *
+ * @h:   Pointer to the heap structure
+ * @hpd: Member no longer in the heap
+ */
+static void hp_data_put(struct heap *h, struct hp_data *hpd)
+{
+	hpd->key = h->spare;
+	h->spare = hpd;
+}
+
+/*
+ * Get a member for hp_insert: a spare one if any, else a new one.
+ *
+ * @h: Pointer to the heap structure
+ */
+static struct hp_data *hp_data_get(struct heap *h)
+{
+	struct hp_data *hpd;
+
+	if (h->spare == NULL) {
+		hpd = malloc(sizeof(struct hp_data));
+		assert(hpd);
+	} else {
+		hpd = h->spare;
+		h->spare = hpd->key;
+	}
+
+	return hpd;
+}
+
+/*
+ * Get a handle for a new member: a free slot if any, else a new
+ * one, with the slot's current generation.
+ *
+ * @h: Pointer to the heap structure
+ */
+static int hp_handle_new(struct heap *h)
+{
+	int slot;
+
+	if (h->nfree > 0) {
+		slot = h->hfree[--h->nfree];
+	} else {
+		if (h->hnext == h->hcap) {
+			h->hcap *= GROWTH_RATE;
+			h->hpos = realloc(h->hpos, h->hcap * sizeof(int));
+			h->hgen = realloc(h->hgen, h->hcap);
+			h->hfree = realloc(h->hfree, h->hcap * sizeof(int));
+			assert(h->hpos && h->hgen && h->hfree);
+		}
+		assert(h->hnext < (size_t) 1 << HP_HSLOT_BITS);
+		slot = h->hnext++;
+		h->hgen[slot] = 0;
+	}
+
+	return slot | (h->hgen[slot] << HP_HSLOT_BITS);
+}
+
+/*
+ * Insert a key and val, as they are, into the heap. Return the
+ * handle of the new element.
+ *
+ * @h:   Pointer to the heap structure
+ * @key: Key, now owned by the heap
+ * @val: Val, now owned by the heap
+ */
+static int hp_insert_data(struct heap *h, void *key, void *val)
 {
 	struct hp_data *hpd_new;
 
@@ -212,17 +510,105 @@ void hp_insert(struct heap *h, void *k_val, void *v_val)
 	if (h->nmemb == h->cap)
 		hp_grow(h);
 
-	hpd_new = malloc(sizeof(struct hp_data));
-	assert(hpd_new);
+	hpd_new = hp_data_get(h);
 
-	hpd_new->key = h->k_cpy(k_val);
-	hpd_new->val = h->v_cpy(v_val);
+	hpd_new->key = key;
+	hpd_new->val = val;
+	hpd_new->handle = hp_handle_new(h);
 
 	h->hparr[h->nmemb] = hpd_new;
+	h->hpos[Hp_hslot(hpd_new->handle)] = h->nmemb;
 
 	hp_float_up(h, h->nmemb);
 
 	h->nmemb++;
+
+	return hpd_new->handle;
+}
+
+/*
+ * Insert a new element to heap. Return the handle of the new
+ * element, which hp_get_pos, hp_update_key and hp_remove take.
+ *
+ * @h: Pointer to the heap structure
+ * @k_val: Pointer to the key of new element to be inserted
+ * @v_val: Pointer to the value new element to be inserted
+ */
+int hp_insert(struct heap *h, void *k_val, void *v_val)
+{
+	return hp_insert_data(h, h->k_cpy(k_val), h->v_cpy(v_val));
+}
+
+/*
+ * Insert a new element, moving the key and val into the heap
+ * instead of copying them. The heap owns them from here on, and
+ * frees them with k_dval and v_dval; they must be freeable so,
+ * such as those handed out by hp_pop_into. Return the handle of
+ * the new element.
+ *
+ * A loop of hp_pop_into and hp_insert_owned moves the same key,
+ * val and hp_data around, and allocates nothing.
+ *
+ * @h:   Pointer to the heap structure
+ * @key: Key of the new element
+ * @val: Val of the new element
+ */
+int hp_insert_owned(struct heap *h, void *key, void *val)
+{
+	return hp_insert_data(h, key, val);
+}
+
+/*
+ * Take the element at a position out of the heap, and restore
+ * heap property. Its handle slot is freed for reuse, with the next
+ * generation, so the old handle no longer finds it. Return the
+ * element, whose key and val are left alone.
+ *
+ * 1. Swap the element with last memb.
+ * 2. Update h->nmemb by reducing 1.
+ * 3. Float the memb now at pos up or down, as its key may be
+ *    on either side of its new neighbours.
+ *
+ * @h:   Pointer to the heap structure
+ * @pos: Position of the element
+ */
+static struct hp_data *hp_unlink_at(struct heap *h, int pos)
+{
+	int slot;
+	struct hp_data *hpd;
+
+	swap(h, pos, h->nmemb - 1);
+
+	hpd = h->hparr[h->nmemb - 1];
+	slot = Hp_hslot(hpd->handle);
+	h->hpos[slot] = -1;
+	h->hgen[slot] = (h->hgen[slot] + 1) & HP_HGEN_MASK;
+	h->hfree[h->nfree++] = slot;
+	h->nmemb--;
+
+	if (pos < h->nmemb) {
+		slot = Hp_hslot(h->hparr[pos]->handle);
+		hp_float_up(h, pos);
+		hp_float_down(h, h->hpos[slot]);
+	}
+
+	return hpd;
+}
+
+/*
+ * Remove the element at a position, freeing its key and val.
+ *
+ * @h:   Pointer to the heap structure
+ * @pos: Position of the element
+ */
+static void hp_delete_at(struct heap *h, int pos)
+{
+	struct hp_data *hpd;
+
+	hpd = hp_unlink_at(h, pos);
+	hp_key_free(h, hpd->key);
+	hp_val_free(h, hpd->val);
+	hp_data_put(h, hpd);
 }
 
 /*
@@ -244,12 +630,76 @@ void *hp_find_m(struct heap *h)
 		retval = malloc(sizeof(struct hp_data));
 		assert(retval);
 		retval->key = h->k_cpy(h->hparr[0]->key);
-		retval->val = h->k_cpy(h->hparr[0]->val);
+		retval->val = h->v_cpy(h->hparr[0]->val);
+		retval->handle = h->hparr[0]->handle;
 	}
 
 	return retval;
 }
 
+/*
+ * Get the min/max key and val without copying them. Return 1,
+ * or 0 if the heap is empty. The pointers are into the heap, and
+ * are good until the heap next changes.
+ *
+ * @h:   Pointer to the heap structure
+ * @key: Gets the key, if not NULL
+ * @val: Gets the val, if not NULL
+ */
+int hp_peek_ref(struct heap *h, const void **key, const void **val)
+{
+	if (hp_is_empty(h) == 1)
+		return 0;
+
+	if (key)
+		*key = h->hparr[0]->key;
+	if (val)
+		*val = h->hparr[0]->val;
+
+	return 1;
+}
+
+/*
+ * Remove the min/max element and move its key and val to the
+ * caller, who then owns them and frees them with k_dval/v_dval.
+ * A key or val not asked for (NULL) is freed here. Nothing is
+ * copied, but for keys and vals in a block of hp_build_block, and
+ * the element's hp_data is kept for the next insert.
+ * Return 1, or 0 if the heap is empty.
+ *
+ * @h:   Pointer to the heap structure
+ * @key: Gets the key, if not NULL
+ * @val: Gets the val, if not NULL
+ */
+int hp_pop_into(struct heap *h, void **key, void **val)
+{
+	struct hp_data *hpd;
+
+	if (hp_is_empty(h) == 1)
+		return 0;
+
+	hpd = hp_unlink_at(h, 0);
+
+	/* Keys and vals in a block can not be handed out, only copies */
+	if (key == NULL)
+		hp_key_free(h, hpd->key);
+	else if (Hp_in_block(hpd->key, h->kblock, h->kblock_size))
+		*key = h->k_cpy(hpd->key);
+	else
+		*key = hpd->key;
+
+	if (val == NULL)
+		hp_val_free(h, hpd->val);
+	else if (Hp_in_block(hpd->val, h->vblock, h->vblock_size))
+		*val = h->v_cpy(hpd->val);
+	else
+		*val = hpd->val;
+
+	hp_data_put(h, hpd);
+
+	return 1;
+}
+
 /*
  * Extract the min/max value from heap. This removes
  * the min/max value from heap, and as a result of
@@ -264,29 +714,11 @@ void *hp_extract_m(struct heap *h)
 	if (hp_is_empty(h) == 1) {
 		retval = NULL;
 	} else {
-		/* Make a copy of the min/max val */
+		/* Move the min/max key and val out of the heap */
 		retval = malloc(sizeof(struct hp_data));
 		assert(retval);
-		retval->key = h->k_cpy(h->hparr[0]->key);
-		retval->val = h->k_cpy(h->hparr[0]->val);
-
-		/* 
-		 * Remove the min/max val from heap.
-		 *
-		 * 1. Swap the min/max val with last 
-		 *    memb.
-		 * 2. Free the memory occupied by 
-		 *    min/max val.
-		 * 3. Update h->nmemb by reducing 1.
-		 * 4. Float down from index 0 to
-		 *    maintain heap property.
-		 */
-		swap(h->hparr, 0, h->nmemb-1);
-		h->k_dval(h->hparr[h->nmemb-1]->key);
-		h->v_dval(h->hparr[h->nmemb-1]->val);
-		free(h->hparr[h->nmemb-1]);
-		h->nmemb--;
-		hp_float_down(h, 0);
+		retval->handle = h->hparr[0]->handle;
+		hp_pop_into(h, &retval->key, &retval->val);
 	}
 
 	return retval;
@@ -352,66 +784,138 @@ void hp_print(struct heap *h)
 void hp_destroy(struct heap *h)
 {
 	int i;
+	struct hp_data *hpd;
 
 	assert(h);
 
 	for (i = 0; i < h->nmemb; i++) {
 		if (h->hparr[i] != NULL) {
-			h->k_dval(h->hparr[i]->key);
-			h->v_dval(h->hparr[i]->val);
-			free(h->hparr[i]);
+			hp_key_free(h, h->hparr[i]->key);
+			hp_val_free(h, h->hparr[i]->val);
+			hp_data_free(h, h->hparr[i]);
 		}
 	}
 
+	while (h->spare != NULL) {
+		hpd = h->spare;
+		h->spare = hpd->key;
+		hp_data_free(h, hpd);
+	}
+
+	free(h->slab);
+	free(h->kblock);
+	free(h->vblock);
 	free(h->hparr);
+	free(h->hpos);
+	free(h->hgen);
+	free(h->hfree);
 	free(h);
 }
 
 /*
- * Make a copy of heap, and return a pointer to this copy.
- * This makes a copy of the hparr as well.
- * This makes a copy of elements of hparr as well.
+ * Find out if member a comes out of the heap before member b.
  *
- * @h: Pointer to heap structure whose copy is to be made
+ * @h: Pointer to the heap structure
+ * @a: First member
+ * @b: Second member
  */
-static struct heap *hp_copy(struct heap *hsrc) 
+static int hp_first(struct heap *h, struct hp_data *a, struct hp_data *b)
 {
-	int i;
-	struct hp_data **hpcpyarr;
-	struct heap *hcpy;
-	
-	/* Make a copy of the structure. This is a shallow copy. */
-	hcpy = malloc(sizeof(struct heap));
-	assert(hcpy);
-	hcpy = memcpy(hcpy, hsrc, sizeof(struct heap));
-
-	/* Make hcpy->hparr point to its own array in memory */
-	hcpy->hparr = calloc(hcpy->nmemb, sizeof(struct hp_data *));
-	assert(hcpy->hparr);
-	hpcpyarr = hcpy->hparr;
-
-	/* Make copies of each element in hsrc->hparr */
-	for (i = 0; i < hcpy->nmemb; i++) {
-		hpcpyarr[i] = malloc(sizeof(struct hp_data));
-		assert(hpcpyarr[i]);
-		hpcpyarr[i]->key = hcpy->k_cpy(hsrc->hparr[i]->key);
-		hpcpyarr[i]->val = hcpy->v_cpy(hsrc->hparr[i]->val);
+	int cmp;
+
+	cmp = h->k_cmp(a->key, b->key);
+
+	return (h->type == MIN_HEAP) ? cmp < 0 : cmp > 0;
+}
+
+/*
+ * Float a member down the first n members of an array, without
+ * touching the handle positions.
+ *
+ * @h:   Pointer to the heap structure
+ * @arr: Array in heap order
+ * @n:   Members of arr in the heap
+ * @pos: Position of the member to float down
+ */
+static void hp_arr_sift_down(struct heap *h, struct hp_data **arr,
+                             size_t n, size_t pos)
+{
+	struct hp_data *hpd;
+	size_t c;
+
+	hpd = arr[pos];
+
+	while ((c = Child(pos, 0)) < n) {
+		if (c + 1 < n && hp_first(h, arr[c + 1], arr[c]))
+			c++;
+		if (!hp_first(h, arr[c], hpd))
+			break;
+		arr[pos] = arr[c];
+		pos = c;
+	}
+
+	arr[pos] = hpd;
+}
+
+/*
+ * Heapsort an array that is in heap order, into the order the
+ * members would be extracted in. Takes no extra memory.
+ *
+ * Moving the root to the end of a shrinking heap gives the
+ * reverse of extraction order, so the array is reversed last.
+ *
+ * @h:   Pointer to the heap structure
+ * @arr: Array in heap order
+ * @n:   Members of arr
+ */
+static void hp_arr_sort(struct heap *h, struct hp_data **arr, size_t n)
+{
+	struct hp_data *tmp;
+	size_t i;
+
+	for (i = n; i > 1; i--) {
+		tmp = arr[0];
+		arr[0] = arr[i - 1];
+		arr[i - 1] = tmp;
+		hp_arr_sift_down(h, arr, i - 1, 0);
+	}
+
+	for (i = 0; i < n / 2; i++) {
+		tmp = arr[i];
+		arr[i] = arr[n - 1 - i];
+		arr[n - 1 - i] = tmp;
 	}
+}
 
-	return hcpy;
+/*
+ * Sort the heap array in place, into extraction order, so that
+ * h->hparr[0] to h->hparr[nmemb - 1] can be read in order. A
+ * sorted array is still a valid heap, so the heap stays usable.
+ * No memory is allocated.
+ *
+ * @h: Pointer to the heap structure
+ */
+void hp_sort_inplace(struct heap *h)
+{
+	size_t i;
+
+	hp_arr_sort(h, h->hparr, h->nmemb);
+
+	for (i = 0; i < h->nmemb; i++)
+		h->hpos[Hp_hslot(h->hparr[i]->handle)] = i;
 }
 
 /*
  * Make a sorted array using heap contents. Return pointer
  * to this sorted array.
  *
- * To do this, first a copy of original heap is made. Then 
- * this copy-heap is used to create the sorted array. This
- * is done by continuously extracting the min/max element
- * from the copy-heap untill the copy-heap is empty.
+ * The array gets a copy of each member of the heap, and is then
+ * heapsorted in place; being a copy of the heap array, it is
+ * already in heap order. The original heap is not altered in
+ * any way.
  *
- * Copy of the original heap is made so that the original
- * heap is not altered in any way.
+ * To read a heap in order without copies, use hp_sort_inplace;
+ * to consume it in order, use hp_drain_next.
  *
  * @h: Pointer to heap structure
  */
@@ -419,31 +923,83 @@ struct hp_data **get_sorted_arr(struct heap *h)
 {
 	int i;
 	struct hp_data **arr;
-	struct heap *hcpy;
 
 	/* Allocate memory for array */
 	arr = malloc(h->nmemb * sizeof(struct hp_data *));
 	assert(arr);
-	
-	/* Make a temporary copy of original heap */
-	hcpy = hp_copy(h);
 
-	/*
-	 * Fill the array from the copy-heap such
-	 * that the array is sorted
-	 */
-	i = 0;
-	while (!hp_is_empty(hcpy)) {
-		arr[i] = hp_extract_m(hcpy);
-		i++;
+	/* Copy each member */
+	for (i = 0; i < h->nmemb; i++) {
+		arr[i] = malloc(sizeof(struct hp_data));
+		assert(arr[i]);
+		arr[i]->key = h->k_cpy(h->hparr[i]->key);
+		arr[i]->val = h->v_cpy(h->hparr[i]->val);
+		arr[i]->handle = h->hparr[i]->handle;
 	}
 
-	/* Destroy the temporary copy-heap */
-	hp_destroy(hcpy);
+	hp_arr_sort(h, arr, h->nmemb);
 
 	return arr;
 }
 
+/*
+ * Start draining a heap: taking its members out in order, one
+ * hp_drain_next at a time, without building an array.
+ *
+ * @h:  Pointer to the heap structure
+ * @it: Pointer to the cursor to set up
+ */
+void hp_drain_begin(struct heap *h, struct hp_drain *it)
+{
+	it->h = h;
+	it->cur = NULL;
+}
+
+/*
+ * Take the next member out of the heap. Pointers to its key and
+ * val are put in *key and *val; they stay good until the next
+ * call, which frees them. Return 1 if there was a member, 0 when
+ * the heap is empty. A drain stopped early must be ended with
+ * hp_drain_end.
+ *
+ * @it:  Pointer to the cursor
+ * @key: Set to key of the member, may be NULL
+ * @val: Set to val of the member, may be NULL
+ */
+int hp_drain_next(struct hp_drain *it, void **key, void **val)
+{
+	hp_drain_end(it);
+
+	if (hp_is_empty(it->h) == 1)
+		return 0;
+
+	it->cur = hp_unlink_at(it->h, 0);
+
+	if (key)
+		*key = it->cur->key;
+	if (val)
+		*val = it->cur->val;
+
+	return 1;
+}
+
+/*
+ * Free the member last given by hp_drain_next. The rest of the
+ * heap is left as it is.
+ *
+ * @it: Pointer to the cursor
+ */
+void hp_drain_end(struct hp_drain *it)
+{
+	if (it->cur == NULL)
+		return;
+
+	hp_key_free(it->h, it->cur->key);
+	hp_val_free(it->h, it->cur->val);
+	hp_data_put(it->h, it->cur);
+	it->cur = NULL;
+}
+
 /*
  * Test if array is sorted.
  *
@@ -502,7 +1058,7 @@ void hp_decrease_key(struct heap *h, int pos, void *newkey)
 		return;
 
 	/* Free old val and copy new val */
-	h->k_dval(h->hparr[pos]->key);
+	hp_key_free(h, h->hparr[pos]->key);
 	h->hparr[pos]->key = h->k_cpy(newkey);
 
 	/* Float up to preserve heap property */
@@ -561,3 +1117,81 @@ int hp_get_index_val(struct heap *h, void *val)
 	return retval;
 }
 
+/*
+ * Get position in the heap array of the element with a handle.
+ * Returns -1 if the handle is not in the heap (never given out,
+ * or its element was removed or popped), also after its slot went
+ * to a new element, as long as the slot has not been reused 2^7
+ * times since.
+ *
+ * @h:      Pointer to the heap structure
+ * @handle: Handle returned by hp_insert
+ */
+int hp_get_pos(struct heap *h, int handle)
+{
+	int slot;
+
+	if (handle < 0)
+		return -1;
+
+	slot = Hp_hslot(handle);
+	if ((size_t) slot >= h->hnext || h->hgen[slot] != Hp_hgen(handle))
+		return -1;
+
+	return h->hpos[slot];
+}
+
+/*
+ * Find out if the element with a handle is in the heap.
+ *
+ * @h:      Pointer to the heap structure
+ * @handle: Handle returned by hp_insert
+ */
+int hp_contains(struct heap *h, int handle)
+{
+	return hp_get_pos(h, handle) >= 0;
+}
+
+/*
+ * Change the key of the element with a handle, to a key on either
+ * side of the old one, and restore heap property. O(log n).
+ *
+ * @h:      Pointer to the heap structure
+ * @handle: Handle returned by hp_insert
+ * @newkey: New key of the element
+ */
+void hp_update_key(struct heap *h, int handle, void *newkey)
+{
+	int pos;
+	int cmp;
+
+	pos = hp_get_pos(h, handle);
+	assert(pos >= 0);
+
+	cmp = h->k_cmp(newkey, h->hparr[pos]->key);
+
+	hp_key_free(h, h->hparr[pos]->key);
+	h->hparr[pos]->key = h->k_cpy(newkey);
+
+	/* Towards the root if it now comes first, else away from it */
+	if ((h->type == MIN_HEAP) == (cmp < 0))
+		hp_float_up(h, pos);
+	else
+		hp_float_down(h, pos);
+}
+
+/*
+ * Remove the element with a handle from the heap. O(log n).
+ * Has no effect if the handle is not in the heap.
+ *
+ * @h:      Pointer to the heap structure
+ * @handle: Handle returned by hp_insert
+ */
+void hp_remove(struct heap *h, int handle)
+{
+	int pos;
+
+	pos = hp_get_pos(h, handle);
+	if (pos >= 0)
+		hp_delete_at(h, pos);
+}
@@ -0,0 +1,582 @@
+/*
+ * lf_hash_table.c: Lock free (split ordered) hash table in C
+ *
+ * St: 2026-10-17 Sat 07:12 AM
+ * Up: 2026-10-17 Sat 07:12 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * This follows "Split-Ordered Lists: Lock-Free Extensible Hash
+ * Tables" by Shalev and Shavit. All members are kept in one lock
+ * free linked list (Harris/Michael), sorted by the bit reversal of
+ * their hash (the split order key). In that order, the members of
+ * bucket b (hash & (tot_slots - 1) == b) are contiguous, and when the
+ * table doubles, bucket b splits into b and b + tot_slots without
+ * any member moving.
+ *
+ * Every bucket starts with a sentinel node whose split order key is
+ * the bit reversal of b. Bucket pointers are set lazily: the first
+ * thread to use bucket b inserts its sentinel, starting from the
+ * sentinel of the parent bucket (b with its top bit cleared). Growing
+ * the table is then only a CAS on tot_slots.
+ *
+ * Regular nodes get the top hash bit set before reversal, so their
+ * split order keys are odd and sentinels' are even, and a sentinel
+ * sorts before every member of its bucket.
+ *
+ * Deleting marks the low bit of the node's next pointer (logical
+ * delete), then unlinks it. Whoever unlinks a node retires it to the
+ * table's ebr, so readers that still hold the node never see it
+ * freed. Every operation runs inside an ebr critical section.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<stdatomic.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/* Low bit of next pointer marks a deleted node */
+#define LFHT_MARK ((uintptr_t) 1)
+
+#define Is_marked(p)  ((p) & LFHT_MARK)
+#define Unmarked(p)   ((struct lfht_node *) ((p) & ~LFHT_MARK))
+
+/*
+ * Reverse the bits of a 64 bit value.
+ *
+ * @x: Value to reverse
+ */
+static uint64_t lfht_reverse(uint64_t x)
+{
+	x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+	x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+	x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+	x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+
+	return (x >> 32) | (x << 32);
+}
+
+/*
+ * Return position of the highest set bit of a non zero value.
+ *
+ * @x: Value
+ */
+static int lfht_log2(uint64_t x)
+{
+	int n;
+
+	for (n = 0; x > 1; n++)
+		x >>= 1;
+
+	return n;
+}
+
+/*
+ * Hash function.
+ *
+ * @h:   Pointer to the hash table structure. Needed to get
+ *       the key size.
+ * @key: Key whose hash value is to be calculated
+ */
+static uint64_t lfht_hash_func(struct lfht *h, void *key)
+{
+	return hash_key(key, h->get_key_size(key), HASH_SEED);
+}
+
+/*
+ * Allocate a node.
+ *
+ * @so_key: Split order key
+ * @key:    Key, NULL for sentinel
+ * @val:    Val
+ * @hash:   Hash of key
+ */
+static struct lfht_node *lfht_node_create(uint64_t so_key, void *key,
+                                          void *val, uint64_t hash)
+{
+	struct lfht_node *node;
+
+	node = malloc(sizeof(struct lfht_node));
+	assert(node);
+
+	node->so_key = so_key;
+	node->key = key;
+	atomic_init(&node->val, val);
+	node->hash = hash;
+	atomic_init(&node->next, 0);
+
+	return node;
+}
+
+/*
+ * Free a regular node with its key and val. Used as ebr free
+ * function, so must not need the table.
+ *
+ * @ptr: Pointer to the node
+ */
+static void lfht_node_free(void *ptr)
+{
+	struct lfht_node *node;
+
+	node = ptr;
+
+	free(node->key);
+	free(atomic_load(&node->val));
+	free(node);
+}
+
+/*
+ * Return the directory slot holding the sentinel pointer of a
+ * bucket, allocating its segment if needed. Segment 0 holds bucket
+ * 0, segment s > 0 holds buckets 2^(s-1) .. 2^s - 1.
+ *
+ * @h: Pointer to the hash table structure
+ * @b: Bucket index
+ */
+static struct lfht_node *_Atomic *lfht_bucket_slot(struct lfht *h, size_t b)
+{
+	int s;
+	size_t off;
+	size_t seg_size;
+	struct lfht_node *_Atomic *seg;
+	struct lfht_node *_Atomic *expected;
+
+	if (b == 0) {
+		s = 0;
+		off = 0;
+		seg_size = 1;
+	} else {
+		s = lfht_log2(b) + 1;
+		seg_size = (size_t) 1 << (s - 1);
+		off = b - seg_size;
+	}
+
+	seg = atomic_load(&h->seg[s]);
+	if (seg == NULL) {
+		seg = calloc(seg_size, sizeof(struct lfht_node *));
+		assert(seg);
+		expected = NULL;
+		if (!atomic_compare_exchange_strong(&h->seg[s], &expected, seg)) {
+			/* Another thread got there first */
+			free(seg);
+			seg = expected;
+		}
+	}
+
+	return &seg[off];
+}
+
+/*
+ * Find the position for split order key `so_key' in the list,
+ * starting at `head'. On return *prevp is the link that points (or
+ * would point) to the node, and *curp the first node not before it.
+ * Return 1 if a matching node was found; a sentinel matches on
+ * `so_key' alone, a regular node also needs k_cmp to say equal.
+ *
+ * Deleted nodes met on the way are unlinked and retired.
+ *
+ * @h:      Pointer to the hash table structure
+ * @head:   Sentinel to start from
+ * @so_key: Split order key to find
+ * @key:    Key to find, NULL when finding a sentinel
+ * @prevp:  Set to the link before the position
+ * @curp:   Set to the node at the position
+ */
+static int lfht_find(struct lfht *h, struct lfht_node *head, uint64_t so_key,
+                     void *key, _Atomic uintptr_t **prevp,
+		     struct lfht_node **curp)
+{
+	uintptr_t next;
+	uintptr_t expected;
+	_Atomic uintptr_t *prev;
+	struct lfht_node *cur;
+
+retry:
+	prev = &head->next;
+	cur = Unmarked(atomic_load(prev));
+
+	while (cur != NULL) {
+		next = atomic_load(&cur->next);
+
+		if (Is_marked(next)) {
+			/* Help unlink a deleted node */
+			expected = (uintptr_t) cur;
+			if (!atomic_compare_exchange_strong(prev, &expected,
+			                                    next & ~LFHT_MARK))
+				goto retry;
+			ebr_retire(h->ebr, cur, lfht_node_free);
+			cur = Unmarked(next);
+			continue;
+		}
+
+		if (cur->so_key > so_key)
+			break;
+
+		if (cur->so_key == so_key &&
+		    (key == NULL || h->k_cmp(cur->key, key) == 0)) {
+			*prevp = prev;
+			*curp = cur;
+			return 1;
+		}
+
+		prev = &cur->next;
+		cur = Unmarked(next);
+	}
+
+	*prevp = prev;
+	*curp = cur;
+
+	return 0;
+}
+
+/*
+ * Return the sentinel of a bucket, inserting it (and its parents'
+ * sentinels) if this is the first use of the bucket.
+ *
+ * @h: Pointer to the hash table structure
+ * @b: Bucket index
+ */
+static struct lfht_node *lfht_bucket(struct lfht *h, size_t b)
+{
+	uint64_t so_key;
+	uintptr_t expected;
+	_Atomic uintptr_t *prev;
+	struct lfht_node *cur;
+	struct lfht_node *node;
+	struct lfht_node *parent;
+	struct lfht_node *_Atomic *slot;
+
+	slot = lfht_bucket_slot(h, b);
+	node = atomic_load(slot);
+	if (node != NULL)
+		return node;
+
+	/* Parent is b with its top bit cleared */
+	parent = lfht_bucket(h, b & ~((size_t) 1 << lfht_log2(b)));
+
+	so_key = lfht_reverse(b);
+	node = lfht_node_create(so_key, NULL, NULL, 0);
+
+	for (;;) {
+		if (lfht_find(h, parent, so_key, NULL, &prev, &cur)) {
+			/* Another thread inserted it, never published ours */
+			free(node);
+			node = cur;
+			break;
+		}
+		atomic_store(&node->next, (uintptr_t) cur);
+		expected = (uintptr_t) cur;
+		if (atomic_compare_exchange_strong(prev, &expected,
+		                                   (uintptr_t) node))
+			break;
+	}
+
+	atomic_store(slot, node);
+
+	return node;
+}
+
+/*
+ * Create a lock free hash table.
+ *
+ * @tot_slots:    Initial total buckets. Rounded up to a power of 2.
+ * @k_cpy:        Function to copy key
+ * @v_cpy:        Function to copy val
+ * @k_cmp:        Function to compare key
+ * @v_cmp:        Function to compare val
+ * @get_key_size: Function to get key size
+ */
+struct lfht *lfht_create(size_t tot_slots,
+                         void *(*k_cpy) (void *),
+		         void *(*v_cpy) (void *),
+		         int (*k_cmp) (void *, void *),
+		         int (*v_cmp) (void *, void *),
+		         int (*get_key_size) (void *))
+{
+	int i;
+	size_t n;
+	struct lfht *h;
+
+	h = malloc(sizeof(struct lfht));
+	assert(h);
+
+	for (i = 0; i < LFHT_MAX_SEGS; i++)
+		atomic_init(&h->seg[i], NULL);
+
+	n = 1;
+	while (n < tot_slots)
+		n *= 2;
+	atomic_init(&h->tot_slots, n);
+	atomic_init(&h->nmemb, 0);
+
+	h->ebr = ebr_create();
+
+	h->k_cpy = k_cpy;
+	h->v_cpy = v_cpy;
+
+	h->k_cmp = k_cmp;
+	h->v_cmp = v_cmp;
+
+	h->get_key_size = get_key_size;
+
+	/* Sentinel of bucket 0 is the head of the whole list */
+	atomic_store(lfht_bucket_slot(h, 0),
+	             lfht_node_create(0, NULL, NULL, 0));
+
+	return h;
+}
+
+/*
+ * Return the sentinel of the bucket of a hash.
+ *
+ * @h:    Pointer to the hash table structure
+ * @hash: Hash of a key
+ */
+static struct lfht_node *lfht_head(struct lfht *h, uint64_t hash)
+{
+	return lfht_bucket(h, hash & (atomic_load(&h->tot_slots) - 1));
+}
+
+/*
+ * Insert a new data to hash table. If the key is already present
+ * its val is replaced. Return 1 if a new member was inserted, 0 if
+ * a val was replaced.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to be inserted
+ * @val: Val of the data to be inserted
+ */
+int lfht_insert(struct lfht *h, void *key, void *val)
+{
+	int retval;
+	size_t size;
+	size_t nmemb;
+	uint64_t hash;
+	uint64_t so_key;
+	uintptr_t expected;
+	void *old_val;
+	_Atomic uintptr_t *prev;
+	struct lfht_node *cur;
+	struct lfht_node *node;
+	struct lfht_node *head;
+
+	hash = lfht_hash_func(h, key);
+	so_key = lfht_reverse(hash | ((uint64_t) 1 << 63));
+	node = NULL;
+
+	ebr_enter(h->ebr);
+
+	head = lfht_head(h, hash);
+
+	for (;;) {
+		if (lfht_find(h, head, so_key, key, &prev, &cur)) {
+			old_val = atomic_exchange(&cur->val, h->v_cpy(val));
+			ebr_retire(h->ebr, old_val, free);
+			if (node != NULL)
+				lfht_node_free(node);
+			retval = 0;
+			break;
+		}
+
+		if (node == NULL)
+			node = lfht_node_create(so_key, h->k_cpy(key),
+			                        h->v_cpy(val), hash);
+
+		atomic_store(&node->next, (uintptr_t) cur);
+		expected = (uintptr_t) cur;
+		if (atomic_compare_exchange_strong(prev, &expected,
+		                                   (uintptr_t) node)) {
+			retval = 1;
+			break;
+		}
+	}
+
+	ebr_exit(h->ebr);
+
+	/* Double the buckets if too loaded; only a CAS */
+	if (retval == 1) {
+		nmemb = atomic_fetch_add(&h->nmemb, 1) + 1;
+		size = atomic_load(&h->tot_slots);
+		if (nmemb > LFHT_MAX_LOAD * size)
+			atomic_compare_exchange_strong(&h->tot_slots, &size,
+			                               size * 2);
+	}
+
+	return retval;
+}
+
+/*
+ * Search for a data in hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to be searched
+ */
+int lfht_search(struct lfht *h, void *key)
+{
+	int retval;
+	uint64_t hash;
+	_Atomic uintptr_t *prev;
+	struct lfht_node *cur;
+
+	hash = lfht_hash_func(h, key);
+
+	ebr_enter(h->ebr);
+
+	retval = lfht_find(h, lfht_head(h, hash),
+	                   lfht_reverse(hash | ((uint64_t) 1 << 63)), key,
+	                   &prev, &cur);
+
+	ebr_exit(h->ebr);
+
+	return retval;
+}
+
+/*
+ * Get a copy of the val stored for a key, made with v_cpy. Caller
+ * owns the copy. Return NULL if key is not in the table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to get
+ */
+void *lfht_get(struct lfht *h, void *key)
+{
+	void *retval;
+	uint64_t hash;
+	_Atomic uintptr_t *prev;
+	struct lfht_node *cur;
+
+	hash = lfht_hash_func(h, key);
+	retval = NULL;
+
+	ebr_enter(h->ebr);
+
+	if (lfht_find(h, lfht_head(h, hash),
+	              lfht_reverse(hash | ((uint64_t) 1 << 63)), key,
+	              &prev, &cur))
+		retval = h->v_cpy(atomic_load(&cur->val));
+
+	ebr_exit(h->ebr);
+
+	return retval;
+}
+
+/*
+ * Delete an item from hash table. Has no effect if item is not
+ * found in the hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Pointer to key of the item to delete
+ */
+void lfht_delete(struct lfht *h, void *key)
+{
+	uint64_t hash;
+	uint64_t so_key;
+	uintptr_t next;
+	uintptr_t expected;
+	_Atomic uintptr_t *prev;
+	struct lfht_node *cur;
+	struct lfht_node *head;
+
+	hash = lfht_hash_func(h, key);
+	so_key = lfht_reverse(hash | ((uint64_t) 1 << 63));
+
+	ebr_enter(h->ebr);
+
+	head = lfht_head(h, hash);
+
+	while (lfht_find(h, head, so_key, key, &prev, &cur)) {
+		/* Logical delete: mark next pointer */
+		next = atomic_load(&cur->next);
+		if (Is_marked(next))
+			continue;
+		if (!atomic_compare_exchange_strong(&cur->next, &next,
+		                                    next | LFHT_MARK))
+			continue;
+
+		/* Physical delete; else lfht_find unlinks it */
+		expected = (uintptr_t) cur;
+		if (atomic_compare_exchange_strong(prev, &expected, next))
+			ebr_retire(h->ebr, cur, lfht_node_free);
+		else
+			lfht_find(h, head, so_key, key, &prev, &cur);
+
+		atomic_fetch_sub(&h->nmemb, 1);
+		break;
+	}
+
+	ebr_exit(h->ebr);
+}
+
+/*
+ * Return the total members count. Only a snapshot if other threads
+ * are changing the table.
+ *
+ * @h: Pointer to the hash table structure
+ */
+size_t lfht_tot_memb(struct lfht *h)
+{
+	return atomic_load(&h->nmemb);
+}
+
+/*
+ * Destroy a hash table. No other thread may be using it.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void lfht_destroy(struct lfht *h)
+{
+	int i;
+	struct lfht_node *node;
+	struct lfht_node *next;
+
+	/* Every node, sentinels included, is on the list of bucket 0 */
+	node = atomic_load(lfht_bucket_slot(h, 0));
+	while (node != NULL) {
+		next = Unmarked(atomic_load(&node->next));
+		if (node->key != NULL)
+			lfht_node_free(node);
+		else
+			free(node);
+		node = next;
+	}
+
+	for (i = 0; i < LFHT_MAX_SEGS; i++)
+		free(atomic_load(&h->seg[i]));
+
+	ebr_destroy(h->ebr);
+
+	free(h);
+}
@@ -1,7 +1,7 @@
 /* mylib.h: Header file (interface) for my C library
  *
  * St: 2016-09-26 Mon 01:47 AM
- * Up: 2016-10-09 Sun 02:34 AM
+ * Up: 2026-10-17 Sat 08:40 AM
  *
  * Author: SPS
  *
@@ -33,6 +33,11 @@
 #ifndef MYLIB_H
 #define MYLIB_H
 
+#include<stddef.h>
+#include<stdint.h>
+#include<stdatomic.h>
+#include<pthread.h>
+
 
 /*
  singly linked list stuff
@@ -253,13 +258,47 @@ void deque_print(struct deque *dek);
 struct hp_data {
 	void *key;
 	void *val;
+	int handle;                     /* Handle given by hp_insert */
 };
 
+/*
+ * Every member has a handle, returned by hp_insert, which stays the
+ * same while the member moves around the heap. hpos maps a handle
+ * to the member's position in hparr, and is kept up to date by
+ * every swap, so a member is found by handle in O(1).
+ *
+ * The low HP_HSLOT_BITS bits of a handle are a slot of hpos, and
+ * the bits above them the generation of that slot. Slots of removed
+ * members are reused by later inserts, with the next generation, so
+ * a stale handle does not match the new member; it is seen as not
+ * in the heap until its slot has been reused 2^7 times.
+ *
+ * hp_build makes all its hp_data in one slab; those are freed with
+ * the slab when the heap is destroyed, not one by one. Removed
+ * members go on the spare list and are reused by hp_insert. In the
+ * same way, hp_build_block keeps keys and vals in two blocks, which
+ * are freed whole.
+ */
 struct heap {
 	struct hp_data **hparr;         /* Array representing heap */
 	char type;                      /* Type of heap (min or max) */
 	size_t nmemb;                   /* Number of members */
 	size_t cap;                     /* Capacity -> max nmemb */
+	int *hpos;                      /* Position of each handle,
+	                                   -1 if not in heap */
+	unsigned char *hgen;            /* Generation of each slot */
+	int *hfree;                     /* Slots free for reuse */
+	size_t nfree;                   /* Total free handles */
+	size_t hnext;                   /* Handles given out so far */
+	size_t hcap;                    /* Room in hpos and hfree */
+	struct hp_data *slab;           /* Members made by hp_build */
+	size_t nslab;                   /* Total members in slab */
+	struct hp_data *spare;          /* Removed members kept for
+	                                   reuse, linked by key */
+	void *kblock;                   /* Keys of hp_build_block */
+	size_t kblock_size;             /* Bytes in kblock */
+	void *vblock;                   /* Vals of hp_build_block */
+	size_t vblock_size;             /* Bytes in vblock */
 	void *(*k_cpy)(void *);         /* Key Copy funciton */
 	void *(*v_cpy)(void *);         /* Value Copy funciton */
 	int (*k_cmp)(void *, void *);   /* Key Compare funciton */
@@ -268,11 +307,28 @@ struct heap {
 	void (*v_dval)(void *);         /* Value destroly function */   
 };
 
+/*
+ * Cursor for draining a heap in order. It lives wherever the
+ * caller puts it; only the member last handed out is held here.
+ */
+struct hp_drain {
+	struct heap *h;
+	struct hp_data *cur;            /* Member last handed out */
+};
+
 #define MIN_HEAP 1
 #define MAX_HEAP 2
 
 #define GROWTH_RATE 2
 
+#define HP_COPY 0       /* hp_build copies keys and values */
+#define HP_ADOPT 1      /* hp_build takes over keys and values */
+
+#define HP_HSLOT_BITS 24                   /* slot bits of a handle */
+#define HP_HGEN_MASK 0x7f                  /* generation bits */
+#define Hp_hslot(handle)  ((handle) & ((1 << HP_HSLOT_BITS) - 1))
+#define Hp_hgen(handle)  ((handle) >> HP_HSLOT_BITS)
+
 #define Parent(x)  (((x) - 1) / 2)
 #define Child(x, dir)  (2 * (x) + 1 + (dir))
 
@@ -284,19 +340,174 @@ struct heap *hp_create(size_t cap, char type,
 		       int (*v_cmp)(void *, void *),
 		       void (*k_dval)(void *),
 		       void (*v_dval)(void *));
-void hp_insert(struct heap *h, void *k_val, void *v_val);
+struct heap *hp_build(size_t cap, char type,
+                      void **keys, void **vals, size_t n, int mode,
+                      void *(*k_cpy)(void *),
+                      void *(*v_cpy)(void *),
+                      int (*k_cmp)(void *, void *),
+                      int (*v_cmp)(void *, void *),
+                      void (*k_dval)(void *),
+                      void (*v_dval)(void *));
+struct heap *hp_build_block(size_t cap, char type,
+                            void *kblock, size_t ksize,
+                            void *vblock, size_t vsize, size_t n,
+                            void *(*k_cpy)(void *),
+                            void *(*v_cpy)(void *),
+                            int (*k_cmp)(void *, void *),
+                            int (*v_cmp)(void *, void *),
+                            void (*k_dval)(void *),
+                            void (*v_dval)(void *));
+int hp_insert(struct heap *h, void *k_val, void *v_val);
+int hp_insert_owned(struct heap *h, void *key, void *val);
 void *hp_extract_m(struct heap *h);
 void *hp_find_m(struct heap *h);
+int hp_peek_ref(struct heap *h, const void **key, const void **val);
+int hp_pop_into(struct heap *h, void **key, void **val);
 void hp_destroy(struct heap *h);
 int hp_is_empty(struct heap *h);
 size_t hp_get_size(struct heap *h);
 void hp_print(struct heap *h);
 struct hp_data **get_sorted_arr(struct heap *h);
+void hp_sort_inplace(struct heap *h);
+void hp_drain_begin(struct heap *h, struct hp_drain *it);
+int hp_drain_next(struct hp_drain *it, void **key, void **val);
+void hp_drain_end(struct hp_drain *it);
 int hp_arr_is_sorted(struct heap *h, struct hp_data **arr, size_t nmemb);
 int hp_get_index(struct heap *h, void *val);
 void hp_decrease_key(struct heap *h, int pos, void *newval);
 int hp_get_index_key(struct heap *h, void *key);
 int hp_get_index_val(struct heap *h, void *val);
+int hp_get_pos(struct heap *h, int handle);
+int hp_contains(struct heap *h, int handle);
+void hp_update_key(struct heap *h, int handle, void *newkey);
+void hp_remove(struct heap *h, int handle);
+
+/*
+ * D-ary heap stuff
+ */
+
+/*
+ * Heap of int64 keys with arity 4 or 8. Keys are inline, the values
+ * are in a parallel array. keys points d - 1 slots into the cache
+ * line aligned kbuf, so each group of children shares a cache line.
+ */
+struct dheap {
+	int64_t *keys;                  /* Keys, in heap order */
+	void **vals;                    /* Values, parallel to keys */
+	int64_t *kbuf;                  /* Allocation holding keys */
+	size_t nmemb;                   /* Number of members */
+	size_t cap;                     /* Capacity -> max nmemb */
+	int arity;                      /* Children per node, 4 or 8 */
+	char type;                      /* MIN_HEAP or MAX_HEAP */
+};
+
+/* D-ary heap functions */
+struct dheap *dh_create(size_t cap, int arity, char type);
+void dh_insert(struct dheap *h, int64_t key, void *val);
+int dh_find_m(struct dheap *h, int64_t *key, void **val);
+int dh_extract_m(struct dheap *h, int64_t *key, void **val);
+int dh_is_empty(struct dheap *h);
+size_t dh_get_size(struct dheap *h);
+void dh_destroy(struct dheap *h);
+
+/*
+ * Hash function stuff
+ */
+
+#define HASH_SEED 0x2d358dccaa6c78a5ULL   /* default seed */
+
+/* Hash functions */
+uint64_t hash_bytes(const void *key, size_t len, uint64_t seed);
+uint64_t hash_u32(uint32_t key, uint64_t seed);
+uint64_t hash_u64(uint64_t key, uint64_t seed);
+uint64_t hash_key(const void *key, size_t len, uint64_t seed);
+
+/*
+ * Bloom Filter Stuff
+ */
+
+#define BLOOM_BLOCK_WORDS 8    /* 64 bit words per block, a cache line */
+#define BLOOM_BITS_PER_KEY 10  /* default bits per key, ~1% false pos */
+
+struct bloom {
+	uint64_t *blocks;                  /* nblocks blocks of bits */
+	size_t nblocks;                    /* total blocks, a power of 2 */
+	size_t cap;                        /* keys the filter is sized for */
+	int bits_per_key;                  /* bits per key asked for */
+	size_t nkeys;                      /* keys added */
+	size_t nneg;                       /* checks answered "absent" */
+	size_t nfp;                        /* false positives reported */
+};
+
+/* Bloom Filter functions */
+struct bloom *bloom_create(size_t nkeys, int bits_per_key);
+void bloom_add(struct bloom *b, uint64_t hash);
+int bloom_may_contain(struct bloom *b, uint64_t hash);
+void bloom_false_pos(struct bloom *b);
+double bloom_fp_rate(struct bloom *b);
+void bloom_destroy(struct bloom *b);
+
+/*
+ * HyperLogLog Stuff
+ */
+
+#define HLL_MIN_PRECISION 4    /* least register index bits */
+#define HLL_MAX_PRECISION 18   /* most register index bits */
+
+/*
+ * Starts sparse: a sorted array of the non zero registers, each
+ * packed as (index << 6) | rank. Switches to one byte per register
+ * (dense) once the sparse array would take m / 4 entries.
+ */
+struct hll {
+	int p;                             /* precision, register index
+	                                      bits */
+	size_t m;                          /* total registers, 2^p */
+	unsigned char *dense;              /* m registers, NULL if
+	                                      sparse */
+	uint32_t *sparse;                  /* sorted packed registers */
+	size_t nsparse;                    /* entries in sparse */
+	size_t sparse_cap;                 /* room in sparse */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+/* HyperLogLog functions */
+struct hll *hll_create(int p, int (*get_key_size) (void *));
+void hll_add(struct hll *h, void *key);
+void hll_add_hash(struct hll *h, uint64_t hash);
+double hll_count(struct hll *h);
+double hll_error(struct hll *h);
+void hll_merge(struct hll *dst, struct hll *src);
+void hll_destroy(struct hll *h);
+
+/*
+ * Count-Min Sketch Stuff
+ */
+
+/*
+ * depth rows of width counters. A key has one counter per row; its
+ * estimate is the least of them. Sized from (eps, delta), an
+ * estimate is at most eps * total above the true count with
+ * probability 1 - delta, and never below it.
+ */
+struct cms {
+	uint32_t *counters;                /* depth * width counters */
+	size_t width;                      /* counters per row,
+	                                      a power of 2 */
+	int depth;                         /* total rows */
+	uint64_t total;                    /* sum of all counts added */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+/* Count-Min Sketch functions */
+struct cms *cms_create(double eps, double delta,
+                       int (*get_key_size) (void *));
+void cms_add(struct cms *c, void *key, uint32_t count);
+void cms_add_hash(struct cms *c, uint64_t hash, uint32_t count);
+uint32_t cms_estimate(struct cms *c, void *key);
+uint32_t cms_estimate_hash(struct cms *c, uint64_t hash);
+void cms_merge(struct cms *dst, struct cms *src);
+void cms_destroy(struct cms *c);
 
 /*
  * Hash Table Stuff
@@ -305,29 +516,690 @@ int hp_get_index_val(struct heap *h, void *val);
 struct ht_data {
 	void *key;
 	void *val;
+	size_t hash;                       /* cached hash of key */
 };
 
+/*
+ * While the table is growing, members live in two tables. `table'
+ * is the old one and `new_table' the one being grown into. Every
+ * insert, search and delete moves a few slots of `table' over to
+ * `new_table' (incremental rehash), so no single call pays for
+ * moving the whole table.
+ */
 struct ht {
 	struct ll **table;                 /* table of linked lists */
-	size_t tot_slots;                  /* total slots in table */
+	size_t tot_slots;                  /* total slots in table,
+	                                      a power of 2 */
+	struct ll **new_table;             /* table being grown into */
+	size_t new_tot_slots;              /* total slots in new_table */
+	long rehash_idx;                   /* next slot of table to move,
+	                                      -1 if not growing */
+	int walkers;                       /* cursors and scans running;
+	                                      no rehash while > 0 */
+	size_t nmemb;                      /* total members */
+	double max_load;                   /* max nmemb / tot_slots */
 	void *(*k_cpy) (void *);           /* function to copy key */
 	void *(*v_cpy) (void *);           /* function to copy val */
 	int (*k_cmp)(void *, void *);      /* function to compare keys */
 	int (*v_cmp)(void *, void *);      /* function to compare vals */
 	int (*get_key_size) (void *);      /* function to get size of key */
-	int (*hash_func) (struct ht *, void *);   
+	size_t (*hash_func) (struct ht *, void *);   
 	                                   /* Hash function */
+	uint64_t seed;                     /* seed for hash_func */
+	struct bloom *bloom;               /* filter of keys in table,
+	                                      NULL if not used */
+	size_t bloom_stale;                /* deleted keys still in bloom */
+	struct ht_arena *arena;            /* key store, NULL if keys
+	                                      are copied with k_cpy */
+	size_t n_lookups;                  /* operation counters, only */
+	size_t n_hits;                     /* kept when hash_table.c is */
+	size_t n_cmps;                     /* built with HT_STATS */
+	size_t n_resizes;
+};
+
+#define HT_STATS_HIST 8        /* chain length histogram size */
+
+/*
+ * Health of a struct ht, filled by ht_stats. chain_hist[i] is the
+ * number of slots with a chain of i members; the last entry also
+ * counts all longer chains. Operation counters are 0 unless the
+ * table was built with HT_STATS defined.
+ */
+struct ht_stats {
+	size_t tot_slots;                  /* slots, in both tables
+	                                      while growing */
+	size_t nmemb;                      /* total members */
+	double load;                       /* nmemb / tot_slots */
+	size_t used_slots;                 /* slots with a chain */
+	size_t max_chain;                  /* longest chain */
+	double avg_chain;                  /* nmemb / used_slots */
+	size_t chain_hist[HT_STATS_HIST];  /* slots by chain length */
+	size_t lookups;                    /* key lookups, also those
+	                                      of insert and delete */
+	size_t hits;                       /* lookups finding the key */
+	size_t misses;                     /* lookups not finding it */
+	size_t key_cmps;                   /* calls to k_cmp */
+	double cmps_per_lookup;            /* key_cmps / lookups */
+	size_t resizes;                    /* times the table grew */
+};
+
+/*
+ * Keys of a struct ht kept in big chunks instead of one malloc per
+ * key. Each key is preceded by a struct ht_arena_key, so a lookup
+ * can check hash and length before comparing bytes.
+ */
+struct ht_arena_chunk {
+	struct ht_arena_chunk *next;       /* next chunk */
+	size_t size;                       /* bytes after this header */
+	size_t used;                       /* bytes given out */
+};
+
+struct ht_arena_key {
+	uint64_t hash;                     /* hash of key */
+	uint64_t len;                      /* size of key in bytes */
 };
 
+struct ht_arena {
+	struct ht_arena_chunk *chunks;     /* newest chunk first */
+	size_t chunk_size;                 /* size of a new chunk */
+	size_t nchunks;                    /* total chunks */
+	size_t used;                       /* bytes used by live keys */
+	size_t dead;                       /* bytes of deleted keys, freed
+	                                      only with the table */
+};
+
+#define HT_ARENA_CHUNK (64 * 1024)     /* default arena chunk size */
+
+/*
+ * Cursor over the members of a struct ht. It lives wherever the
+ * caller puts it, usually the stack, so walking a table allocates
+ * nothing. While a cursor is in use the table may be looked up,
+ * but not changed.
+ */
+struct ht_iter {
+	struct ht *h;
+	int table;                         /* 0: new_table, 1: table,
+	                                      2: done */
+	size_t slot;                       /* next slot to look at */
+	struct ll_node *node;              /* next node of current slot */
+};
+
+#define HT_MAX_LOAD 1.0        /* default max load factor */
+#define HT_GROWTH_RATE 2       /* table grows by this factor */
+#define HT_REHASH_STEP 1       /* slots moved per operation */
+#define HT_BATCH_GROUP 16      /* keys looked up together in a batch */
+
 /* Hash Table functions */
 struct ht *ht_create(size_t tot_slots, void *(*k_cpy) (void *),
 	             void *(*v_cpy) (void *), int (*k_cmp) (void *, void *),
 	             int (*v_cmp)(void *, void *), int (*get_key_size)(void *));
 int ht_insert(struct ht *h, void *key, void *val);
 int ht_search(struct ht *h, void *key);
+void *ht_get(struct ht *h, void *key);
+int ht_upsert(struct ht *h, void *key, void *val);
+void *ht_get_or_insert(struct ht *h, void *key, void *val);
+size_t ht_search_batch(struct ht *h, void **keys, size_t n, int *found);
+size_t ht_get_batch(struct ht *h, void **keys, size_t n, void **vals);
 void ht_delete(struct ht *h, void *key);
 void ht_destroy(struct ht *h);
 void ht_print(struct ht *h, int type);
+void ht_set_max_load(struct ht *h, double max_load);
+int ht_is_rehashing(struct ht *h);
+size_t ht_tot_memb(struct ht *h);
+void ht_set_hash(struct ht *h, size_t (*hash_func) (struct ht *, void *),
+                 uint64_t seed);
+void ht_set_bloom(struct ht *h, int bits_per_key);
+double ht_bloom_fp_rate(struct ht *h);
+void ht_iter_begin(struct ht *h, struct ht_iter *it);
+int ht_iter_next(struct ht_iter *it, void **key, void **val);
+void ht_iter_end(struct ht_iter *it);
+void ht_stats(struct ht *h, struct ht_stats *st);
+void ht_build_bulk(struct ht *h, void **keys, void **vals, size_t n,
+                   int nthreads);
+void ht_set_key_arena(struct ht *h, size_t chunk_size);
+void ht_parallel_for_each(struct ht *h, int nthreads,
+                          void (*fn) (void *, void *, void *, int),
+                          void *arg);
+
+/*
+ * Robin Hood Hash Table Stuff
+ */
+
+/*
+ * A slot of the Robin Hood hash table. Slots are stored in one
+ * contiguous array, so a probe walks neighbouring slots instead
+ * of chasing list pointers.
+ */
+struct rht_slot {
+	void *key;                         /* key, NULL if slot is empty */
+	void *val;                         /* val */
+	size_t hash;                       /* cached hash of key */
+};
+
+/*
+ * A table made by rht_create_fixed keeps keys and vals of a fixed
+ * size inline in `fixed' instead of `slots'. Each slot there is
+ * `slot_size' bytes: the hash (with RHT_FIXED_USED set, 0 if slot
+ * is empty), then key_size bytes of key and val_size bytes of val.
+ * Keys are compared with memcmp and copied with memcpy, and the
+ * callbacks are not used.
+ */
+struct rht {
+	struct rht_slot *slots;            /* open addressed slot array */
+	size_t tot_slots;                  /* total slots, a power of 2 */
+	size_t nmemb;                      /* total members */
+	unsigned char *fixed;              /* inline slots, NULL if not
+	                                      fixed size mode */
+	unsigned char *tmp;                /* 2 slots of scratch space */
+	size_t key_size;                   /* fixed key size */
+	size_t val_size;                   /* fixed val size */
+	size_t val_off;                    /* offset of val in a slot */
+	size_t slot_size;                  /* size of an inline slot */
+	void *(*k_cpy) (void *);           /* function to copy key */
+	void *(*v_cpy) (void *);           /* function to copy val */
+	int (*k_cmp)(void *, void *);      /* function to compare keys */
+	int (*v_cmp)(void *, void *);      /* function to compare vals */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+/* Grow when nmemb / tot_slots exceeds RHT_LOAD_NUM / RHT_LOAD_DEN */
+#define RHT_LOAD_NUM 9
+#define RHT_LOAD_DEN 10
+#define RHT_MIN_SLOTS 8
+#define RHT_FIXED_USED ((uint64_t) 1 << 63)   /* marks a used inline slot */
+
+/* Robin Hood Hash Table functions */
+struct rht *rht_create(size_t tot_slots, void *(*k_cpy) (void *),
+	               void *(*v_cpy) (void *), int (*k_cmp) (void *, void *),
+	               int (*v_cmp)(void *, void *), int (*get_key_size)(void *));
+struct rht *rht_create_fixed(size_t tot_slots, size_t key_size,
+                             size_t val_size);
+int rht_insert(struct rht *h, void *key, void *val);
+int rht_search(struct rht *h, void *key);
+void *rht_get(struct rht *h, void *key);
+void rht_delete(struct rht *h, void *key);
+void rht_destroy(struct rht *h);
+
+/*
+ * Swiss Table Stuff
+ */
+
+/*
+ * Every slot has a control byte in a separate array. A full slot
+ * has 7 bits of its key hash in its control byte, so a lookup can
+ * filter 16 slots at a time by comparing control bytes, and call
+ * k_cmp only on slots whose 7 bits match.
+ */
+struct swt_slot {
+	void *key;
+	void *val;
+};
+
+struct swt {
+	signed char *ctrl;                 /* control bytes, tot_slots
+	                                      + SWT_GROUP_WIDTH of them */
+	struct swt_slot *slots;            /* slot array */
+	size_t tot_slots;                  /* total slots, a power of 2 */
+	size_t nmemb;                      /* total members */
+	size_t growth_left;                /* empty slots that may still
+	                                      be filled before a rehash */
+	void *(*k_cpy) (void *);           /* function to copy key */
+	void *(*v_cpy) (void *);           /* function to copy val */
+	int (*k_cmp)(void *, void *);      /* function to compare keys */
+	int (*v_cmp)(void *, void *);      /* function to compare vals */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+#define SWT_GROUP_WIDTH 16     /* control bytes scanned at once */
+#define SWT_EMPTY   (-128)     /* control byte of empty slot */
+#define SWT_DELETED (-2)       /* control byte of deleted slot */
+
+/* Swiss Table functions */
+struct swt *swt_create(size_t tot_slots, void *(*k_cpy) (void *),
+	               void *(*v_cpy) (void *), int (*k_cmp) (void *, void *),
+	               int (*v_cmp)(void *, void *), int (*get_key_size)(void *));
+int swt_insert(struct swt *h, void *key, void *val);
+int swt_search(struct swt *h, void *key);
+void swt_delete(struct swt *h, void *key);
+void swt_destroy(struct swt *h);
+
+/*
+ * Cuckoo Hash Table Stuff
+ */
+
+#define CKT_BUCKET_SLOTS 4     /* slots per bucket, a power of 2 */
+#define CKT_BFS_MAX 256        /* max buckets looked at per insert */
+#define CKT_LINE 64            /* cache line size */
+
+/*
+ * A member lives in one of two buckets, picked by the low and the
+ * high half of its hash, so a lookup looks at no more than two
+ * buckets however full the table is. A bucket holds the cached
+ * hashes and the keys of its slots, and nothing else, so it is
+ * exactly one CKT_LINE aligned line. Vals are kept apart in vals[],
+ * and read only on a hit.
+ */
+struct ckt_bucket {
+	size_t hash[CKT_BUCKET_SLOTS];     /* cached hash of key */
+	void *key[CKT_BUCKET_SLOTS];       /* key, NULL if slot is empty */
+};
+
+struct ckt {
+	struct ckt_bucket *buckets;        /* bucket array */
+	void **vals;                       /* val of slot i of bucket b at
+	                                      b * CKT_BUCKET_SLOTS + i */
+	size_t tot_buckets;                /* total buckets, a power of 2 */
+	size_t nmemb;                      /* total members */
+	void *(*k_cpy) (void *);           /* function to copy key */
+	void *(*v_cpy) (void *);           /* function to copy val */
+	int (*k_cmp)(void *, void *);      /* function to compare keys */
+	int (*v_cmp)(void *, void *);      /* function to compare vals */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+/* Cuckoo Hash Table functions */
+struct ckt *ckt_create(size_t tot_slots, void *(*k_cpy) (void *),
+	               void *(*v_cpy) (void *), int (*k_cmp) (void *, void *),
+	               int (*v_cmp)(void *, void *), int (*get_key_size)(void *));
+int ckt_insert(struct ckt *h, void *key, void *val);
+int ckt_search(struct ckt *h, void *key);
+void *ckt_get(struct ckt *h, void *key);
+void ckt_delete(struct ckt *h, void *key);
+void ckt_destroy(struct ckt *h);
+size_t ckt_tot_memb(struct ckt *h);
+
+/*
+ * Frozen Hash Table Stuff
+ */
+
+#define FHT_BUCKET_LOAD 5      /* mean keys per pilot bucket */
+#define FHT_ALPHA_NUM 98       /* nmemb / tot_pos is about */
+#define FHT_ALPHA_DEN 100      /* FHT_ALPHA_NUM / FHT_ALPHA_DEN */
+#define FHT_MAX_SEEDS 64       /* seeds tried before giving up */
+
+struct fht_entry {
+	void *key;
+	void *val;
+};
+
+/*
+ * A read only table made from a struct ht by ht_freeze. A minimal
+ * perfect hash maps each key to its own entry, so a lookup reads
+ * one pilot, one entry and does one k_cmp.
+ */
+struct fht {
+	struct fht_entry *entries;         /* nmemb entries, by position */
+	size_t nmemb;                      /* total members */
+	uint16_t *pilots;                  /* pilot of every bucket */
+	size_t nbuckets;                   /* total buckets */
+	uint32_t *remap;                   /* free entry for positions
+	                                      nmemb .. tot_pos - 1 */
+	size_t tot_pos;                    /* positions hashed to */
+	uint64_t seed;                     /* seed of key hashes */
+	int (*k_cmp)(void *, void *);      /* function to compare keys */
+	int (*v_cmp)(void *, void *);      /* function to compare vals */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+/* Frozen Hash Table functions */
+struct fht *ht_freeze(struct ht *h);
+int fht_search(struct fht *f, void *key);
+void *fht_get(struct fht *f, void *key);
+size_t fht_tot_memb(struct fht *f);
+void fht_destroy(struct fht *f);
+
+/*
+ * Disk Hash Table Stuff
+ */
+
+#define DHT_MAGIC "HTDUMP01"   /* first 8 bytes of a dump file */
+
+/*
+ * Layout of a file written by ht_dump. There are no pointers, only
+ * offsets from the start of the file, so a reader can mmap it at
+ * any address and use it as is. Numbers are in host byte order.
+ *
+ *   struct dht_header
+ *   uint64_t slot_start[tot_slots + 1]  first entry of every slot
+ *   struct dht_entry entries[nmemb]     grouped by slot
+ *   key and val bytes                   each followed by at least
+ *                                       one 0 byte, 8 byte aligned
+ */
+struct dht_header {
+	char magic[8];                     /* DHT_MAGIC */
+	uint64_t nmemb;                    /* total members */
+	uint64_t tot_slots;                /* total slots, a power of 2 */
+	uint64_t seed;                     /* seed of hash_key */
+	uint64_t slots_off;                /* offset of slot_start */
+	uint64_t entries_off;              /* offset of entries */
+	uint64_t file_size;                /* size of the whole file */
+};
+
+struct dht_entry {
+	uint64_t hash;                     /* hash_key of key */
+	uint64_t key_off;                  /* offset of key bytes */
+	uint64_t val_off;                  /* offset of val bytes */
+	uint32_t key_len;                  /* size of key */
+	uint32_t val_len;                  /* size of val */
+};
+
+/* A dump file mapped read only by dht_open */
+struct dht {
+	const unsigned char *map;          /* the mapped file */
+	size_t map_size;                   /* size of mapping */
+	const struct dht_header *hdr;      /* header, at map */
+	const uint64_t *slot_start;        /* slot index in map */
+	const struct dht_entry *entries;   /* entries in map */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+/* Disk Hash Table functions */
+int ht_dump(struct ht *h, const char *path, int (*get_val_size)(void *));
+struct dht *dht_open(const char *path, int (*get_key_size)(void *));
+int dht_search(struct dht *d, void *key);
+const void *dht_get(struct dht *d, void *key);
+size_t dht_tot_memb(struct dht *d);
+void dht_close(struct dht *d);
+
+/*
+ * Cache Stuff
+ */
+
+/* Eviction policies */
+#define CACHE_CLOCK 1          /* CLOCK (second chance) */
+#define CACHE_TINYLFU 2        /* W-TinyLFU: CLOCK window, TinyLFU
+                                  admission to CLOCK main region */
+
+#define CACHE_WINDOW_PCT 1     /* W-TinyLFU window, % of capacity */
+#define CACHE_SKETCH_MAX (1 << 16)   /* max sketch width per shard */
+
+/*
+ * A cached member. Entries of a region form a circular list that
+ * the CLOCK hand walks. A hit only sets `ref', the list is not
+ * changed.
+ */
+struct cache_entry {
+	void *key;
+	void *val;
+	size_t charge;                     /* capacity used */
+	uint64_t hash;                     /* hash of key */
+	unsigned char ref;                 /* referenced since last sweep */
+	unsigned char region;              /* ring it is on */
+	struct cache_entry *prev;
+	struct cache_entry *next;
+};
+
+/* A CLOCK ring: entries of one region */
+struct cache_ring {
+	struct cache_entry *hand;          /* next entry to look at, NULL
+	                                      if ring is empty */
+	size_t charge;                     /* charge of entries on ring */
+	size_t cap;                        /* max charge */
+};
+
+/*
+ * A shard: an independent cache for the keys whose hash picks it,
+ * with its own lock. Padded so that shards do not share a cache
+ * line.
+ */
+union cache_shard {
+	struct {
+		pthread_mutex_t lock;      /* guards this shard */
+		struct ht *index;          /* key -> struct cache_entry * */
+		struct cache_ring ring[2]; /* window and main region */
+		unsigned char *sketch;     /* count-min sketch, 4 rows */
+		size_t sketch_width;       /* counters per row, power of 2 */
+		size_t sketch_adds;        /* adds since counters halved */
+		size_t hits;               /* cache_get hits */
+		size_t misses;             /* cache_get misses */
+	} s;
+	char pad[256];
+};
+
+struct cache {
+	union cache_shard *shards;         /* shards */
+	size_t nshards;                    /* total shards, a power of 2 */
+	int policy;                        /* CACHE_CLOCK or CACHE_TINYLFU */
+	void *(*k_cpy) (void *);           /* function to copy key */
+	void *(*v_cpy) (void *);           /* function to copy val */
+	int (*k_cmp)(void *, void *);      /* function to compare keys */
+	int (*v_cmp)(void *, void *);      /* function to compare vals */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+/* Cache functions */
+struct cache *cache_create(size_t cap, size_t nshards, int policy,
+                           void *(*k_cpy) (void *), void *(*v_cpy) (void *),
+			   int (*k_cmp) (void *, void *),
+			   int (*v_cmp)(void *, void *),
+			   int (*get_key_size)(void *));
+void *cache_get(struct cache *c, void *key);
+void cache_put(struct cache *c, void *key, void *val, size_t charge);
+void cache_erase(struct cache *c, void *key);
+size_t cache_tot_memb(struct cache *c);
+double cache_hit_rate(struct cache *c);
+void cache_destroy(struct cache *c);
+
+/*
+ * Concurrent Hash Table Stuff
+ */
+
+struct cht_node {
+	void *key;
+	void *val;
+	size_t hash;                       /* cached hash of key */
+	struct cht_node *next;
+};
+
+/*
+ * A lock stripe. Slot i of the table is guarded by stripe
+ * i % nstripes. Padded to its own cache lines so that threads
+ * working on different stripes do not share a lock cache line.
+ */
+union cht_stripe {
+	struct {
+		pthread_rwlock_t lock;     /* guards slots of this stripe */
+		size_t nmemb;              /* members in this stripe */
+	} s;
+	char pad[128];
+};
+
+/*
+ * Readers take the read lock of one stripe, writers the write lock
+ * of one stripe. Growing the table takes the write lock of every
+ * stripe, in order.
+ */
+struct cht {
+	struct cht_node **table;           /* table of chains */
+	size_t tot_slots;                  /* total slots, a power of 2,
+	                                      multiple of nstripes */
+	union cht_stripe *stripes;         /* lock stripes */
+	size_t nstripes;                   /* total stripes, a power of 2 */
+	double max_load;                   /* max nmemb / tot_slots */
+	void *(*k_cpy) (void *);           /* function to copy key */
+	void *(*v_cpy) (void *);           /* function to copy val */
+	int (*k_cmp)(void *, void *);      /* function to compare keys */
+	int (*v_cmp)(void *, void *);      /* function to compare vals */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+#define CHT_MAX_LOAD 1.0       /* default max load factor */
+
+/* Concurrent Hash Table functions */
+struct cht *cht_create(size_t tot_slots, size_t nstripes,
+                       void *(*k_cpy) (void *), void *(*v_cpy) (void *),
+		       int (*k_cmp) (void *, void *),
+		       int (*v_cmp)(void *, void *), int (*get_key_size)(void *));
+int cht_insert(struct cht *h, void *key, void *val);
+int cht_search(struct cht *h, void *key);
+void *cht_get(struct cht *h, void *key);
+void cht_delete(struct cht *h, void *key);
+void cht_destroy(struct cht *h);
+size_t cht_tot_memb(struct cht *h);
+
+/*
+ * Epoch Based Reclamation Stuff
+ */
+
+/* A retired pointer waiting to be freed */
+struct ebr_node {
+	void *ptr;                         /* retired pointer */
+	void (*fn)(void *);                /* function to free it */
+	struct ebr_node *next;
+};
+
+/* Pointers retired in one epoch */
+struct ebr_limbo {
+	struct ebr_node *head;
+	uint64_t epoch;                    /* epoch they were retired in */
+};
+
+#define EBR_LINE 64           /* cache line size */
+
+/*
+ * Per thread record, one for every thread that used an ebr. Records
+ * are EBR_LINE aligned, and epoch, stored on every enter and exit,
+ * is alone in the first line.
+ */
+struct ebr_thread {
+	_Atomic uint64_t epoch;            /* epoch announced, or EBR_IDLE
+	                                      if not in critical section */
+	char pad[EBR_LINE - sizeof(uint64_t)];
+	unsigned depth;                    /* ebr_enter calls not yet
+	                                      matched by ebr_exit */
+	struct ebr_limbo limbo[3];         /* retired, by epoch % 3 */
+	unsigned nretired;                 /* retires since last advance */
+	struct ebr_thread *next;           /* next record in registry */
+};
+
+/*
+ * Threads access shared nodes only between ebr_enter and ebr_exit.
+ * A node unlinked and retired in epoch e is freed once the global
+ * epoch reaches e + 2; by then every thread that could have seen it
+ * has left its critical section. Sections nest: only the outermost
+ * ebr_enter and ebr_exit announce and clear the thread's epoch, so
+ * an inner section does not end the outer one early. Entering and
+ * leaving only store to
+ * the thread's own record; no atomic read-modify-write is done on
+ * shared memory. With membarrier (asym), entering issues no fence
+ * either; the epoch advance pays for it.
+ */
+struct ebr {
+	_Atomic uint64_t epoch;            /* global epoch */
+	struct ebr_thread *_Atomic threads;/* registry of thread records */
+	pthread_key_t key;                 /* thread's record */
+	int asym;                          /* 1 if membarrier is used */
+};
+
+#define EBR_IDLE UINT64_MAX   /* epoch of thread outside critical section */
+#define EBR_ADVANCE_FREQ 64   /* retires between advance attempts */
+
+/* Epoch Based Reclamation functions */
+struct ebr *ebr_create(void);
+void ebr_enter(struct ebr *e);
+void ebr_exit(struct ebr *e);
+void ebr_retire(struct ebr *e, void *ptr, void (*fn)(void *));
+void ebr_destroy(struct ebr *e);
+
+/*
+ * RCU Hash Table Stuff
+ */
+
+/* Node of an rcuht chain. Never changed once published. */
+struct rcuht_node {
+	void *key;
+	void *val;
+	uint64_t hash;                     /* cached hash of key */
+	struct rcuht_node *_Atomic next;
+};
+
+/* Slot array of an rcuht, replaced as a whole when growing */
+struct rcuht_table {
+	size_t tot_slots;                  /* total slots, a power of 2 */
+	struct rcuht_node *_Atomic *slots; /* chains, follow the struct */
+};
+
+/*
+ * Readers load `table' and walk chains inside an ebr critical
+ * section, with no lock. Writers take `wlock', publish new nodes
+ * or tables with release stores, and retire what they unlink.
+ */
+struct rcuht {
+	struct rcuht_table *_Atomic table; /* current table */
+	pthread_mutex_t wlock;             /* serializes writers */
+	struct ebr *ebr;                   /* reclaims unlinked memory */
+	size_t nmemb;                      /* total members */
+	double max_load;                   /* max nmemb / tot_slots */
+	void *(*k_cpy) (void *);           /* function to copy key */
+	void *(*v_cpy) (void *);           /* function to copy val */
+	int (*k_cmp)(void *, void *);      /* function to compare keys */
+	int (*v_cmp)(void *, void *);      /* function to compare vals */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+#define RCUHT_MAX_LOAD 1.0     /* default max load factor */
+
+/* RCU Hash Table functions */
+struct rcuht *rcuht_create(size_t tot_slots, void *(*k_cpy) (void *),
+                           void *(*v_cpy) (void *),
+			   int (*k_cmp) (void *, void *),
+			   int (*v_cmp)(void *, void *),
+			   int (*get_key_size)(void *));
+int rcuht_insert(struct rcuht *h, void *key, void *val);
+int rcuht_search(struct rcuht *h, void *key);
+void *rcuht_get(struct rcuht *h, void *key);
+void rcuht_read_lock(struct rcuht *h);
+void rcuht_read_unlock(struct rcuht *h);
+void *rcuht_lookup(struct rcuht *h, void *key);
+void rcuht_delete(struct rcuht *h, void *key);
+void rcuht_set_max_load(struct rcuht *h, double max_load);
+size_t rcuht_tot_memb(struct rcuht *h);
+void rcuht_destroy(struct rcuht *h);
+
+/*
+ * Lock Free Hash Table Stuff
+ */
+
+/*
+ * Node of the split ordered list. Regular nodes hold a key and val,
+ * sentinel nodes mark the start of a bucket. The low bit of `next'
+ * is set when the node is logically deleted.
+ */
+struct lfht_node {
+	uint64_t so_key;                   /* split order key */
+	void *key;                         /* key, NULL for sentinel */
+	void *_Atomic val;                 /* val */
+	uint64_t hash;                     /* hash of key */
+	_Atomic uintptr_t next;            /* next node | deleted mark */
+};
+
+#define LFHT_MAX_SEGS 64      /* bucket directory size */
+#define LFHT_MAX_LOAD 2       /* max nmemb / tot_slots */
+
+struct lfht {
+	struct lfht_node *_Atomic *_Atomic seg[LFHT_MAX_SEGS];
+	                                   /* bucket sentinels, in segments
+	                                      allocated on first use */
+	_Atomic size_t tot_slots;          /* total buckets, a power of 2 */
+	_Atomic size_t nmemb;              /* total members */
+	struct ebr *ebr;                   /* reclaims unlinked nodes */
+	void *(*k_cpy) (void *);           /* function to copy key */
+	void *(*v_cpy) (void *);           /* function to copy val */
+	int (*k_cmp)(void *, void *);      /* function to compare keys */
+	int (*v_cmp)(void *, void *);      /* function to compare vals */
+	int (*get_key_size) (void *);      /* function to get size of key */
+};
+
+/* Lock Free Hash Table functions */
+struct lfht *lfht_create(size_t tot_slots, void *(*k_cpy) (void *),
+	                 void *(*v_cpy) (void *), int (*k_cmp) (void *, void *),
+	                 int (*v_cmp)(void *, void *), int (*get_key_size)(void *));
+int lfht_insert(struct lfht *h, void *key, void *val);
+int lfht_search(struct lfht *h, void *key);
+void *lfht_get(struct lfht *h, void *key);
+void lfht_delete(struct lfht *h, void *key);
+void lfht_destroy(struct lfht *h);
+size_t lfht_tot_memb(struct lfht *h);
 
 /* 
  * Binary Search Tree Stuff 
@@ -0,0 +1,477 @@
+/*
+ * perfect_hash.c: Frozen hash table using a minimal perfect hash
+ *
+ * St: 2026-10-17 Sat 07:20 AM
+ * Up: 2026-10-17 Sat 07:20 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * ht_freeze builds a minimal perfect hash over the keys of a struct
+ * ht, following PTHash (Pibiri and Trani, 2021):
+ *
+ * 1. Keys are hashed to 64 bits with a seed, and split into
+ *    buckets of about FHT_BUCKET_LOAD keys. The split is skewed:
+ *    60% of the keys go to 30% of the buckets, so there are some
+ *    big buckets, placed first while the table is empty, and many
+ *    small ones.
+ *
+ * 2. Buckets are placed biggest first. For each bucket, pilots
+ *    0, 1, 2, .. are tried until every key of the bucket lands on a
+ *    free position, (hash ^ hash_u64(pilot)) % tot_pos. The pilot
+ *    is stored in 16 bits.
+ *
+ * 3. tot_pos is a bit more than nmemb (FHT_ALPHA), which makes
+ *    placing much faster. Keys that land past nmemb are sent to
+ *    the free positions below it through `remap', so entries is a
+ *    dense array of nmemb.
+ *
+ * That is about 3.3 bits of pilot per key, plus 32 bits of remap for
+ * each of the ~2% positions past nmemb. If two keys have the same
+ * 64 bit hash, or some bucket finds no pilot, a new seed is tried.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+#define FHT_MAX_PILOT 65535
+#define FHT_DENSE_KEYS 2576980378U    /* 60% of 2^32 */
+
+/* A key of the table being frozen */
+struct fht_key {
+	void *key;
+	void *val;
+	uint64_t hash;
+	size_t idx;         /* order found in; lower wins for duplicates */
+};
+
+/*
+ * Return the bucket of a hash. The top 32 bits pick dense or sparse
+ * buckets, and the bucket in them.
+ *
+ * @f:    Pointer to the frozen hash table structure
+ * @hash: Hash of a key
+ */
+static size_t fht_bucket(struct fht *f, uint64_t hash)
+{
+	uint32_t h1;
+	size_t ndense;
+
+	h1 = hash >> 32;
+	ndense = (f->nbuckets * 3 + 9) / 10;
+
+	if (h1 < FHT_DENSE_KEYS)
+		return h1 % ndense;
+
+	return ndense + h1 % (f->nbuckets - ndense);
+}
+
+/*
+ * Return position of a hash for a pilot, before remapping.
+ *
+ * @f:     Pointer to the frozen hash table structure
+ * @hash:  Hash of a key
+ * @pilot: Pilot of the key's bucket
+ */
+static size_t fht_raw_pos(struct fht *f, uint64_t hash, uint16_t pilot)
+{
+	return (hash ^ hash_u64(pilot, f->seed)) % f->tot_pos;
+}
+
+/*
+ * Return entry index of a hash.
+ *
+ * @f:    Pointer to the frozen hash table structure
+ * @hash: Hash of a key
+ */
+static size_t fht_pos(struct fht *f, uint64_t hash)
+{
+	size_t pos;
+
+	pos = fht_raw_pos(f, hash, f->pilots[fht_bucket(f, hash)]);
+	if (pos >= f->nmemb)
+		pos = f->remap[pos - f->nmemb];
+
+	return pos;
+}
+
+/*
+ * Compare two keys by hash, then by order found in, for qsort.
+ *
+ * @a: First key
+ * @b: Second key
+ */
+static int fht_key_cmp(const void *a, const void *b)
+{
+	const struct fht_key *x;
+	const struct fht_key *y;
+
+	x = a;
+	y = b;
+
+	if (x->hash != y->hash)
+		return (x->hash > y->hash) - (x->hash < y->hash);
+
+	return (x->idx > y->idx) - (x->idx < y->idx);
+}
+
+/*
+ * Add all members of a table to `keys', in the order ht_find looks
+ * at them. Return the new key count.
+ *
+ * @keys:      Array to add to
+ * @n:         Keys already in the array
+ * @table:     Table of linked lists
+ * @tot_slots: Total slots in table
+ */
+static size_t fht_collect(struct fht_key *keys, size_t n, struct ll **table,
+                          size_t tot_slots)
+{
+	size_t i;
+	struct ll_node *lln;
+	struct ht_data *data;
+
+	for (i = 0; i < tot_slots; i++) {
+		if (table[i] == NULL)
+			continue;
+		for (lln = table[i]->head; lln != NULL; lln = lln->next) {
+			data = (struct ht_data *) lln->val;
+			keys[n].key = data->key;
+			keys[n].val = data->val;
+			keys[n].idx = n;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+/*
+ * Hash keys with f->seed, sort them by hash and drop duplicate
+ * keys, keeping the one ht_find would find. Return the key count
+ * left, or 0 if two different keys have the same hash.
+ *
+ * @f:    Pointer to the frozen hash table structure
+ * @keys: Keys to hash
+ * @n:    Key count
+ */
+static size_t fht_hash_keys(struct fht *f, struct fht_key *keys, size_t n)
+{
+	size_t i;
+	size_t kept;
+
+	for (i = 0; i < n; i++)
+		keys[i].hash = hash_key(keys[i].key,
+		                        f->get_key_size(keys[i].key), f->seed);
+
+	qsort(keys, n, sizeof(struct fht_key), fht_key_cmp);
+
+	kept = 1;
+	for (i = 1; i < n; i++) {
+		if (keys[i].hash == keys[kept - 1].hash) {
+			if (f->k_cmp(keys[i].key, keys[kept - 1].key) != 0)
+				return 0;
+			continue;
+		}
+		keys[kept++] = keys[i];
+	}
+
+	return kept;
+}
+
+/*
+ * Find a pilot for every bucket and fill remap. f->nmemb,
+ * f->nbuckets and f->tot_pos must be set, and keys hashed. Return
+ * 1 on success, 0 if some bucket has no pilot.
+ *
+ * @f:    Pointer to the frozen hash table structure
+ * @keys: Keys, hashed
+ */
+static int fht_place(struct fht *f, struct fht_key *keys)
+{
+	int ok;
+	int retval;
+	size_t i;
+	size_t j;
+	size_t b;
+	size_t pos;
+	size_t size;
+	size_t max_size;
+	size_t free_pos;
+	size_t *start;
+	size_t *order;
+	unsigned char *taken;
+	unsigned long pilot;
+
+	start = calloc(f->nbuckets + 1, sizeof(size_t));
+	order = malloc((f->nmemb + 1) * sizeof(size_t));
+	taken = calloc(f->tot_pos, 1);
+	assert(start && order && taken);
+
+	/* Group keys by bucket (counting sort) */
+	for (i = 0; i < f->nmemb; i++)
+		start[fht_bucket(f, keys[i].hash) + 1]++;
+	max_size = 0;
+	for (b = 0; b < f->nbuckets; b++) {
+		if (start[b + 1] > max_size)
+			max_size = start[b + 1];
+		start[b + 1] += start[b];
+	}
+	for (i = 0; i < f->nmemb; i++) {
+		b = fht_bucket(f, keys[i].hash);
+		order[start[b]++] = i;
+	}
+	for (b = f->nbuckets; b > 0; b--)
+		start[b] = start[b - 1];
+	start[0] = 0;
+
+	/* Place buckets, biggest first */
+	retval = 1;
+	for (size = max_size; size > 0 && retval; size--)
+		for (b = 0; b < f->nbuckets && retval; b++) {
+			if (start[b + 1] - start[b] != size)
+				continue;
+
+			ok = 0;
+			for (pilot = 0; pilot <= FHT_MAX_PILOT && !ok; pilot++) {
+				ok = 1;
+				for (j = start[b]; j < start[b + 1]; j++) {
+					pos = fht_raw_pos(f, keys[order[j]].hash,
+					                  pilot);
+					if (taken[pos]) {
+						ok = 0;
+						break;
+					}
+					taken[pos] = 1;
+				}
+				/* Undo a failed try */
+				if (!ok)
+					while (j-- > start[b])
+						taken[fht_raw_pos(f,
+						      keys[order[j]].hash,
+						      pilot)] = 0;
+				else
+					f->pilots[b] = pilot;
+			}
+			retval = ok;
+		}
+
+	/* Send positions past nmemb to free positions below it */
+	free_pos = 0;
+	for (pos = f->nmemb; pos < f->tot_pos && retval; pos++) {
+		if (!taken[pos])
+			continue;
+		while (taken[free_pos])
+			free_pos++;
+		f->remap[pos - f->nmemb] = free_pos++;
+	}
+
+	free(start);
+	free(order);
+	free(taken);
+
+	return retval;
+}
+
+/*
+ * Build a read only table with the members of a hash table. Keys
+ * and vals are copied, so `h' can be changed or destroyed after.
+ * Where `h' holds a key more than once, the val ht_get would return
+ * is kept. Return NULL if no perfect hash could be built, which
+ * only happens if many seeds give two keys the same 64 bit hash.
+ *
+ * @h: Pointer to the hash table structure
+ */
+struct fht *ht_freeze(struct ht *h)
+{
+	int try;
+	size_t i;
+	size_t n;
+	size_t pos;
+	struct fht *f;
+	struct fht_key *keys;
+
+	f = malloc(sizeof(struct fht));
+	assert(f);
+
+	f->k_cmp = h->k_cmp;
+	f->v_cmp = h->v_cmp;
+	f->get_key_size = h->get_key_size;
+
+	/* Newer members are in new_table, look there first */
+	keys = malloc((h->nmemb + 1) * sizeof(struct fht_key));
+	assert(keys);
+	n = 0;
+	if (h->rehash_idx >= 0)
+		n = fht_collect(keys, n, h->new_table, h->new_tot_slots);
+	n = fht_collect(keys, n, h->table, h->tot_slots);
+	assert(n < UINT32_MAX);
+
+	f->pilots = NULL;
+	f->remap = NULL;
+
+	for (try = 0; try < FHT_MAX_SEEDS; try++) {
+		free(f->pilots);
+		free(f->remap);
+
+		f->seed = hash_u64(try, HASH_SEED);
+		f->nmemb = (n > 0) ? fht_hash_keys(f, keys, n) : 0;
+		if (n > 0 && f->nmemb == 0)
+			continue;
+
+		f->nbuckets = f->nmemb / FHT_BUCKET_LOAD + 2;
+		f->tot_pos = f->nmemb * FHT_ALPHA_DEN / FHT_ALPHA_NUM + 1;
+
+		f->pilots = calloc(f->nbuckets, sizeof(uint16_t));
+		f->remap = calloc(f->tot_pos - f->nmemb, sizeof(uint32_t));
+		assert(f->pilots && f->remap);
+
+		if (fht_place(f, keys))
+			break;
+	}
+
+	if (try == FHT_MAX_SEEDS) {
+		free(f->pilots);
+		free(f->remap);
+		free(f);
+		free(keys);
+		return NULL;
+	}
+
+	f->entries = malloc((f->nmemb + 1) * sizeof(struct fht_entry));
+	assert(f->entries);
+
+	for (i = 0; i < f->nmemb; i++) {
+		pos = fht_pos(f, keys[i].hash);
+		f->entries[pos].key = h->k_cpy(keys[i].key);
+		f->entries[pos].val = h->v_cpy(keys[i].val);
+	}
+
+	free(keys);
+
+	return f;
+}
+
+/*
+ * Find entry of a key. Return pointer to it, or NULL if the key is
+ * not in the table.
+ *
+ * @f:   Pointer to the frozen hash table structure
+ * @key: Key to find
+ */
+static struct fht_entry *fht_find(struct fht *f, void *key)
+{
+	uint64_t hash;
+	struct fht_entry *entry;
+
+	if (f->nmemb == 0)
+		return NULL;
+
+	hash = hash_key(key, f->get_key_size(key), f->seed);
+
+	/* Every key maps somewhere; one compare tells if it is ours */
+	entry = &f->entries[fht_pos(f, hash)];
+	if (f->k_cmp(entry->key, key) != 0)
+		return NULL;
+
+	return entry;
+}
+
+/*
+ * Search for a data in frozen hash table.
+ *
+ * @f:   Pointer to the frozen hash table structure
+ * @key: key of the data to be searched
+ */
+int fht_search(struct fht *f, void *key)
+{
+	int retval;
+
+	if (fht_find(f, key) != NULL)
+		retval = 1;
+	else
+		retval = 0;
+
+	return retval;
+}
+
+/*
+ * Get the val stored for a key. Return pointer to the val in the
+ * table (not a copy), or NULL if the key is not in the table.
+ *
+ * @f:   Pointer to the frozen hash table structure
+ * @key: key of the data to get
+ */
+void *fht_get(struct fht *f, void *key)
+{
+	struct fht_entry *entry;
+
+	entry = fht_find(f, key);
+	if (entry == NULL)
+		return NULL;
+
+	return entry->val;
+}
+
+/*
+ * Return the total members count.
+ *
+ * @f: Pointer to the frozen hash table structure
+ */
+size_t fht_tot_memb(struct fht *f)
+{
+	return f->nmemb;
+}
+
+/*
+ * Destroy a frozen hash table.
+ *
+ * @f: Pointer to the frozen hash table structure
+ */
+void fht_destroy(struct fht *f)
+{
+	size_t i;
+
+	for (i = 0; i < f->nmemb; i++) {
+		free(f->entries[i].key);
+		free(f->entries[i].val);
+	}
+
+	free(f->entries);
+	free(f->pilots);
+	free(f->remap);
+
+	free(f);
+}
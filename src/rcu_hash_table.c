@@ -0,0 +1,560 @@
+/*
+ * rcu_hash_table.c: Read mostly hash table, lock free readers (RCU)
+ *
+ * St: 2026-10-17 Sat 07:39 AM
+ * Up: 2026-10-17 Sat 08:40 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * For tables read far more often than written. Readers take no
+ * lock and do no atomic read-modify-write: a lookup is ebr_enter,
+ * acquire loads of the table pointer and of the chain links, and
+ * ebr_exit. ebr_enter and ebr_exit are plain stores to the reader's
+ * own cache line, with no fence where membarrier is available (see
+ * epoch.c). So readers on different cores share no written cache
+ * line and read throughput grows with cores.
+ *
+ * Writers are serialized by one mutex and never change a node that
+ * is reachable. They build a node in full, then publish it with a
+ * release store into a slot or a link, so a reader that sees the
+ * pointer also sees the node's contents. Replacing a val publishes
+ * a new node in place of the old one; deleting stores the old
+ * node's next pointer into its predecessor. The unlinked node is
+ * retired through the table's ebr and freed once no reader can
+ * still hold it.
+ *
+ * Growing builds a complete new table of new nodes (sharing the key
+ * and val copies), publishes it with one release store, and retires
+ * the whole old table in one go. Readers still walking the old
+ * table see a consistent old snapshot.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<stdatomic.h>
+#include<pthread.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/* Acquire and release loads and stores of published pointers */
+#define Rcu_load(p) atomic_load_explicit((p), memory_order_acquire)
+#define Rcu_store(p, v) atomic_store_explicit((p), (v), memory_order_release)
+
+/*
+ * Hash function.
+ *
+ * @h:   Pointer to the hash table structure. Needed to get
+ *       the key size.
+ * @key: Key whose hash value is to be calculated
+ */
+static uint64_t rcuht_hash_func(struct rcuht *h, void *key)
+{
+	return hash_key(key, h->get_key_size(key), HASH_SEED);
+}
+
+/*
+ * Round up to a power of 2, at least 2.
+ *
+ * @n: Number to round
+ */
+static size_t rcuht_round_slots(size_t n)
+{
+	size_t retval;
+
+	retval = 2;
+	while (retval < n)
+		retval *= 2;
+
+	return retval;
+}
+
+/*
+ * Allocate an empty table of `tot_slots' slots. The slots follow the
+ * table structure in the same block, so one free() releases both.
+ *
+ * @tot_slots: Total slots, a power of 2
+ */
+static struct rcuht_table *rcuht_table_create(size_t tot_slots)
+{
+	size_t i;
+	struct rcuht_table *t;
+
+	t = malloc(sizeof(struct rcuht_table) +
+	           tot_slots * sizeof(struct rcuht_node *_Atomic));
+	assert(t);
+
+	t->tot_slots = tot_slots;
+	t->slots = (struct rcuht_node *_Atomic *) (t + 1);
+	for (i = 0; i < tot_slots; i++)
+		atomic_init(&t->slots[i], NULL);
+
+	return t;
+}
+
+/*
+ * Free a table and its nodes, but not the keys and vals: they have
+ * moved to the nodes of a newer table. Passed to ebr_retire.
+ *
+ * @ptr: Pointer to the table
+ */
+static void rcuht_table_free(void *ptr)
+{
+	size_t i;
+	struct rcuht_table *t;
+	struct rcuht_node *n;
+	struct rcuht_node *next;
+
+	t = (struct rcuht_table *) ptr;
+
+	for (i = 0; i < t->tot_slots; i++)
+		for (n = atomic_load_explicit(&t->slots[i],
+		                              memory_order_relaxed);
+		     n != NULL; n = next) {
+			next = atomic_load_explicit(&n->next,
+			                            memory_order_relaxed);
+			free(n);
+		}
+
+	free(t);
+}
+
+/*
+ * Free a node with its key and val. Passed to ebr_retire.
+ *
+ * @ptr: Pointer to the node
+ */
+static void rcuht_node_free(void *ptr)
+{
+	struct rcuht_node *n;
+
+	n = (struct rcuht_node *) ptr;
+
+	free(n->key);
+	free(n->val);
+	free(n);
+}
+
+/*
+ * Free a node and its val, but not its key, which a newer node
+ * shares. Passed to ebr_retire.
+ *
+ * @ptr: Pointer to the node
+ */
+static void rcuht_node_free_val(void *ptr)
+{
+	struct rcuht_node *n;
+
+	n = (struct rcuht_node *) ptr;
+
+	free(n->val);
+	free(n);
+}
+
+/*
+ * Make a node.
+ *
+ * @key:  Key, not copied
+ * @val:  Val, not copied
+ * @hash: Hash of key
+ * @next: Next node
+ */
+static struct rcuht_node *rcuht_node_create(void *key, void *val,
+                                            uint64_t hash,
+                                            struct rcuht_node *next)
+{
+	struct rcuht_node *n;
+
+	n = malloc(sizeof(struct rcuht_node));
+	assert(n);
+
+	n->key = key;
+	n->val = val;
+	n->hash = hash;
+	atomic_init(&n->next, next);
+
+	return n;
+}
+
+/*
+ * Create a hash table.
+ *
+ * @tot_slots:    Total slots in the hash table. Rounded up to
+ *                a power of 2.
+ * @k_cpy:        Function to copy key
+ * @v_cpy:        Function to copy val
+ * @k_cmp:        Function to compare key
+ * @v_cmp:        Function to compare val
+ * @get_key_size: Function to get key size
+ */
+struct rcuht *rcuht_create(size_t tot_slots,
+                           void *(*k_cpy) (void *),
+			   void *(*v_cpy) (void *),
+			   int (*k_cmp) (void *, void *),
+			   int (*v_cmp) (void *, void *),
+			   int (*get_key_size) (void *))
+{
+	struct rcuht *h;
+
+	h = malloc(sizeof(struct rcuht));
+	assert(h);
+
+	atomic_init(&h->table,
+	            rcuht_table_create(rcuht_round_slots(tot_slots)));
+	pthread_mutex_init(&h->wlock, NULL);
+	h->ebr = ebr_create();
+
+	h->nmemb = 0;
+	h->max_load = RCUHT_MAX_LOAD;
+
+	h->k_cpy = k_cpy;
+	h->v_cpy = v_cpy;
+
+	h->k_cmp = k_cmp;
+	h->v_cmp = v_cmp;
+
+	h->get_key_size = get_key_size;
+
+	return h;
+}
+
+/*
+ * Find the node of a key. Inside a read side critical section the
+ * node stays valid until rcuht_read_unlock. Return NULL if key is
+ * not in the table.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key to find
+ * @hash: Hash of key
+ */
+static struct rcuht_node *rcuht_find(struct rcuht *h, void *key,
+                                     uint64_t hash)
+{
+	struct rcuht_table *t;
+	struct rcuht_node *n;
+
+	t = Rcu_load(&h->table);
+
+	for (n = Rcu_load(&t->slots[hash & (t->tot_slots - 1)]); n != NULL;
+	     n = Rcu_load(&n->next))
+		if (n->hash == hash && h->k_cmp(n->key, key) == 0)
+			return n;
+
+	return NULL;
+}
+
+/*
+ * Start a read side critical section. Vals returned by rcuht_lookup
+ * stay valid until the matching rcuht_read_unlock. Sections may
+ * nest, and the other rcuht calls may be made inside one; vals
+ * looked up stay valid until the outermost unlock. Sections must be
+ * short: memory retired by writers is not freed while any reader is
+ * inside one.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void rcuht_read_lock(struct rcuht *h)
+{
+	ebr_enter(h->ebr);
+}
+
+/*
+ * End a read side critical section.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void rcuht_read_unlock(struct rcuht *h)
+{
+	ebr_exit(h->ebr);
+}
+
+/*
+ * Return pointer to the val stored for a key, without copying it,
+ * or NULL if key is not in the table. Must be called between
+ * rcuht_read_lock and rcuht_read_unlock; the val must not be used
+ * after the outermost rcuht_read_unlock, nor changed.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to look up
+ */
+void *rcuht_lookup(struct rcuht *h, void *key)
+{
+	struct rcuht_node *n;
+
+	n = rcuht_find(h, key, rcuht_hash_func(h, key));
+
+	return (n != NULL) ? n->val : NULL;
+}
+
+/*
+ * Search for a key. Return 1 if found, else 0.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to search
+ */
+int rcuht_search(struct rcuht *h, void *key)
+{
+	int retval;
+	uint64_t hash;
+
+	hash = rcuht_hash_func(h, key);
+
+	ebr_enter(h->ebr);
+	retval = rcuht_find(h, key, hash) != NULL;
+	ebr_exit(h->ebr);
+
+	return retval;
+}
+
+/*
+ * Get a copy of the val stored for a key, made with v_cpy. Caller
+ * owns the copy. Return NULL if key is not in the table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to get
+ */
+void *rcuht_get(struct rcuht *h, void *key)
+{
+	void *retval;
+	uint64_t hash;
+	struct rcuht_node *n;
+
+	hash = rcuht_hash_func(h, key);
+	retval = NULL;
+
+	ebr_enter(h->ebr);
+	n = rcuht_find(h, key, hash);
+	if (n != NULL)
+		retval = h->v_cpy(n->val);
+	ebr_exit(h->ebr);
+
+	return retval;
+}
+
+/*
+ * Double the table: copy every node into a new table, publish it,
+ * and retire the old one. Called with the write lock held, inside a
+ * critical section.
+ *
+ * @h: Pointer to the hash table structure
+ */
+static void rcuht_grow(struct rcuht *h)
+{
+	size_t i;
+	size_t idx;
+	struct rcuht_table *t;
+	struct rcuht_table *nt;
+	struct rcuht_node *n;
+	struct rcuht_node *head;
+
+	t = atomic_load_explicit(&h->table, memory_order_relaxed);
+	nt = rcuht_table_create(t->tot_slots * 2);
+
+	for (i = 0; i < t->tot_slots; i++)
+		for (n = atomic_load_explicit(&t->slots[i],
+		                              memory_order_relaxed);
+		     n != NULL;
+		     n = atomic_load_explicit(&n->next, memory_order_relaxed)) {
+			idx = n->hash & (nt->tot_slots - 1);
+			head = atomic_load_explicit(&nt->slots[idx],
+			                            memory_order_relaxed);
+			atomic_init(&nt->slots[idx],
+			            rcuht_node_create(n->key, n->val, n->hash,
+			                              head));
+		}
+
+	Rcu_store(&h->table, nt);
+	ebr_retire(h->ebr, t, rcuht_table_free);
+}
+
+/*
+ * Insert a new data to hash table. If the key is already present
+ * its val is replaced. Return 1 if a new member was inserted, 0 if
+ * a val was replaced.
+ *
+ * Readers see either the old or the new val, never a mix.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to be inserted
+ * @val: Val of the data to be inserted
+ */
+int rcuht_insert(struct rcuht *h, void *key, void *val)
+{
+	int retval;
+	uint64_t hash;
+	struct rcuht_table *t;
+	struct rcuht_node *n;
+	struct rcuht_node *new;
+	struct rcuht_node *next;
+	struct rcuht_node *_Atomic *link;
+
+	hash = rcuht_hash_func(h, key);
+
+	pthread_mutex_lock(&h->wlock);
+	ebr_enter(h->ebr);
+
+	t = atomic_load_explicit(&h->table, memory_order_relaxed);
+	link = &t->slots[hash & (t->tot_slots - 1)];
+
+	for (n = atomic_load_explicit(link, memory_order_relaxed); n != NULL;
+	     n = atomic_load_explicit(link, memory_order_relaxed)) {
+		if (n->hash == hash && h->k_cmp(n->key, key) == 0)
+			break;
+		link = &n->next;
+	}
+
+	if (n != NULL) {
+		/* Publish a node with the new val in place of the old */
+		next = atomic_load_explicit(&n->next, memory_order_relaxed);
+		new = rcuht_node_create(n->key, h->v_cpy(val), hash, next);
+		Rcu_store(link, new);
+		ebr_retire(h->ebr, n, rcuht_node_free_val);
+		retval = 0;
+	} else {
+		link = &t->slots[hash & (t->tot_slots - 1)];
+		next = atomic_load_explicit(link, memory_order_relaxed);
+		new = rcuht_node_create(h->k_cpy(key), h->v_cpy(val), hash,
+		                        next);
+		Rcu_store(link, new);
+		h->nmemb++;
+		retval = 1;
+
+		if (h->max_load > 0 &&
+		    h->nmemb > h->max_load * t->tot_slots)
+			rcuht_grow(h);
+	}
+
+	ebr_exit(h->ebr);
+	pthread_mutex_unlock(&h->wlock);
+
+	return retval;
+}
+
+/*
+ * Delete an item from hash table. Has no effect if item is not
+ * found in the hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Pointer to key of the item to delete
+ */
+void rcuht_delete(struct rcuht *h, void *key)
+{
+	uint64_t hash;
+	struct rcuht_table *t;
+	struct rcuht_node *n;
+	struct rcuht_node *_Atomic *link;
+
+	hash = rcuht_hash_func(h, key);
+
+	pthread_mutex_lock(&h->wlock);
+	ebr_enter(h->ebr);
+
+	t = atomic_load_explicit(&h->table, memory_order_relaxed);
+	link = &t->slots[hash & (t->tot_slots - 1)];
+
+	for (n = atomic_load_explicit(link, memory_order_relaxed); n != NULL;
+	     n = atomic_load_explicit(link, memory_order_relaxed)) {
+		if (n->hash == hash && h->k_cmp(n->key, key) == 0)
+			break;
+		link = &n->next;
+	}
+
+	if (n != NULL) {
+		/* Readers on n still reach the rest of the chain */
+		Rcu_store(link, atomic_load_explicit(&n->next,
+		                                     memory_order_relaxed));
+		ebr_retire(h->ebr, n, rcuht_node_free);
+		h->nmemb--;
+	}
+
+	ebr_exit(h->ebr);
+	pthread_mutex_unlock(&h->wlock);
+}
+
+/*
+ * Return total members in hash table.
+ *
+ * @h: Pointer to the hash table structure
+ */
+size_t rcuht_tot_memb(struct rcuht *h)
+{
+	size_t retval;
+
+	pthread_mutex_lock(&h->wlock);
+	retval = h->nmemb;
+	pthread_mutex_unlock(&h->wlock);
+
+	return retval;
+}
+
+/*
+ * Set the max load factor. Once nmemb / tot_slots goes beyond
+ * this, the table is doubled. A value <= 0 turns off growing.
+ *
+ * @h:        Pointer to the hash table structure
+ * @max_load: New max load factor
+ */
+void rcuht_set_max_load(struct rcuht *h, double max_load)
+{
+	pthread_mutex_lock(&h->wlock);
+	h->max_load = max_load;
+	pthread_mutex_unlock(&h->wlock);
+}
+
+/*
+ * Destroy hash table. No other thread may be using it.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void rcuht_destroy(struct rcuht *h)
+{
+	size_t i;
+	struct rcuht_table *t;
+	struct rcuht_node *n;
+	struct rcuht_node *next;
+
+	/* Retired memory first: old tables point to live keys */
+	ebr_destroy(h->ebr);
+
+	t = atomic_load(&h->table);
+	for (i = 0; i < t->tot_slots; i++)
+		for (n = atomic_load(&t->slots[i]); n != NULL; n = next) {
+			next = atomic_load(&n->next);
+			rcuht_node_free(n);
+		}
+	free(t);
+
+	pthread_mutex_destroy(&h->wlock);
+
+	free(h);
+}
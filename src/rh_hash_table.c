@@ -0,0 +1,642 @@
+/*
+ * rh_hash_table.c: Open addressing (Robin Hood) hash table in C
+ *
+ * St: 2026-10-17 Sat 07:02 AM
+ * Up: 2026-10-17 Sat 08:40 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * Unlike struct ht, which keeps a linked list per slot, this table
+ * keeps key, val and cached hash of every member inline in a single
+ * slot array (linear probing).
+ *
+ * Robin Hood rule: while inserting, if the member already sitting in
+ * a slot is closer to its home slot than the member being inserted,
+ * they swap places. This keeps probe lengths short and lets a search
+ * stop as soon as it sees a member closer to home than the key it is
+ * looking for.
+ *
+ * Deletion does not use tombstones. Members following the deleted one
+ * are shifted one slot back until an empty slot or a member at its
+ * home slot is reached (backward shift deletion).
+ *
+ * Fixed size mode (rht_create_fixed) is for small keys and vals of
+ * known size, e.g. ints. Key and val bytes are kept inline in a
+ * byte array of slots, so an insert copies bytes instead of calling
+ * malloc for key, val and node, and a probe reads key bytes from
+ * the slot itself. The probing, growing and deletion logic is the
+ * same; only slot access differs.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"mylib.h"
+
+#define SKIP
+
+/* Inline slot layout: hash, key, padding, val */
+#define Rht_fslot(h, idx)  ((h)->fixed + (idx) * (h)->slot_size)
+#define Rht_fkey(h, slot)  ((slot) + sizeof(uint64_t))
+#define Rht_fval(h, slot)  ((slot) + (h)->val_off)
+
+/* Round n up to a multiple of a, a power of 2 */
+#define Rht_round(n, a)  (((n) + (a) - 1) & ~((size_t) (a) - 1))
+
+/*
+ * Hash function.
+ *
+ * @h:   Pointer to the hash table structure. Needed to get
+ *       the key size.
+ * @key: Key whose hash value is to be calculated
+ */
+static size_t rht_hash_func(struct rht *h, void *key)
+{
+	if (h->fixed != NULL)
+		return hash_key(key, h->key_size, HASH_SEED);
+
+	return hash_key(key, h->get_key_size(key), HASH_SEED);
+}
+
+/*
+ * Return hash stored in an inline slot, 0 if the slot is empty.
+ *
+ * @slot: Pointer to the inline slot
+ */
+static uint64_t rht_fhash(unsigned char *slot)
+{
+	uint64_t hash;
+
+	memcpy(&hash, slot, sizeof(uint64_t));
+
+	return hash;
+}
+
+/*
+ * Return distance of the member at slot `idx' from its home slot.
+ *
+ * @h:   Pointer to the hash table structure
+ * @idx: Index of a non empty slot
+ */
+static size_t rht_dist(struct rht *h, size_t idx)
+{
+	size_t mask;
+	size_t hash;
+
+	mask = h->tot_slots - 1;
+
+	if (h->fixed != NULL)
+		hash = rht_fhash(Rht_fslot(h, idx));
+	else
+		hash = h->slots[idx].hash;
+
+	return (idx - (hash & mask)) & mask;
+}
+
+/*
+ * Round up the slot count to a power of 2, no smaller than
+ * RHT_MIN_SLOTS.
+ *
+ * @tot_slots: Requested slot count
+ */
+static size_t rht_round_slots(size_t tot_slots)
+{
+	size_t n;
+
+	n = RHT_MIN_SLOTS;
+	while (n < tot_slots)
+		n *= 2;
+
+	return n;
+}
+
+/*
+ * Create a Robin Hood hash table.
+ *
+ * @tot_slots:    Total slots in the hash table. Rounded up
+ *                to a power of 2.
+ * @k_cpy:        Function to copy key
+ * @v_cpy:        Function to copy val
+ * @k_cmp:        Function to compare key
+ * @v_cmp:        Function to compare val
+ * @get_key_size: Function to get key size
+ */
+struct rht *rht_create(size_t tot_slots,
+                       void *(*k_cpy) (void *),
+		       void *(*v_cpy) (void *),
+		       int (*k_cmp) (void *, void *),
+		       int (*v_cmp) (void *, void *),
+		       int (*get_key_size) (void *))
+{
+	struct rht *h;
+
+	h = malloc(sizeof(struct rht));
+	assert(h);
+
+	h->tot_slots = rht_round_slots(tot_slots);
+
+	/* calloc leaves every key NULL, i.e. every slot empty */
+	h->slots = calloc(h->tot_slots, sizeof(struct rht_slot));
+	assert(h->slots);
+
+	h->nmemb = 0;
+
+	h->k_cpy = k_cpy;
+	h->v_cpy = v_cpy;
+
+	h->k_cmp = k_cmp;
+	h->v_cmp = v_cmp;
+
+	h->get_key_size = get_key_size;
+
+	h->fixed = NULL;
+	h->tmp = NULL;
+	h->key_size = 0;
+	h->val_size = 0;
+	h->val_off = 0;
+	h->slot_size = 0;
+
+	return h;
+}
+
+/*
+ * Create a Robin Hood hash table in fixed size mode. Keys and vals
+ * are `key_size' and `val_size' bytes, and are stored inline in
+ * the slots; no callbacks are needed.
+ *
+ * @tot_slots: Total slots in the hash table. Rounded up
+ *             to a power of 2.
+ * @key_size:  Size of a key in bytes
+ * @val_size:  Size of a val in bytes
+ */
+struct rht *rht_create_fixed(size_t tot_slots, size_t key_size,
+                             size_t val_size)
+{
+	struct rht *h;
+	size_t val_align;
+
+	h = malloc(sizeof(struct rht));
+	assert(h);
+
+	h->tot_slots = rht_round_slots(tot_slots);
+	h->nmemb = 0;
+	h->slots = NULL;
+
+	h->key_size = key_size;
+	h->val_size = val_size;
+
+	/*
+	 * rht_get hands out a pointer to the val bytes, which the
+	 * caller may read as a long, double or pointer. Align the val
+	 * as the largest power of 2 up to 8 not above its size, and
+	 * keep the hash of every slot 8 byte aligned.
+	 */
+	val_align = 1;
+	while (val_align < sizeof(uint64_t) && val_align * 2 <= val_size)
+		val_align *= 2;
+	h->val_off = Rht_round(sizeof(uint64_t) + key_size, val_align);
+	h->slot_size = Rht_round(h->val_off + val_size, sizeof(uint64_t));
+
+	/* calloc leaves every hash 0, i.e. every slot empty */
+	h->fixed = calloc(h->tot_slots, h->slot_size);
+	assert(h->fixed);
+
+	h->tmp = malloc(2 * h->slot_size);
+	assert(h->tmp);
+
+	h->k_cpy = NULL;
+	h->v_cpy = NULL;
+
+	h->k_cmp = NULL;
+	h->v_cmp = NULL;
+
+	h->get_key_size = NULL;
+
+	return h;
+}
+
+/*
+ * Place a member in the slot array using Robin Hood rule. The key
+ * must not already be present. Return index of the slot where
+ * the member was placed.
+ *
+ * @h:    Pointer to the hash table structure
+ * @slot: Member to place. Its key and val are already copies
+ *        owned by the table.
+ */
+static size_t rht_place(struct rht *h, struct rht_slot slot)
+{
+	size_t idx;
+	size_t dist;
+	size_t mask;
+	size_t retval;
+	size_t cur_dist;
+	int placed;
+	struct rht_slot tmp;
+
+	mask = h->tot_slots - 1;
+	idx = slot.hash & mask;
+	dist = 0;
+	placed = 0;
+	retval = idx;
+
+	while (h->slots[idx].key != NULL) {
+		/* Rob the richer member of its slot */
+		cur_dist = rht_dist(h, idx);
+		if (cur_dist < dist) {
+			tmp = h->slots[idx];
+			h->slots[idx] = slot;
+			slot = tmp;
+			dist = cur_dist;
+			if (placed == 0) {
+				retval = idx;
+				placed = 1;
+			}
+		}
+		idx = (idx + 1) & mask;
+		dist++;
+	}
+
+	h->slots[idx] = slot;
+	if (placed == 0)
+		retval = idx;
+
+	return retval;
+}
+
+/*
+ * Place a member in the inline slot array using Robin Hood rule,
+ * like rht_place. The key must not already be present. Return
+ * index of the slot where the member was placed.
+ *
+ * @h:   Pointer to the hash table structure
+ * @cur: Inline slot holding the member; must be h->tmp, and is
+ *       clobbered
+ */
+static size_t rht_fixed_place(struct rht *h, unsigned char *cur)
+{
+	size_t idx;
+	size_t dist;
+	size_t mask;
+	size_t retval;
+	size_t cur_dist;
+	int placed;
+	unsigned char *slot;
+	unsigned char *swap;
+
+	mask = h->tot_slots - 1;
+	idx = rht_fhash(cur) & mask;
+	dist = 0;
+	placed = 0;
+	retval = idx;
+	swap = h->tmp + h->slot_size;
+
+	while (rht_fhash(slot = Rht_fslot(h, idx)) != 0) {
+		/* Rob the richer member of its slot */
+		cur_dist = rht_dist(h, idx);
+		if (cur_dist < dist) {
+			memcpy(swap, slot, h->slot_size);
+			memcpy(slot, cur, h->slot_size);
+			memcpy(cur, swap, h->slot_size);
+			dist = cur_dist;
+			if (placed == 0) {
+				retval = idx;
+				placed = 1;
+			}
+		}
+		idx = (idx + 1) & mask;
+		dist++;
+	}
+
+	memcpy(slot, cur, h->slot_size);
+	if (placed == 0)
+		retval = idx;
+
+	return retval;
+}
+
+/*
+ * Double the inline slot array and place every member again.
+ *
+ * @h: Pointer to the hash table structure
+ */
+static void rht_fixed_grow(struct rht *h)
+{
+	size_t i;
+	size_t old_tot_slots;
+	unsigned char *old_fixed;
+	unsigned char *slot;
+
+	old_fixed = h->fixed;
+	old_tot_slots = h->tot_slots;
+
+	h->tot_slots *= 2;
+	h->fixed = calloc(h->tot_slots, h->slot_size);
+	assert(h->fixed);
+
+	for (i = 0; i < old_tot_slots; i++) {
+		slot = old_fixed + i * h->slot_size;
+		if (rht_fhash(slot) != 0) {
+			memcpy(h->tmp, slot, h->slot_size);
+			rht_fixed_place(h, h->tmp);
+		}
+	}
+
+	free(old_fixed);
+}
+
+/*
+ * Double the slot array and place every member again.
+ *
+ * @h: Pointer to the hash table structure
+ */
+static void rht_grow(struct rht *h)
+{
+	size_t i;
+	size_t old_tot_slots;
+	struct rht_slot *old_slots;
+
+	if (h->fixed != NULL) {
+		rht_fixed_grow(h);
+		return;
+	}
+
+	old_slots = h->slots;
+	old_tot_slots = h->tot_slots;
+
+	h->tot_slots *= 2;
+	h->slots = calloc(h->tot_slots, sizeof(struct rht_slot));
+	assert(h->slots);
+
+	for (i = 0; i < old_tot_slots; i++)
+		if (old_slots[i].key != NULL)
+			rht_place(h, old_slots[i]);
+
+	free(old_slots);
+}
+
+/*
+ * Find inline slot holding a key, like rht_find.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key to find
+ * @hash: Hash of the key, with RHT_FIXED_USED set
+ */
+static long rht_fixed_find(struct rht *h, void *key, uint64_t hash)
+{
+	size_t idx;
+	size_t dist;
+	size_t mask;
+	uint64_t cur;
+	unsigned char *slot;
+
+	mask = h->tot_slots - 1;
+	idx = hash & mask;
+	dist = 0;
+
+	while ((cur = rht_fhash(slot = Rht_fslot(h, idx))) != 0 &&
+	       rht_dist(h, idx) >= dist) {
+		if (cur == hash &&
+		    memcmp(Rht_fkey(h, slot), key, h->key_size) == 0)
+			return idx;
+		idx = (idx + 1) & mask;
+		dist++;
+	}
+
+	return -1;
+}
+
+/*
+ * Find slot holding a key. Return its index, or -1 if the key
+ * is not in the table.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key to find
+ * @hash: Hash of the key
+ */
+static long rht_find(struct rht *h, void *key, size_t hash)
+{
+	size_t idx;
+	size_t dist;
+	size_t mask;
+
+	if (h->fixed != NULL)
+		return rht_fixed_find(h, key, hash | RHT_FIXED_USED);
+
+	mask = h->tot_slots - 1;
+	idx = hash & mask;
+	dist = 0;
+
+	/*
+	 * Stop at an empty slot or at a member closer to its home
+	 * than we are to ours; the key would have robbed that slot.
+	 */
+	while (h->slots[idx].key != NULL && rht_dist(h, idx) >= dist) {
+		if (h->slots[idx].hash == hash &&
+		    h->k_cmp(h->slots[idx].key, key) == 0)
+			return idx;
+		idx = (idx + 1) & mask;
+		dist++;
+	}
+
+	return -1;
+}
+
+/*
+ * Insert a new data to hash table. If the key is already present
+ * its val is replaced. Return index of the slot holding the data.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to be inserted
+ * @val: Val of the data to be inserted
+ */
+int rht_insert(struct rht *h, void *key, void *val)
+{
+	long idx;
+	size_t hash;
+	uint64_t fhash;
+	struct rht_slot slot;
+
+	hash = rht_hash_func(h, key);
+
+	/* Replace val if key is already present */
+	idx = rht_find(h, key, hash);
+	if (idx >= 0 && h->fixed != NULL) {
+		memcpy(Rht_fval(h, Rht_fslot(h, idx)), val, h->val_size);
+		return idx;
+	} else if (idx >= 0) {
+		free(h->slots[idx].val);
+		h->slots[idx].val = h->v_cpy(val);
+		return idx;
+	}
+
+	/* Grow table if load factor would go beyond the limit */
+	if ((h->nmemb + 1) * RHT_LOAD_DEN > h->tot_slots * RHT_LOAD_NUM)
+		rht_grow(h);
+
+	if (h->fixed != NULL) {
+		fhash = hash | RHT_FIXED_USED;
+		memcpy(h->tmp, &fhash, sizeof(uint64_t));
+		memcpy(Rht_fkey(h, h->tmp), key, h->key_size);
+		memcpy(Rht_fval(h, h->tmp), val, h->val_size);
+		h->nmemb++;
+		return rht_fixed_place(h, h->tmp);
+	}
+
+	slot.key = h->k_cpy(key);
+	slot.val = h->v_cpy(val);
+	slot.hash = hash;
+
+	h->nmemb++;
+
+	return rht_place(h, slot);
+}
+
+/*
+ * Search for a data in hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to be searched
+ */
+int rht_search(struct rht *h, void *key)
+{
+	int retval;
+
+	if (rht_find(h, key, rht_hash_func(h, key)) >= 0)
+		retval = 1;
+	else
+		retval = 0;
+
+	return retval;
+}
+
+/*
+ * Get the val stored for a key. Return pointer to the val in the
+ * table (inline bytes in fixed size mode), or NULL if the key is
+ * not in the table. The pointer is valid until the next insert or
+ * delete.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to get
+ */
+void *rht_get(struct rht *h, void *key)
+{
+	long idx;
+
+	idx = rht_find(h, key, rht_hash_func(h, key));
+	if (idx < 0)
+		return NULL;
+
+	if (h->fixed != NULL)
+		return Rht_fval(h, Rht_fslot(h, idx));
+
+	return h->slots[idx].val;
+}
+
+/*
+ * Delete an item from hash table. Has no effect if item is not
+ * found in the hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Pointer to key of the item to delete
+ */
+void rht_delete(struct rht *h, void *key)
+{
+	long found;
+	size_t idx;
+	size_t next;
+	size_t mask;
+
+	found = rht_find(h, key, rht_hash_func(h, key));
+	if (found < 0)
+		return;
+
+	idx = found;
+	mask = h->tot_slots - 1;
+
+	if (h->fixed != NULL) {
+		next = (idx + 1) & mask;
+		while (rht_fhash(Rht_fslot(h, next)) != 0 &&
+		       rht_dist(h, next) > 0) {
+			memcpy(Rht_fslot(h, idx), Rht_fslot(h, next),
+			       h->slot_size);
+			idx = next;
+			next = (next + 1) & mask;
+		}
+		memset(Rht_fslot(h, idx), 0, h->slot_size);
+		h->nmemb--;
+		return;
+	}
+
+	free(h->slots[idx].key);
+	free(h->slots[idx].val);
+
+	/* Shift following members back by one slot */
+	next = (idx + 1) & mask;
+	while (h->slots[next].key != NULL && rht_dist(h, next) > 0) {
+		h->slots[idx] = h->slots[next];
+		idx = next;
+		next = (next + 1) & mask;
+	}
+
+	h->slots[idx].key = NULL;
+	h->slots[idx].val = NULL;
+
+	h->nmemb--;
+}
+
+/*
+ * Destroy a hash table.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void rht_destroy(struct rht *h)
+{
+	size_t i;
+
+	if (h->fixed != NULL) {
+		free(h->fixed);
+		free(h->tmp);
+		free(h);
+		return;
+	}
+
+	for (i = 0; i < h->tot_slots; i++)
+		if (h->slots[i].key != NULL) {
+			free(h->slots[i].key);
+			free(h->slots[i].val);
+		}
+
+	free(h->slots);
+
+	free(h);
+}
@@ -0,0 +1,489 @@
+/*
+ * swiss_table.c: Swiss table (control byte) hash table in C
+ *
+ * St: 2026-10-17 Sat 07:06 AM
+ * Up: 2026-10-17 Sat 07:06 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Design notes:
+ *
+ * Hash of a key is split in two. The high bits (h1) pick the first
+ * group of slots to look at, the low 7 bits (h2) are stored in the
+ * control byte of the slot the key goes to. Control byte of an empty
+ * slot is SWT_EMPTY and of a deleted slot SWT_DELETED; both have
+ * the sign bit set, so they never match a h2.
+ *
+ * A lookup loads SWT_GROUP_WIDTH control bytes starting at its probe
+ * position and gets a bit mask of bytes equal to h2 (one SSE2 compare
+ * when available). Only those slots are compared with k_cmp. If the
+ * group has an empty slot the key is not in the table; else the next
+ * group is tried (triangular probing, which visits every group).
+ *
+ * The first SWT_GROUP_WIDTH control bytes are cloned after the last
+ * one, so that a group starting near the end of the table can be
+ * loaded without wrapping.
+ *
+ * Tables are kept at most 7/8 full. Deleted slots count as full for
+ * that purpose, and are cleared by a rehash to the same size when
+ * the table runs out of room without being really full.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#ifdef __SSE2__
+#include<emmintrin.h>
+#endif
+
+#include"mylib.h"
+
+#define SKIP
+
+/* Max load is SWT_LOAD_NUM / SWT_LOAD_DEN */
+#define SWT_LOAD_NUM 7
+#define SWT_LOAD_DEN 8
+
+/*
+ * Return bit mask of control bytes in the group at `ctrl' which
+ * are equal to `h2'.
+ *
+ * @ctrl: Pointer to first control byte of the group
+ * @h2:   Value to match
+ */
+static unsigned swt_match(const signed char *ctrl, signed char h2)
+{
+#ifdef __SSE2__
+	__m128i group;
+
+	group = _mm_loadu_si128((const __m128i *) ctrl);
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), group));
+#else
+	int i;
+	unsigned mask;
+
+	mask = 0;
+	for (i = 0; i < SWT_GROUP_WIDTH; i++)
+		if (ctrl[i] == h2)
+			mask |= 1U << i;
+
+	return mask;
+#endif
+}
+
+/*
+ * Return bit mask of empty or deleted slots in the group at `ctrl'.
+ *
+ * @ctrl: Pointer to first control byte of the group
+ */
+static unsigned swt_match_free(const signed char *ctrl)
+{
+#ifdef __SSE2__
+	__m128i group;
+
+	group = _mm_loadu_si128((const __m128i *) ctrl);
+
+	/* Empty and deleted are the only values below -1 */
+	return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), group));
+#else
+	int i;
+	unsigned mask;
+
+	mask = 0;
+	for (i = 0; i < SWT_GROUP_WIDTH; i++)
+		if (ctrl[i] < -1)
+			mask |= 1U << i;
+
+	return mask;
+#endif
+}
+
+/*
+ * Return index of lowest set bit of a non zero mask.
+ *
+ * @mask: Bit mask
+ */
+static int swt_ctz(unsigned mask)
+{
+#ifdef __GNUC__
+	return __builtin_ctz(mask);
+#else
+	int n;
+
+	for (n = 0; (mask & 1) == 0; n++)
+		mask >>= 1;
+
+	return n;
+#endif
+}
+
+/*
+ * Return number of zero bits above the highest set bit of a 16 bit
+ * mask, 16 for a zero mask.
+ *
+ * @mask: Bit mask
+ */
+static int swt_clz16(unsigned mask)
+{
+	int n;
+
+	for (n = 0; n < SWT_GROUP_WIDTH; n++)
+		if (mask & (1U << (SWT_GROUP_WIDTH - 1 - n)))
+			break;
+
+	return n;
+}
+
+/*
+ * Set control byte of a slot, keeping the cloned bytes in sync.
+ *
+ * @h:   Pointer to the hash table structure
+ * @idx: Slot index
+ * @c:   New control byte
+ */
+static void swt_set_ctrl(struct swt *h, size_t idx, signed char c)
+{
+	h->ctrl[idx] = c;
+	if (idx < SWT_GROUP_WIDTH)
+		h->ctrl[h->tot_slots + idx] = c;
+}
+
+/*
+ * Hash function.
+ *
+ * @h:   Pointer to the hash table structure. Needed to get
+ *       the key size.
+ * @key: Key whose hash value is to be calculated
+ */
+static size_t swt_hash_func(struct swt *h, void *key)
+{
+	return hash_key(key, h->get_key_size(key), HASH_SEED);
+}
+
+/*
+ * Allocate empty control and slot arrays for `tot_slots' slots.
+ *
+ * @h:         Pointer to the hash table structure
+ * @tot_slots: Total slots, a power of 2 >= SWT_GROUP_WIDTH
+ */
+static void swt_alloc(struct swt *h, size_t tot_slots)
+{
+	h->tot_slots = tot_slots;
+
+	h->ctrl = malloc(tot_slots + SWT_GROUP_WIDTH);
+	assert(h->ctrl);
+	memset(h->ctrl, SWT_EMPTY, tot_slots + SWT_GROUP_WIDTH);
+
+	h->slots = malloc(tot_slots * sizeof(struct swt_slot));
+	assert(h->slots);
+
+	h->growth_left = tot_slots * SWT_LOAD_NUM / SWT_LOAD_DEN - h->nmemb;
+}
+
+/*
+ * Create a swiss table.
+ *
+ * @tot_slots:    Total slots in the hash table. Rounded up
+ *                to a power of 2, at least SWT_GROUP_WIDTH.
+ * @k_cpy:        Function to copy key
+ * @v_cpy:        Function to copy val
+ * @k_cmp:        Function to compare key
+ * @v_cmp:        Function to compare val
+ * @get_key_size: Function to get key size
+ */
+struct swt *swt_create(size_t tot_slots,
+                       void *(*k_cpy) (void *),
+		       void *(*v_cpy) (void *),
+		       int (*k_cmp) (void *, void *),
+		       int (*v_cmp) (void *, void *),
+		       int (*get_key_size) (void *))
+{
+	size_t n;
+	struct swt *h;
+
+	h = malloc(sizeof(struct swt));
+	assert(h);
+
+	n = SWT_GROUP_WIDTH;
+	while (n < tot_slots)
+		n *= 2;
+
+	h->nmemb = 0;
+	swt_alloc(h, n);
+
+	h->k_cpy = k_cpy;
+	h->v_cpy = v_cpy;
+
+	h->k_cmp = k_cmp;
+	h->v_cmp = v_cmp;
+
+	h->get_key_size = get_key_size;
+
+	return h;
+}
+
+/*
+ * Find slot holding a key. Return its index, or -1 if the key
+ * is not in the table.
+ *
+ * @h:    Pointer to the hash table structure
+ * @key:  Key to find
+ * @hash: Hash of the key
+ */
+static long swt_find(struct swt *h, void *key, size_t hash)
+{
+	size_t pos;
+	size_t step;
+	size_t mask;
+	size_t idx;
+	unsigned match;
+	signed char h2;
+
+	mask = h->tot_slots - 1;
+	pos = (hash >> 7) & mask;
+	h2 = hash & 0x7f;
+	step = 0;
+
+	for (;;) {
+		match = swt_match(h->ctrl + pos, h2);
+		while (match != 0) {
+			idx = (pos + swt_ctz(match)) & mask;
+			if (h->k_cmp(h->slots[idx].key, key) == 0)
+				return idx;
+			match &= match - 1;
+		}
+
+		/* An empty slot ends the probe sequence */
+		if (swt_match(h->ctrl + pos, SWT_EMPTY) != 0)
+			return -1;
+
+		step += SWT_GROUP_WIDTH;
+		pos = (pos + step) & mask;
+	}
+}
+
+/*
+ * Find first empty or deleted slot on the probe sequence of a hash.
+ * There is always one, as the table is never full.
+ *
+ * @h:    Pointer to the hash table structure
+ * @hash: Hash of the key to be placed
+ */
+static size_t swt_find_free(struct swt *h, size_t hash)
+{
+	size_t pos;
+	size_t step;
+	size_t mask;
+	unsigned match;
+
+	mask = h->tot_slots - 1;
+	pos = (hash >> 7) & mask;
+	step = 0;
+
+	for (;;) {
+		match = swt_match_free(h->ctrl + pos);
+		if (match != 0)
+			return (pos + swt_ctz(match)) & mask;
+
+		step += SWT_GROUP_WIDTH;
+		pos = (pos + step) & mask;
+	}
+}
+
+/*
+ * Move all members to new arrays of `tot_slots' slots. This also
+ * clears deleted slots. Keys and vals are moved, not copied.
+ *
+ * @h:         Pointer to the hash table structure
+ * @tot_slots: New total slots
+ */
+static void swt_rehash(struct swt *h, size_t tot_slots)
+{
+	size_t i;
+	size_t idx;
+	size_t hash;
+	size_t old_tot_slots;
+	signed char *old_ctrl;
+	struct swt_slot *old_slots;
+
+	old_ctrl = h->ctrl;
+	old_slots = h->slots;
+	old_tot_slots = h->tot_slots;
+
+	swt_alloc(h, tot_slots);
+
+	for (i = 0; i < old_tot_slots; i++) {
+		if (old_ctrl[i] < 0)
+			continue;
+		hash = swt_hash_func(h, old_slots[i].key);
+		idx = swt_find_free(h, hash);
+		swt_set_ctrl(h, idx, hash & 0x7f);
+		h->slots[idx] = old_slots[i];
+	}
+
+	free(old_ctrl);
+	free(old_slots);
+}
+
+/*
+ * Insert a new data to hash table. If the key is already present
+ * its val is replaced. Return index of the slot holding the data.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Key of the data to be inserted
+ * @val: Val of the data to be inserted
+ */
+int swt_insert(struct swt *h, void *key, void *val)
+{
+	long found;
+	size_t idx;
+	size_t hash;
+
+	hash = swt_hash_func(h, key);
+
+	/* Replace val if key is already present */
+	found = swt_find(h, key, hash);
+	if (found >= 0) {
+		free(h->slots[found].val);
+		h->slots[found].val = h->v_cpy(val);
+		return found;
+	}
+
+	idx = swt_find_free(h, hash);
+
+	/*
+	 * Filling an empty slot uses up room. If there is none left,
+	 * grow; or if it is deleted slots that use it up, rehash to
+	 * the same size to clear them.
+	 */
+	if (h->growth_left == 0 && h->ctrl[idx] == SWT_EMPTY) {
+		if (h->nmemb * 2 * SWT_LOAD_DEN >= h->tot_slots * SWT_LOAD_NUM)
+			swt_rehash(h, h->tot_slots * 2);
+		else
+			swt_rehash(h, h->tot_slots);
+		idx = swt_find_free(h, hash);
+	}
+
+	if (h->ctrl[idx] == SWT_EMPTY)
+		h->growth_left--;
+
+	swt_set_ctrl(h, idx, hash & 0x7f);
+	h->slots[idx].key = h->k_cpy(key);
+	h->slots[idx].val = h->v_cpy(val);
+
+	h->nmemb++;
+
+	return idx;
+}
+
+/*
+ * Search for a data in hash table.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: key of the data to be searched
+ */
+int swt_search(struct swt *h, void *key)
+{
+	int retval;
+
+	if (swt_find(h, key, swt_hash_func(h, key)) >= 0)
+		retval = 1;
+	else
+		retval = 0;
+
+	return retval;
+}
+
+/*
+ * Delete an item from hash table. Has no effect if item is not
+ * found in the hash table.
+ *
+ * The slot can be marked empty (instead of deleted) only if no
+ * group containing it was ever seen full by an insert; else a
+ * lookup could stop at it too early. That is known to be the case
+ * if the run of non empty slots around it is shorter than a group.
+ *
+ * @h:   Pointer to the hash table structure
+ * @key: Pointer to key of the item to delete
+ */
+void swt_delete(struct swt *h, void *key)
+{
+	long found;
+	size_t idx;
+	size_t mask;
+	unsigned empty_after;
+	unsigned empty_before;
+
+	found = swt_find(h, key, swt_hash_func(h, key));
+	if (found < 0)
+		return;
+
+	idx = found;
+	mask = h->tot_slots - 1;
+
+	free(h->slots[idx].key);
+	free(h->slots[idx].val);
+
+	empty_after = swt_match(h->ctrl + idx, SWT_EMPTY);
+	empty_before = swt_match(h->ctrl + ((idx - SWT_GROUP_WIDTH) & mask),
+	                         SWT_EMPTY);
+
+	if (empty_after != 0 && empty_before != 0 &&
+	    swt_ctz(empty_after) + swt_clz16(empty_before) < SWT_GROUP_WIDTH) {
+		swt_set_ctrl(h, idx, SWT_EMPTY);
+		h->growth_left++;
+	} else {
+		swt_set_ctrl(h, idx, SWT_DELETED);
+	}
+
+	h->nmemb--;
+}
+
+/*
+ * Destroy a hash table.
+ *
+ * @h: Pointer to the hash table structure
+ */
+void swt_destroy(struct swt *h)
+{
+	size_t i;
+
+	for (i = 0; i < h->tot_slots; i++)
+		if (h->ctrl[i] >= 0) {
+			free(h->slots[i].key);
+			free(h->slots[i].val);
+		}
+
+	free(h->ctrl);
+	free(h->slots);
+
+	free(h);
+}
@@ -0,0 +1,129 @@
+/*
+ * test/bloomTest.c: Test blocked Bloom filter implementation
+ *
+ * St: 2026-10-17 Sat 07:16 AM
+ * Up: 2026-10-17 Sat 07:16 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define KEY_COUNT 10000
+#define PROBE_COUNT 100000
+#define MAX_FP_RATE 0.02
+
+/* Test bloom_create function */
+int test_bloom_create(void)
+{
+	struct bloom *b;
+
+	b = bloom_create(KEY_COUNT, BLOOM_BITS_PER_KEY);
+
+	/* Power of 2 blocks, enough bits, cache line aligned */
+	assert((b->nblocks & (b->nblocks - 1)) == 0);
+	assert(b->nblocks * BLOOM_BLOCK_WORDS * 64 >=
+	       KEY_COUNT * BLOOM_BITS_PER_KEY);
+	assert(((uintptr_t) b->blocks & 63) == 0);
+	assert(b->cap == KEY_COUNT);
+	assert(b->nkeys == 0);
+	assert(bloom_fp_rate(b) == 0);
+
+	bloom_destroy(b);
+
+	/* Bad sizes fall back to sane ones */
+	b = bloom_create(0, 0);
+	assert(b->nblocks == 1);
+	assert(b->bits_per_key == BLOOM_BITS_PER_KEY);
+	bloom_destroy(b);
+
+	return 1;
+}
+
+/*
+ * Test that added keys are always found, and that absent keys
+ * are let through at about the expected rate.
+ */
+int test_bloom_add_check(void)
+{
+	uint64_t i;
+	uint64_t hash;
+	size_t fp;
+	struct bloom *b;
+
+	b = bloom_create(KEY_COUNT, BLOOM_BITS_PER_KEY);
+
+	for (i = 0; i < KEY_COUNT; i++)
+		bloom_add(b, hash_u64(i, HASH_SEED));
+	assert(b->nkeys == KEY_COUNT);
+
+	for (i = 0; i < KEY_COUNT; i++)
+		assert(bloom_may_contain(b, hash_u64(i, HASH_SEED)) == 1);
+	assert(b->nneg == 0);
+
+	fp = 0;
+	for (i = KEY_COUNT; i < KEY_COUNT + PROBE_COUNT; i++) {
+		hash = hash_u64(i, HASH_SEED);
+		if (bloom_may_contain(b, hash)) {
+			bloom_false_pos(b);
+			fp++;
+		}
+	}
+	assert(fp == b->nfp);
+	assert(b->nfp + b->nneg == PROBE_COUNT);
+	assert(bloom_fp_rate(b) < MAX_FP_RATE);
+
+	bloom_destroy(b);
+
+	/* Weak hashes (small ints) must spread over blocks too */
+	b = bloom_create(KEY_COUNT, BLOOM_BITS_PER_KEY);
+	for (i = 0; i < KEY_COUNT; i++)
+		bloom_add(b, i);
+	fp = 0;
+	for (i = KEY_COUNT; i < KEY_COUNT + PROBE_COUNT; i++)
+		fp += bloom_may_contain(b, i);
+	assert(fp < MAX_FP_RATE * 2 * PROBE_COUNT);
+
+	bloom_destroy(b);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_bloom_create();
+	test_bloom_add_check();
+
+	return 0;
+}
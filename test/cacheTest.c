@@ -0,0 +1,444 @@
+/*
+ * test/cacheTest.c: Test cache implementation, replay traces
+ *
+ * St: 2026-10-17 Sat 07:25 AM
+ * Up: 2026-10-17 Sat 07:25 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<math.h>
+#include<pthread.h>
+#include<time.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define CAP 100
+#define TOT_SHARDS 8
+#define HOT_KEYS 50
+#define SCAN_KEYS 10000
+#define MAX_THREADS 8
+#define OPS_PER_THREAD 20000
+#define TRACE_KEYS 100000
+#define TRACE_LEN 1000000
+#define TRACE_CAP 2000
+#define ZIPF_ALPHA 0.9
+
+/* Work for one test thread */
+struct thread_arg {
+	struct cache *c;
+	unsigned seed;      /* random seed of the thread */
+};
+
+/*
+ * Return next number of a xorshift random sequence.
+ *
+ * @state: Pointer to the sequence state, not 0
+ */
+unsigned xorshift(unsigned *state)
+{
+	unsigned x;
+
+	x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+/* Test cache_create function */
+int test_cache_create(void)
+{
+	struct cache *c;
+
+	c = cache_create(CAP, 5, CACHE_CLOCK, cpy_i, cpy_i, cmp_i, cmp_i,
+	                 get_int_size);
+
+	/* Shards are rounded up to a power of 2 and share capacity */
+	assert(c->nshards == 8);
+	assert(c->shards[0].s.ring[0].cap == 0);
+	assert(c->shards[0].s.ring[1].cap == CAP / 8);
+	assert(c->shards[0].s.sketch == NULL);
+	assert(cache_tot_memb(c) == 0);
+	assert(cache_hit_rate(c) == 0);
+
+	cache_destroy(c);
+
+	c = cache_create(CAP, 1, CACHE_TINYLFU, cpy_i, cpy_i, cmp_i, cmp_i,
+	                 get_int_size);
+	assert(c->shards[0].s.ring[0].cap == 1);
+	assert(c->shards[0].s.ring[1].cap == CAP - 1);
+	assert(c->shards[0].s.sketch != NULL);
+	cache_destroy(c);
+
+	return 1;
+}
+
+/*
+ * Test get, put and erase, for both policies.
+ *
+ * Following tests are performed:
+ *
+ * 1. A cache below capacity keeps everything
+ * 2. Capacity is never exceeded, by entries or by charge
+ * 3. A val bigger than capacity is not cached
+ * 4. Put of a cached key replaces its val
+ */
+int test_cache_get_put(int policy)
+{
+	int i;
+	int v;
+	int *vptr;
+	struct cache *c;
+
+	c = cache_create(CAP, 1, policy, cpy_i, cpy_i, cmp_i, cmp_i,
+	                 get_int_size);
+
+	for (i = 0; i < CAP; i++) {
+		v = i * 3;
+		cache_put(c, &i, &v, 1);
+	}
+	assert(cache_tot_memb(c) == CAP);
+	for (i = 0; i < CAP; i++) {
+		vptr = cache_get(c, &i);
+		assert(vptr != NULL && *vptr == i * 3);
+		free(vptr);
+	}
+	assert(cache_hit_rate(c) == 1);
+
+	i = 7;
+	v = 700;
+	cache_put(c, &i, &v, 1);
+	vptr = cache_get(c, &i);
+	assert(*vptr == 700);
+	free(vptr);
+	assert(cache_tot_memb(c) == CAP);
+
+	cache_erase(c, &i);
+	assert(cache_get(c, &i) == NULL);
+	assert(cache_tot_memb(c) == CAP - 1);
+	cache_erase(c, &i);
+
+	for (i = CAP; i < 10 * CAP; i++) {
+		cache_put(c, &i, &i, 1);
+		assert(cache_tot_memb(c) <= CAP);
+	}
+
+	cache_destroy(c);
+
+	/* Charge in bytes: room for 10 vals of 10 */
+	c = cache_create(CAP, 1, policy, cpy_i, cpy_i, cmp_i, cmp_i,
+	                 get_int_size);
+	for (i = 0; i < CAP; i++) {
+		cache_put(c, &i, &i, 10);
+		assert(cache_tot_memb(c) <= 10);
+	}
+	i = -1;
+	cache_put(c, &i, &i, CAP + 1);
+	assert(cache_get(c, &i) == NULL);
+
+	/* Growing the charge of a cached val evicts others */
+	i = CAP - 1;
+	cache_put(c, &i, &i, 10);
+	cache_put(c, &i, &i, CAP / 2);
+	assert(cache_tot_memb(c) <= CAP / 2 / 10 + 1);
+
+	cache_destroy(c);
+
+	return 1;
+}
+
+/*
+ * Test scan resistance: a hot set that keeps being used should
+ * survive a scan of keys used once under CACHE_TINYLFU, while
+ * CLOCK lets the scan flush it. Return the hit rate on the hot set
+ * during the scan.
+ *
+ * @policy: Eviction policy
+ */
+double test_cache_scan(int policy)
+{
+	int i;
+	int j;
+	int *vptr;
+	int hits;
+	struct cache *c;
+
+	c = cache_create(CAP, 1, policy, cpy_i, cpy_i, cmp_i, cmp_i,
+	                 get_int_size);
+
+	for (j = 0; j < 10; j++)
+		for (i = 0; i < HOT_KEYS; i++) {
+			vptr = cache_get(c, &i);
+			if (vptr == NULL)
+				cache_put(c, &i, &i, 1);
+			free(vptr);
+		}
+
+	/* One hot key is used for every 2 scan keys */
+	hits = 0;
+	for (i = HOT_KEYS; i < HOT_KEYS + SCAN_KEYS; i++) {
+		if (cache_get(c, &i) == NULL)
+			cache_put(c, &i, &i, 1);
+		if (i % 2)
+			continue;
+		j = (i / 2) % HOT_KEYS;
+		vptr = cache_get(c, &j);
+		if (vptr == NULL)
+			cache_put(c, &j, &j, 1);
+		hits += (vptr != NULL);
+		free(vptr);
+	}
+
+	if (policy == CACHE_TINYLFU)
+		assert(hits > SCAN_KEYS / 2 * 9 / 10);
+
+	cache_destroy(c);
+
+	return (double) hits / (SCAN_KEYS / 2);
+}
+
+/* Thread body: random gets, puts on miss, and some erases */
+void *worker(void *arg)
+{
+	int i;
+	int k;
+	int *vptr;
+	struct thread_arg *ta;
+
+	ta = arg;
+	for (i = 0; i < OPS_PER_THREAD; i++) {
+		k = xorshift(&ta->seed) % (4 * CAP);
+		vptr = cache_get(ta->c, &k);
+		if (vptr == NULL)
+			cache_put(ta->c, &k, &k, 1);
+		else
+			assert(*vptr == k);
+		free(vptr);
+		if (i % 100 == 0)
+			cache_erase(ta->c, &k);
+	}
+
+	return NULL;
+}
+
+/* Test many threads using one cache */
+int test_cache_threads(int policy)
+{
+	int i;
+	struct cache *c;
+	pthread_t tid[MAX_THREADS];
+	struct thread_arg ta[MAX_THREADS];
+
+	c = cache_create(CAP, TOT_SHARDS, policy, cpy_i, cpy_i, cmp_i, cmp_i,
+	                 get_int_size);
+
+	for (i = 0; i < MAX_THREADS; i++) {
+		ta[i].c = c;
+		ta[i].seed = i + 1;
+		pthread_create(&tid[i], NULL, worker, &ta[i]);
+	}
+	for (i = 0; i < MAX_THREADS; i++)
+		pthread_join(tid[i], NULL);
+
+	assert(cache_tot_memb(c) <= CAP);
+	assert(cache_hit_rate(c) > 0);
+
+	cache_destroy(c);
+
+	return 1;
+}
+
+/*
+ * Make a trace of `len' keys: a Zipf distribution over TRACE_KEYS
+ * keys, with a one time scan of TRACE_KEYS fresh keys in the middle.
+ *
+ * @len: Length of the trace
+ */
+int *make_trace(size_t len)
+{
+	size_t i;
+	size_t lo;
+	size_t hi;
+	size_t mid;
+	unsigned seed;
+	double u;
+	double *cdf;
+	int *trace;
+
+	cdf = malloc(TRACE_KEYS * sizeof(double));
+	trace = malloc(len * sizeof(int));
+	assert(cdf && trace);
+
+	cdf[0] = 1;
+	for (i = 1; i < TRACE_KEYS; i++)
+		cdf[i] = cdf[i - 1] + 1 / pow(i + 1, ZIPF_ALPHA);
+
+	seed = 12345;
+	for (i = 0; i < len; i++) {
+		if (i >= len / 2 && i < len / 2 + TRACE_KEYS) {
+			trace[i] = TRACE_KEYS + (i - len / 2);
+			continue;
+		}
+		u = (double) xorshift(&seed) / 4294967296.0 *
+		    cdf[TRACE_KEYS - 1];
+		lo = 0;
+		hi = TRACE_KEYS - 1;
+		while (lo < hi) {
+			mid = (lo + hi) / 2;
+			if (cdf[mid] < u)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		/* Spread popular keys over the key space */
+		trace[i] = (lo * 2654435761U) % TRACE_KEYS;
+	}
+
+	free(cdf);
+
+	return trace;
+}
+
+/*
+ * Read a trace file of one integer key per line. Return the keys,
+ * and set *lenp to their count.
+ *
+ * @path: Path of the trace file
+ * @lenp: Set to the trace length
+ */
+int *read_trace(const char *path, size_t *lenp)
+{
+	int k;
+	size_t cap;
+	int *trace;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		perror(path);
+		exit(1);
+	}
+
+	cap = 1024;
+	trace = malloc(cap * sizeof(int));
+	assert(trace);
+	*lenp = 0;
+
+	while (fscanf(fp, "%d", &k) == 1) {
+		if (*lenp == cap) {
+			cap *= 2;
+			trace = realloc(trace, cap * sizeof(int));
+			assert(trace);
+		}
+		trace[(*lenp)++] = k;
+	}
+
+	fclose(fp);
+
+	return trace;
+}
+
+/*
+ * Replay a trace on a cache with each policy: get every key, and
+ * put it on a miss. Print hit rate and throughput.
+ *
+ * @name:  Name of the trace
+ * @trace: Keys
+ * @len:   Trace length
+ */
+int bench_cache_replay(const char *name, int *trace, size_t len)
+{
+	int p;
+	int *vptr;
+	size_t i;
+	double secs;
+	struct cache *c;
+	struct timespec t0;
+	struct timespec t1;
+	const int policy[2] = { CACHE_CLOCK, CACHE_TINYLFU };
+	const char *policy_name[2] = { "clock", "tinylfu" };
+
+	for (p = 0; p < 2; p++) {
+		c = cache_create(TRACE_CAP, TOT_SHARDS, policy[p], cpy_i, cpy_i,
+		                 cmp_i, cmp_i, get_int_size);
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (i = 0; i < len; i++) {
+			vptr = cache_get(c, &trace[i]);
+			if (vptr == NULL)
+				cache_put(c, &trace[i], &trace[i], 1);
+			free(vptr);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		printf("cache: %s: %-7s hit rate %.4f, %.2f M ops/s\n", name,
+		       policy_name[p], cache_hit_rate(c), len / secs / 1e6);
+
+		cache_destroy(c);
+	}
+
+	return 1;
+}
+
+/*
+ * main: start. With an argument, replay that trace file (one
+ * integer key per line) instead of the built in one.
+ */
+int main(int argc, char **argv)
+{
+	int *trace;
+	size_t len;
+
+	test_cache_create();
+	test_cache_get_put(CACHE_CLOCK);
+	test_cache_get_put(CACHE_TINYLFU);
+	printf("cache: hot set hit rate during scan: clock %.2f, tinylfu %.2f\n",
+	       test_cache_scan(CACHE_CLOCK), test_cache_scan(CACHE_TINYLFU));
+	test_cache_threads(CACHE_CLOCK);
+	test_cache_threads(CACHE_TINYLFU);
+
+	if (argc > 1) {
+		trace = read_trace(argv[1], &len);
+		bench_cache_replay(argv[1], trace, len);
+	} else {
+		len = TRACE_LEN;
+		trace = make_trace(len);
+		bench_cache_replay("zipf+scan", trace, len);
+	}
+	free(trace);
+
+	return 0;
+}
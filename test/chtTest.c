@@ -0,0 +1,254 @@
+/*
+ * test/chtTest.c: Test concurrent hash table implementation
+ *
+ * St: 2026-10-17 Sat 07:08 AM
+ * Up: 2026-10-17 Sat 07:08 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<pthread.h>
+#include<time.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define TOT_SLOTS 5
+#define TOT_STRIPES 16
+#define INSERT_COUNT 1000
+#define MAX_THREADS 16
+#define KEYS_PER_THREAD 2000
+#define LOOKUPS_PER_THREAD 100000
+
+/* Work for one test thread */
+struct thread_arg {
+	struct cht *h;
+	int first;          /* first key of the thread */
+	int count;          /* number of keys */
+	long found;         /* keys found by a reader */
+};
+
+/* Test cht_create function */
+int test_cht_create(void)
+{
+	struct cht *h;
+
+	h = cht_create(TOT_SLOTS, 5, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	/* Counts are rounded up to powers of 2 */
+	assert(h->nstripes == 8);
+	assert(h->tot_slots == 8);
+	assert(cht_tot_memb(h) == 0);
+
+	assert(test_cpy_i(h->k_cpy) == 1);
+	assert(test_cmp_i(h->k_cmp) == 1);
+	assert(test_cpy_i(h->v_cpy) == 1);
+	assert(test_cmp_i(h->v_cmp) == 1);
+	assert(test_get_size_i(h->get_key_size) == 1);
+
+	cht_destroy(h);
+
+	return 1;
+}
+
+/* Test concurrent hash table from one thread */
+int test_cht_kint_vint(void)
+{
+	int i;
+	int v;
+	int *vptr;
+	struct cht *h;
+
+	h = cht_create(TOT_SLOTS, TOT_STRIPES, cpy_i, cpy_i, cmp_i, cmp_i,
+	               get_int_size);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = i * 3;
+		assert(cht_insert(h, &i, &v) == 1);
+	}
+	assert(cht_tot_memb(h) == INSERT_COUNT);
+	assert(h->tot_slots >= INSERT_COUNT);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		vptr = cht_get(h, &i);
+		assert(*vptr == i * 3);
+		free(vptr);
+	}
+	i = INSERT_COUNT;
+	assert(cht_search(h, &i) == 0);
+	assert(cht_get(h, &i) == NULL);
+
+	/* Insert with an existing key replaces the val */
+	i = 7;
+	v = 700;
+	assert(cht_insert(h, &i, &v) == 0);
+	assert(cht_tot_memb(h) == INSERT_COUNT);
+	vptr = cht_get(h, &i);
+	assert(*vptr == 700);
+	free(vptr);
+
+	for (i = 1; i < INSERT_COUNT; i += 2)
+		cht_delete(h, &i);
+	assert(cht_tot_memb(h) == INSERT_COUNT / 2);
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(cht_search(h, &i) == !(i % 2));
+
+	cht_destroy(h);
+
+	return 1;
+}
+
+/* Thread body: insert keys first .. first + count - 1 */
+void *writer(void *arg)
+{
+	int i;
+	struct thread_arg *ta;
+
+	ta = arg;
+	for (i = ta->first; i < ta->first + ta->count; i++)
+		cht_insert(ta->h, &i, &i);
+
+	return NULL;
+}
+
+/* Thread body: look keys up, counting hits */
+void *reader(void *arg)
+{
+	int i;
+	int j;
+	struct thread_arg *ta;
+
+	ta = arg;
+	ta->found = 0;
+	for (j = 0; j < LOOKUPS_PER_THREAD; j++) {
+		i = ta->first + j % ta->count;
+		ta->found += cht_search(ta->h, &i);
+	}
+
+	return NULL;
+}
+
+/*
+ * Test concurrent inserts (which make the table grow) running next
+ * to readers, then check that every key made it.
+ */
+int test_cht_threads(void)
+{
+	int i;
+	int *vptr;
+	struct cht *h;
+	pthread_t tid[2 * MAX_THREADS];
+	struct thread_arg ta[2 * MAX_THREADS];
+
+	h = cht_create(TOT_SLOTS, TOT_STRIPES, cpy_i, cpy_i, cmp_i, cmp_i,
+	               get_int_size);
+
+	for (i = 0; i < MAX_THREADS; i++) {
+		ta[i].h = h;
+		ta[i].first = i * KEYS_PER_THREAD;
+		ta[i].count = KEYS_PER_THREAD;
+		pthread_create(&tid[i], NULL, writer, &ta[i]);
+
+		ta[MAX_THREADS + i] = ta[i];
+		pthread_create(&tid[MAX_THREADS + i], NULL, reader,
+		               &ta[MAX_THREADS + i]);
+	}
+	for (i = 0; i < 2 * MAX_THREADS; i++)
+		pthread_join(tid[i], NULL);
+
+	assert(cht_tot_memb(h) == MAX_THREADS * KEYS_PER_THREAD);
+	for (i = 0; i < MAX_THREADS * KEYS_PER_THREAD; i++) {
+		vptr = cht_get(h, &i);
+		assert(vptr != NULL && *vptr == i);
+		free(vptr);
+	}
+
+	cht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Print lookup throughput for 1, 2, 4, .. MAX_THREADS reader
+ * threads. Scaling is near linear as long as there are cores for
+ * the threads.
+ */
+int bench_cht_read_scaling(void)
+{
+	int i;
+	int nthreads;
+	double secs;
+	struct cht *h;
+	struct timespec t0;
+	struct timespec t1;
+	pthread_t tid[MAX_THREADS];
+	struct thread_arg ta[MAX_THREADS];
+
+	h = cht_create(KEYS_PER_THREAD, TOT_STRIPES, cpy_i, cpy_i, cmp_i,
+	               cmp_i, get_int_size);
+	for (i = 0; i < KEYS_PER_THREAD; i++)
+		cht_insert(h, &i, &i);
+
+	for (nthreads = 1; nthreads <= MAX_THREADS; nthreads *= 2) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (i = 0; i < nthreads; i++) {
+			ta[i].h = h;
+			ta[i].first = 0;
+			ta[i].count = KEYS_PER_THREAD;
+			pthread_create(&tid[i], NULL, reader, &ta[i]);
+		}
+		for (i = 0; i < nthreads; i++) {
+			pthread_join(tid[i], NULL);
+			assert(ta[i].found == LOOKUPS_PER_THREAD);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		printf("cht: %2d reader threads: %.2f M lookups/s\n", nthreads,
+		       nthreads * (double) LOOKUPS_PER_THREAD / secs / 1e6);
+	}
+
+	cht_destroy(h);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_cht_create();
+	test_cht_kint_vint();
+	test_cht_threads();
+	bench_cht_read_scaling();
+
+	return 0;
+}
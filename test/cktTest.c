@@ -0,0 +1,295 @@
+/*
+ * test/cktTest.c: Test cuckoo hash table implementation
+ *
+ * St: 2026-10-17 Sat 07:18 AM
+ * Up: 2026-10-17 Sat 08:22 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<time.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define TOT_SLOTS 5
+#define INSERT_COUNT 1000
+#define BENCH_SLOTS (1 << 18)
+#define BENCH_LOOKUPS 100000
+
+/*
+ * Check that every member is in one of its two buckets, that no
+ * key is there twice, and that nmemb is right.
+ *
+ * @h: Pointer to the hash table structure
+ */
+int ckt_is_sane(struct ckt *h)
+{
+	int i;
+	size_t b;
+	size_t b1;
+	size_t b2;
+	size_t nmemb;
+	struct ckt_bucket *bkt;
+
+	nmemb = 0;
+
+	/* Every bucket is one whole cache line */
+	assert(sizeof(struct ckt_bucket) == CKT_LINE);
+	assert((uintptr_t) h->buckets % CKT_LINE == 0);
+
+	for (b = 0; b < h->tot_buckets; b++)
+		for (i = 0; i < CKT_BUCKET_SLOTS; i++) {
+			bkt = &h->buckets[b];
+			if (bkt->key[i] == NULL)
+				continue;
+			nmemb++;
+			b1 = bkt->hash[i] & (h->tot_buckets - 1);
+			b2 = ((uint64_t) bkt->hash[i] >> 32) &
+			     (h->tot_buckets - 1);
+			if (b2 == b1)
+				b2 = b1 ^ 1;
+			assert(b == b1 || b == b2);
+			assert(ckt_get(h, bkt->key[i]) ==
+			       h->vals[b * CKT_BUCKET_SLOTS + i]);
+		}
+
+	assert(nmemb == h->nmemb);
+
+	return 1;
+}
+
+/* Test ckt_create function */
+int test_ckt_create(void)
+{
+	struct ckt *h;
+
+	h = ckt_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	/* Bucket count is a power of 2 with room for TOT_SLOTS */
+	assert(h->tot_buckets == 2);
+	assert(ckt_tot_memb(h) == 0);
+
+	assert(test_cpy_i(h->k_cpy) == 1);
+	assert(test_cmp_i(h->k_cmp) == 1);
+	assert(test_cpy_i(h->v_cpy) == 1);
+	assert(test_cmp_i(h->v_cmp) == 1);
+	assert(test_get_size_i(h->get_key_size) == 1);
+
+	ckt_destroy(h);
+
+	return 1;
+}
+
+/* Test cuckoo hash table with int key and int val */
+int test_ckt_kint_vint(void)
+{
+	int i;
+	int v;
+	struct ckt *h;
+
+	h = ckt_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	/* Insert enough members to make the table grow a few times */
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = i * 3;
+		assert(ckt_insert(h, &i, &v) == 1);
+	}
+	assert(ckt_tot_memb(h) == INSERT_COUNT);
+	assert(ckt_is_sane(h) == 1);
+
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(*(int *) ckt_get(h, &i) == i * 3);
+	i = INSERT_COUNT;
+	assert(ckt_search(h, &i) == 0);
+	assert(ckt_get(h, &i) == NULL);
+
+	/* Insert with an existing key replaces the val */
+	i = 7;
+	v = 700;
+	assert(ckt_insert(h, &i, &v) == 0);
+	assert(ckt_tot_memb(h) == INSERT_COUNT);
+	assert(*(int *) ckt_get(h, &i) == 700);
+
+	/* Delete every odd key */
+	for (i = 1; i < INSERT_COUNT; i += 2)
+		ckt_delete(h, &i);
+	assert(ckt_tot_memb(h) == INSERT_COUNT / 2);
+	assert(ckt_is_sane(h) == 1);
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(ckt_search(h, &i) == !(i % 2));
+
+	/* Deleting a missing key has no effect */
+	i = 1;
+	ckt_delete(h, &i);
+	assert(ckt_tot_memb(h) == INSERT_COUNT / 2);
+
+	ckt_destroy(h);
+
+	return 1;
+}
+
+/* Test that displacement lets the table fill up before growing */
+int test_ckt_load(void)
+{
+	int i;
+	size_t tot_buckets;
+	struct ckt *h;
+
+	h = ckt_create(BENCH_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	tot_buckets = h->tot_buckets;
+
+	for (i = 0; i < BENCH_SLOTS * 9 / 10; i++)
+		ckt_insert(h, &i, &i);
+
+	assert(h->tot_buckets == tot_buckets);
+	assert(ckt_is_sane(h) == 1);
+
+	ckt_destroy(h);
+
+	return 1;
+}
+
+/* Test cuckoo hash table with str key and str val */
+int test_ckt_kstr_vstr(void)
+{
+	struct ckt *h;
+
+	h = ckt_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+
+	ckt_insert(h, "name", "lahm");
+	ckt_insert(h, "game", "football");
+	ckt_insert(h, "place", "munich");
+	ckt_insert(h, "country", "germany");
+	ckt_insert(h, "team", "bayern");
+	ckt_insert(h, "name", "phillip");
+	ckt_insert(h, "ab", "thomas");
+	ckt_insert(h, "ba", "thomas");
+	assert(ckt_tot_memb(h) == 7);
+
+	assert(strcmp(ckt_get(h, "name"), "phillip") == 0);
+	assert(ckt_search(h, "tameee") == 0);
+	ckt_delete(h, "ab");
+	assert(ckt_search(h, "ab") == 0);
+	assert(ckt_search(h, "ba") == 1);
+	assert(ckt_is_sane(h) == 1);
+
+	ckt_destroy(h);
+
+	return 1;
+}
+
+/* Compare two longs, for qsort */
+int cmp_long(const void *a, const void *b)
+{
+	long x;
+	long y;
+
+	x = *(const long *) a;
+	y = *(const long *) b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * Print p50 and p99.9 lookup latency as the table fills, for the
+ * cuckoo table and for struct ht. The cuckoo table stays flat,
+ * since a lookup never looks past two buckets.
+ */
+int bench_ckt_latency(void)
+{
+	int i;
+	int j;
+	int k;
+	int fill;
+	long *ns;
+	struct ckt *c;
+	struct ht *h;
+	struct timespec t0;
+	struct timespec t1;
+
+	ns = malloc(BENCH_LOOKUPS * sizeof(long));
+	assert(ns);
+
+	c = ckt_create(BENCH_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	h = ht_create(BENCH_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	ht_set_max_load(h, 0);
+
+	i = 0;
+	for (fill = 50; fill <= 90; fill += 20) {
+		for (; i < (long) BENCH_SLOTS * fill / 100; i++) {
+			ckt_insert(c, &i, &i);
+			ht_insert(h, &i, &i);
+		}
+
+		for (j = 0; j < BENCH_LOOKUPS; j++) {
+			k = ((unsigned) j * 2654435761U) % i;
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			ckt_search(c, &k);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			ns[j] = (t1.tv_sec - t0.tv_sec) * 1000000000L +
+			        (t1.tv_nsec - t0.tv_nsec);
+		}
+		qsort(ns, BENCH_LOOKUPS, sizeof(long), cmp_long);
+		printf("ckt: %d%% full: p50 %ld ns, p99.9 %ld ns\n", fill,
+		       ns[BENCH_LOOKUPS / 2], ns[BENCH_LOOKUPS * 999 / 1000]);
+
+		for (j = 0; j < BENCH_LOOKUPS; j++) {
+			k = ((unsigned) j * 2654435761U) % i;
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			ht_search(h, &k);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			ns[j] = (t1.tv_sec - t0.tv_sec) * 1000000000L +
+			        (t1.tv_nsec - t0.tv_nsec);
+		}
+		qsort(ns, BENCH_LOOKUPS, sizeof(long), cmp_long);
+		printf("ht:  %d%% full: p50 %ld ns, p99.9 %ld ns\n", fill,
+		       ns[BENCH_LOOKUPS / 2], ns[BENCH_LOOKUPS * 999 / 1000]);
+	}
+
+	ckt_destroy(c);
+	ht_destroy(h);
+	free(ns);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_ckt_create();
+	test_ckt_kint_vint();
+	test_ckt_load();
+	test_ckt_kstr_vstr();
+	bench_ckt_latency();
+
+	return 0;
+}
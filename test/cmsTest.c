@@ -0,0 +1,204 @@
+/*
+ * test/cmsTest.c: Test count-min sketch implementation
+ *
+ * St: 2026-10-17 Sat 07:40 AM
+ * Up: 2026-10-17 Sat 07:40 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<math.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define EPS 0.001
+#define DELTA 0.01
+#define KEY_COUNT 20000
+
+/* Test cms_create function */
+int test_cms_create(void)
+{
+	struct cms *c;
+
+	c = cms_create(EPS, DELTA, get_int_size);
+
+	/* e / eps rounded up to a power of 2, ln(1 / delta) rows */
+	assert(c->width == 4096);
+	assert(c->depth == 5);
+	assert(c->total == 0);
+
+	cms_destroy(c);
+
+	return 1;
+}
+
+/*
+ * Add a skewed stream: key i occurs KEY_COUNT / (i + 1) times, and
+ * keys from `first' on, `n' keys in all. Fill `truth' with the
+ * true counts. Return total count added.
+ */
+long add_stream(struct cms *c, int first, int n, long *truth)
+{
+	int i;
+	uint32_t cnt;
+	long retval;
+
+	retval = 0;
+	for (i = first; i < first + n; i++) {
+		cnt = KEY_COUNT / (i + 1);
+		/* Half the count one at a time, half at once */
+		cms_add(c, &i, cnt - cnt / 2);
+		cms_add(c, &i, cnt / 2);
+		truth[i] += cnt;
+		retval += cnt;
+	}
+
+	return retval;
+}
+
+/*
+ * Check estimates of all keys against the true counts: never below,
+ * and above by more than eps * total for at most a delta fraction.
+ */
+int check_bounds(struct cms *c, long *truth)
+{
+	int i;
+	int over;
+	uint32_t est;
+
+	over = 0;
+	for (i = 0; i < KEY_COUNT; i++) {
+		est = cms_estimate(c, &i);
+		assert(est >= truth[i]);
+		if (est > truth[i] + EPS * c->total)
+			over++;
+	}
+	assert(over <= DELTA * KEY_COUNT);
+
+	return 1;
+}
+
+/*
+ * Test counts of int keys.
+ *
+ * Following tests are performed:
+ *
+ * 1. Estimates are never below, and rarely far above, true counts
+ * 2. Conservative update keeps heavy keys exact here
+ * 3. A key never added is estimated low
+ */
+int test_cms_kint(void)
+{
+	int i;
+	long *truth;
+	struct cms *c;
+
+	truth = calloc(KEY_COUNT, sizeof(long));
+	assert(truth);
+
+	c = cms_create(EPS, DELTA, get_int_size);
+	assert(add_stream(c, 0, KEY_COUNT, truth) == c->total);
+	check_bounds(c, truth);
+
+	for (i = 0; i < 10; i++)
+		assert(cms_estimate(c, &i) == truth[i]);
+	i = -1;
+	assert(cms_estimate(c, &i) <= EPS * c->total);
+
+	cms_destroy(c);
+	free(truth);
+
+	return 1;
+}
+
+/* Test counts of str keys */
+int test_cms_kstr(void)
+{
+	struct cms *c;
+
+	c = cms_create(EPS, DELTA, get_str_size);
+
+	cms_add(c, "name", 3);
+	cms_add(c, "game", 1);
+	cms_add(c, "name", 2);
+	assert(cms_estimate(c, "name") == 5);
+	assert(cms_estimate(c, "game") == 1);
+	assert(cms_estimate(c, "tameee") == 0);
+	assert(c->total == 6);
+
+	cms_destroy(c);
+
+	return 1;
+}
+
+/*
+ * Test merge: two sketches of different parts of a stream (as two
+ * threads would fill) merge to one that keeps the bounds for the
+ * whole stream.
+ */
+int test_cms_merge(void)
+{
+	long total;
+	long *truth;
+	struct cms *a;
+	struct cms *b;
+
+	truth = calloc(KEY_COUNT, sizeof(long));
+	assert(truth);
+
+	a = cms_create(EPS, DELTA, get_int_size);
+	b = cms_create(EPS, DELTA, get_int_size);
+
+	total = add_stream(a, 0, KEY_COUNT / 2, truth);
+	total += add_stream(b, KEY_COUNT / 4, KEY_COUNT * 3 / 4, truth);
+
+	cms_merge(a, b);
+	assert(a->total == total);
+	check_bounds(a, truth);
+
+	cms_destroy(a);
+	cms_destroy(b);
+	free(truth);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_cms_create();
+	test_cms_kint();
+	test_cms_kstr();
+	test_cms_merge();
+
+	return 0;
+}
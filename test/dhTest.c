@@ -0,0 +1,238 @@
+/*
+ * test/dhTest.c: Test d-ary heap implementation
+ *
+ * St: 2026-10-17 Sat 07:49 AM
+ * Up: 2026-10-17 Sat 07:49 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<assert.h>
+#include<time.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define KEY_COUNT 10000
+#define BENCH_KEYS (1 << 20)
+
+/*
+ * Return next number of a 64 bit xorshift random sequence.
+ *
+ * @state: Pointer to the sequence state, not 0
+ */
+uint64_t xorshift64(uint64_t *state)
+{
+	uint64_t x;
+
+	x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+
+	return x;
+}
+
+/*
+ * Test insert and extract of a d-ary heap against a known key set.
+ *
+ * @arity: Children per node
+ * @type:  MIN_HEAP or MAX_HEAP
+ */
+int test_dh_order(int arity, char type)
+{
+	struct dheap *h;
+	int64_t *keys;
+	int64_t key;
+	int64_t prev;
+	int64_t last;
+	void *val;
+	uint64_t seed;
+	int i;
+
+	keys = malloc(KEY_COUNT * sizeof(int64_t));
+	assert(keys);
+
+	seed = 88172645463325252ULL;
+	for (i = 0; i < KEY_COUNT; i++)
+		keys[i] = (int64_t) xorshift64(&seed);
+
+	/* Extremes and repeats */
+	keys[0] = INT64_MIN;
+	keys[1] = INT64_MAX;
+	keys[2] = 0;
+	keys[3] = keys[4];
+
+	/* Start tiny so the heap grows many times */
+	h = dh_create(1, arity, type);
+	assert(dh_is_empty(h) == 1);
+	assert(dh_find_m(h, &key, &val) == 0);
+	assert(dh_extract_m(h, &key, &val) == 0);
+
+	/* Groups of children start on an arity * 8 byte boundary */
+	assert((uintptr_t) &h->keys[1] % (arity * sizeof(int64_t)) == 0);
+
+	for (i = 0; i < KEY_COUNT; i++)
+		dh_insert(h, keys[i], &keys[i]);
+	assert(dh_get_size(h) == KEY_COUNT);
+	assert((uintptr_t) &h->keys[1] % (arity * sizeof(int64_t)) == 0);
+
+	/* Everything comes out in order, with its own value */
+	for (i = 0; i < KEY_COUNT; i++) {
+		assert(dh_find_m(h, &key, NULL) == 1);
+		assert(dh_extract_m(h, &prev, &val) == 1);
+		assert(prev == key);
+		assert(*(int64_t *) val == key);
+		if (i > 0)
+			assert(type == MIN_HEAP ? prev >= last :
+			       prev <= last);
+		last = prev;
+	}
+	assert(i == KEY_COUNT);
+	assert(dh_is_empty(h) == 1);
+
+	dh_destroy(h);
+	free(keys);
+
+	return 1;
+}
+
+/*
+ * Test interleaved inserts and extracts, as in a priority queue.
+ *
+ * @arity: Children per node
+ */
+int test_dh_mixed(int arity)
+{
+	struct dheap *h;
+	int64_t key;
+	int64_t prev;
+	uint64_t seed;
+	size_t n;
+	int i;
+
+	h = dh_create(16, arity, MIN_HEAP);
+	seed = 2463534242ULL;
+	prev = INT64_MIN;
+	n = 0;
+
+	/* Keys never below the last one extracted, as in Dijkstra */
+	for (i = 0; i < KEY_COUNT; i++) {
+		dh_insert(h, prev + (int64_t) (xorshift64(&seed) % 1000),
+		          NULL);
+		n++;
+		if (xorshift64(&seed) % 3 != 0) {
+			assert(dh_extract_m(h, &key, NULL) == 1);
+			assert(key >= prev);
+			prev = key;
+			n--;
+		}
+		assert(dh_get_size(h) == n);
+	}
+
+	while (dh_extract_m(h, &key, NULL) == 1) {
+		assert(key >= prev);
+		prev = key;
+	}
+
+	dh_destroy(h);
+
+	return 1;
+}
+
+/* Compare extract_m of struct heap and struct dheap on random keys */
+int bench_dh(void)
+{
+	struct heap *hp;
+	struct hp_data *d;
+	struct dheap *h;
+	struct timespec t0;
+	struct timespec t1;
+	double secs;
+	uint64_t seed;
+	int64_t key;
+	int arity;
+	int i;
+	int j;
+
+	seed = 88172645463325252ULL;
+	hp = hp_create(BENCH_KEYS, MIN_HEAP,
+	               cpy_i, cpy_i, cmp_i, cmp_i, dval_i, dval_i);
+	for (i = 0; i < BENCH_KEYS; i++) {
+		j = (int) (xorshift64(&seed) >> 33);
+		hp_insert(hp, &j, NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < BENCH_KEYS; i++) {
+		d = hp_extract_m(hp);
+		dval_i(d->key);
+		free(d);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("dh: hp_extract_m:       %.2f M ops/s\n",
+	       BENCH_KEYS / secs / 1e6);
+	hp_destroy(hp);
+
+	for (arity = 4; arity <= 8; arity *= 2) {
+		seed = 88172645463325252ULL;
+		h = dh_create(BENCH_KEYS, arity, MIN_HEAP);
+		for (i = 0; i < BENCH_KEYS; i++)
+			dh_insert(h, (int64_t) (xorshift64(&seed) >> 33),
+			          NULL);
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (i = 0; i < BENCH_KEYS; i++)
+			dh_extract_m(h, &key, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		secs = (t1.tv_sec - t0.tv_sec) +
+		       (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		printf("dh: dh_extract_m(d=%d):  %.2f M ops/s\n", arity,
+		       BENCH_KEYS / secs / 1e6);
+		dh_destroy(h);
+	}
+
+	return 1;
+}
+
+int main(void)
+{
+	test_dh_order(4, MIN_HEAP);
+	test_dh_order(8, MIN_HEAP);
+	test_dh_order(4, MAX_HEAP);
+	test_dh_order(8, MAX_HEAP);
+	test_dh_mixed(4);
+	test_dh_mixed(8);
+
+	bench_dh();
+
+	return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * test/dhtTest.c: Test hash table dump file implementation
+ *
+ * St: 2026-10-17 Sat 07:21 AM
+ * Up: 2026-10-17 Sat 08:08 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stddef.h>
+#include<stdint.h>
+#include<assert.h>
+#include<unistd.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define TOT_SLOTS 5
+#define INSERT_COUNT 1000
+#define DUMP_PATH "dhtTest.dump"
+
+/* Test dumping and mapping a table with int key and int val */
+int test_dht_kint_vint(void)
+{
+	int i;
+	int v;
+	const int *vptr;
+	struct ht *h;
+	struct dht *d;
+	struct dht *d2;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = i * 3;
+		ht_insert(h, &i, &v);
+	}
+
+	/* A duplicate key: the newer val is the one dumped */
+	i = 7;
+	v = 700;
+	ht_insert(h, &i, &v);
+
+	/* A deleted key */
+	i = 8;
+	ht_delete(h, &i);
+
+	assert(ht_dump(h, DUMP_PATH, get_int_size) == 0);
+	ht_destroy(h);
+
+	d = dht_open(DUMP_PATH, get_int_size);
+	assert(d != NULL);
+	assert(dht_tot_memb(d) == INSERT_COUNT - 1);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		vptr = dht_get(d, &i);
+		if (i == 8)
+			assert(vptr == NULL);
+		else if (i == 7)
+			assert(*vptr == 700);
+		else
+			assert(*vptr == i * 3);
+	}
+	for (i = INSERT_COUNT; i < 2 * INSERT_COUNT; i++)
+		assert(dht_search(d, &i) == 0);
+
+	/* A second mapping of the same file sees the same */
+	d2 = dht_open(DUMP_PATH, get_int_size);
+	assert(d2 != NULL);
+	i = 7;
+	assert(*(const int *) dht_get(d2, &i) == 700);
+	dht_close(d2);
+
+	dht_close(d);
+	remove(DUMP_PATH);
+
+	return 1;
+}
+
+/* Test dumping and mapping a table with str key and str val */
+int test_dht_kstr_vstr(void)
+{
+	struct ht *h;
+	struct dht *d;
+
+	h = ht_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+
+	ht_insert(h, "name", "lahm");
+	ht_insert(h, "game", "football");
+	ht_insert(h, "ab", "thomas");
+	ht_insert(h, "ba", "");
+	ht_upsert(h, "name", "phillip");
+
+	assert(ht_dump(h, DUMP_PATH, get_str_size) == 0);
+	ht_destroy(h);
+
+	d = dht_open(DUMP_PATH, get_str_size);
+	assert(d != NULL);
+	assert(dht_tot_memb(d) == 4);
+
+	/* Vals are followed by a 0 byte, so strings can be used as is */
+	assert(strcmp(dht_get(d, "name"), "phillip") == 0);
+	assert(strcmp(dht_get(d, "game"), "football") == 0);
+	assert(strcmp(dht_get(d, "ba"), "") == 0);
+	assert(dht_get(d, "nam") == NULL);
+	assert(dht_get(d, "names") == NULL);
+
+	dht_close(d);
+	remove(DUMP_PATH);
+
+	/* Empty table */
+	h = ht_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+	assert(ht_dump(h, DUMP_PATH, get_str_size) == 0);
+	ht_destroy(h);
+	d = dht_open(DUMP_PATH, get_str_size);
+	assert(d != NULL);
+	assert(dht_tot_memb(d) == 0);
+	assert(dht_search(d, "name") == 0);
+	dht_close(d);
+	remove(DUMP_PATH);
+
+	return 1;
+}
+
+/* Test that bad files are not mapped */
+int test_dht_bad_file(void)
+{
+	FILE *fp;
+
+	assert(dht_open("no/such/file", get_int_size) == NULL);
+
+	fp = fopen(DUMP_PATH, "wb");
+	assert(fp != NULL);
+	fputs("not a hash table dump file, but long enough for a header", fp);
+	fclose(fp);
+	assert(dht_open(DUMP_PATH, get_int_size) == NULL);
+	remove(DUMP_PATH);
+
+	return 1;
+}
+
+/*
+ * Write a dump of INSERT_COUNT int keys, and read its header.
+ *
+ * @hdr: Gets the header of the file
+ */
+void dht_write_ints(struct dht_header *hdr)
+{
+	int i;
+	struct ht *h;
+	FILE *fp;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	for (i = 0; i < INSERT_COUNT; i++)
+		ht_insert(h, &i, &i);
+	assert(ht_dump(h, DUMP_PATH, get_int_size) == 0);
+	ht_destroy(h);
+
+	fp = fopen(DUMP_PATH, "rb");
+	assert(fp != NULL);
+	assert(fread(hdr, sizeof(*hdr), 1, fp) == 1);
+	fclose(fp);
+}
+
+/*
+ * Overwrite a uint64_t of the dump file.
+ *
+ * @off: File offset
+ * @val: New value
+ */
+void dht_poke(uint64_t off, uint64_t val)
+{
+	FILE *fp;
+
+	fp = fopen(DUMP_PATH, "r+b");
+	assert(fp != NULL);
+	assert(fseek(fp, off, SEEK_SET) == 0);
+	assert(fwrite(&val, sizeof(val), 1, fp) == 1);
+	fclose(fp);
+}
+
+/*
+ * Test damaged dump files: bad headers are not mapped, and bad
+ * slot indexes or entries make lookups miss, never read outside
+ * the file (run under ASan to see).
+ */
+int test_dht_corrupt_file(void)
+{
+	int i;
+	uint64_t s;
+	uint64_t e;
+	struct dht *d;
+	struct dht_header hdr;
+
+	/* Truncated */
+	dht_write_ints(&hdr);
+	assert(truncate(DUMP_PATH, hdr.file_size / 2) == 0);
+	assert(dht_open(DUMP_PATH, get_int_size) == NULL);
+
+	/* Sizes whose products overflow */
+	dht_write_ints(&hdr);
+	dht_poke(offsetof(struct dht_header, nmemb),
+	         UINT64_MAX / sizeof(struct dht_entry) + 1);
+	assert(dht_open(DUMP_PATH, get_int_size) == NULL);
+	dht_write_ints(&hdr);
+	dht_poke(offsetof(struct dht_header, tot_slots), 1ULL << 61);
+	assert(dht_open(DUMP_PATH, get_int_size) == NULL);
+
+	/* Offsets out of order, or past the end */
+	dht_write_ints(&hdr);
+	dht_poke(offsetof(struct dht_header, slots_off), hdr.entries_off + 8);
+	assert(dht_open(DUMP_PATH, get_int_size) == NULL);
+	dht_write_ints(&hdr);
+	dht_poke(offsetof(struct dht_header, entries_off),
+	         hdr.file_size + 8);
+	assert(dht_open(DUMP_PATH, get_int_size) == NULL);
+
+	/* slot_start not monotone, or past nmemb */
+	dht_write_ints(&hdr);
+	for (s = 1; s <= hdr.tot_slots; s++)
+		dht_poke(hdr.slots_off + s * sizeof(uint64_t),
+		         (s % 2) ? UINT64_MAX : 0);
+	d = dht_open(DUMP_PATH, get_int_size);
+	assert(d != NULL);
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(dht_get(d, &i) == NULL);
+	dht_close(d);
+
+	/* Entries pointing past the end of the file */
+	dht_write_ints(&hdr);
+	for (e = 0; e < hdr.nmemb; e++) {
+		s = (e % 2) ? offsetof(struct dht_entry, key_off) :
+		              offsetof(struct dht_entry, val_off);
+		dht_poke(hdr.entries_off + e * sizeof(struct dht_entry) + s,
+		         hdr.file_size - 1 + e);
+	}
+	d = dht_open(DUMP_PATH, get_int_size);
+	assert(d != NULL);
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(dht_get(d, &i) == NULL);
+	dht_close(d);
+
+	remove(DUMP_PATH);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_dht_kint_vint();
+	test_dht_kstr_vstr();
+	test_dht_bad_file();
+	test_dht_corrupt_file();
+
+	return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * test/fhtTest.c: Test frozen (perfect hash) table implementation
+ *
+ * St: 2026-10-17 Sat 07:20 AM
+ * Up: 2026-10-17 Sat 07:20 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define TOT_SLOTS 5
+#define INSERT_COUNT 1000
+#define BIG_COUNT 100000
+#define MAX_BITS_PER_KEY 4.5
+
+/*
+ * Check that entries hold every member exactly once: every entry
+ * has a key, and looking that key up gives that entry back.
+ *
+ * @f: Pointer to the frozen hash table structure
+ */
+int fht_is_sane(struct fht *f)
+{
+	size_t i;
+
+	for (i = 0; i < f->nmemb; i++) {
+		assert(f->entries[i].key != NULL);
+		assert(fht_get(f, f->entries[i].key) == f->entries[i].val);
+	}
+
+	return 1;
+}
+
+/* Test freezing a table with int key and int val */
+int test_fht_kint_vint(void)
+{
+	int i;
+	int v;
+	double bits;
+	struct ht *h;
+	struct fht *f;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = i * 3;
+		ht_insert(h, &i, &v);
+	}
+
+	/* A duplicate key: the newer val is the one seen */
+	i = 7;
+	v = 700;
+	ht_insert(h, &i, &v);
+
+	/* A deleted key */
+	i = 8;
+	ht_delete(h, &i);
+
+	f = ht_freeze(h);
+	assert(f != NULL);
+	ht_destroy(h);
+
+	assert(fht_tot_memb(f) == INSERT_COUNT - 1);
+	assert(fht_is_sane(f) == 1);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		if (i == 8)
+			assert(fht_search(f, &i) == 0);
+		else if (i == 7)
+			assert(*(int *) fht_get(f, &i) == 700);
+		else
+			assert(*(int *) fht_get(f, &i) == i * 3);
+	}
+	for (i = INSERT_COUNT; i < 10 * INSERT_COUNT; i++)
+		assert(fht_get(f, &i) == NULL);
+
+	/* Metadata: 16 bit pilots and 32 bit remap entries */
+	bits = (16.0 * f->nbuckets + 32.0 * (f->tot_pos - f->nmemb)) /
+	       f->nmemb;
+	assert(bits < MAX_BITS_PER_KEY);
+
+	fht_destroy(f);
+
+	return 1;
+}
+
+/* Test freezing a table with str key and str val */
+int test_fht_kstr_vstr(void)
+{
+	struct ht *h;
+	struct fht *f;
+
+	h = ht_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+
+	ht_insert(h, "name", "lahm");
+	ht_insert(h, "game", "football");
+	ht_insert(h, "place", "munich");
+	ht_insert(h, "ab", "thomas");
+	ht_insert(h, "ba", "thomas");
+	ht_upsert(h, "name", "phillip");
+
+	f = ht_freeze(h);
+	assert(f != NULL);
+
+	assert(fht_tot_memb(f) == 5);
+	assert(strcmp(fht_get(f, "name"), "phillip") == 0);
+	assert(strcmp(fht_get(f, "ba"), "thomas") == 0);
+	assert(fht_search(f, "tameee") == 0);
+	assert(fht_is_sane(f) == 1);
+
+	fht_destroy(f);
+	ht_destroy(h);
+
+	/* Empty table */
+	h = ht_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+	f = ht_freeze(h);
+	assert(f != NULL);
+	assert(fht_tot_memb(f) == 0);
+	assert(fht_search(f, "name") == 0);
+	fht_destroy(f);
+	ht_destroy(h);
+
+	return 1;
+}
+
+/* Test freezing a big table, in the middle of growing */
+int test_fht_big(void)
+{
+	int i;
+	struct ht *h;
+	struct fht *f;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	for (i = 0; i < BIG_COUNT; i++)
+		ht_insert(h, &i, &i);
+	while (!ht_is_rehashing(h)) {
+		ht_insert(h, &i, &i);
+		i++;
+	}
+
+	f = ht_freeze(h);
+	assert(f != NULL);
+	assert(fht_tot_memb(f) == ht_tot_memb(h));
+	assert(fht_is_sane(f) == 1);
+
+	fht_destroy(f);
+	ht_destroy(h);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_fht_kint_vint();
+	test_fht_kstr_vstr();
+	test_fht_big();
+
+	return 0;
+}
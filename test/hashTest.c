@@ -0,0 +1,163 @@
+/*
+ * test/hashTest.c: Test hash functions
+ *
+ * St: 2026-10-17 Sat 07:05 AM
+ * Up: 2026-10-17 Sat 07:05 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define MAX_LEN 100
+
+/*
+ * Count bits set in a 64 bit value.
+ *
+ * @v: Value
+ */
+int popcount64(uint64_t v)
+{
+	int n;
+
+	for (n = 0; v != 0; v &= v - 1)
+		n++;
+
+	return n;
+}
+
+/* Test that the int fast paths agree with hash_key */
+int test_hash_fast_path(void)
+{
+	uint32_t k4;
+	uint64_t k8;
+
+	k4 = 123456789;
+	assert(hash_key(&k4, 4, HASH_SEED) == hash_u32(k4, HASH_SEED));
+
+	k8 = 1234567890123ULL;
+	assert(hash_key(&k8, 8, HASH_SEED) == hash_u64(k8, HASH_SEED));
+
+	/* Neighbouring ints do not hash to neighbouring values */
+	assert(hash_u32(1, HASH_SEED) + 1 != hash_u32(2, HASH_SEED));
+
+	return 1;
+}
+
+/*
+ * Test hash_bytes.
+ *
+ * Following tests are performed:
+ *
+ * 1. Same input and seed give same hash
+ * 2. Byte order matters
+ * 3. Every length up to MAX_LEN gives a distinct hash
+ * 4. Seed changes the hash
+ */
+int test_hash_bytes(void)
+{
+	int i;
+	int j;
+	char buf[MAX_LEN];
+	uint64_t hashes[MAX_LEN];
+
+	assert(hash_bytes("name", 4, 1) == hash_bytes("name", 4, 1));
+	assert(hash_bytes("ab", 2, 1) != hash_bytes("ba", 2, 1));
+	assert(hash_bytes("name", 4, 1) != hash_bytes("name", 4, 2));
+
+	memset(buf, 'x', MAX_LEN);
+	for (i = 0; i < MAX_LEN; i++)
+		hashes[i] = hash_bytes(buf, i, HASH_SEED);
+	for (i = 0; i < MAX_LEN; i++)
+		for (j = i + 1; j < MAX_LEN; j++)
+			assert(hashes[i] != hashes[j]);
+
+	return 1;
+}
+
+/*
+ * Test avalanche: flipping one input bit should flip about half
+ * of the output bits, on average.
+ */
+int test_hash_avalanche(void)
+{
+	int i;
+	int bit;
+	long flips;
+	long tests;
+	uint64_t key;
+	char str[40];
+	uint64_t h1;
+
+	flips = 0;
+	tests = 0;
+
+	/* Int fast path */
+	for (i = 0; i < 200; i++) {
+		key = hash_u64(i, 0);
+		h1 = hash_u64(key, HASH_SEED);
+		for (bit = 0; bit < 64; bit++) {
+			flips += popcount64(h1 ^ hash_u64(key ^ (1ULL << bit),
+			                                  HASH_SEED));
+			tests++;
+		}
+	}
+	assert(flips > tests * 30 && flips < tests * 34);
+
+	/* Byte path, a 33 byte string */
+	flips = 0;
+	tests = 0;
+	for (i = 0; i < 200; i++) {
+		sprintf(str, "%032d", i);
+		h1 = hash_bytes(str, 33, HASH_SEED);
+		for (bit = 0; bit < 33 * 8; bit++) {
+			str[bit / 8] ^= 1 << (bit % 8);
+			flips += popcount64(h1 ^ hash_bytes(str, 33, HASH_SEED));
+			str[bit / 8] ^= 1 << (bit % 8);
+			tests++;
+		}
+	}
+	assert(flips > tests * 30 && flips < tests * 34);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_hash_fast_path();
+	test_hash_bytes();
+	test_hash_avalanche();
+
+	return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * test/hllTest.c: Test HyperLogLog implementation
+ *
+ * St: 2026-10-17 Sat 07:40 AM
+ * Up: 2026-10-17 Sat 07:40 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<math.h>
+#include<pthread.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define PRECISION 12
+#define MAX_THREADS 4
+#define KEYS_PER_THREAD 250000
+
+/* Work for one test thread */
+struct thread_arg {
+	struct hll *h;
+	int first;          /* first key of the thread */
+	int count;          /* number of keys */
+};
+
+/*
+ * Assert an estimate is within 4 standard errors of the true count.
+ *
+ * @h: Pointer to the hll structure
+ * @n: True count
+ */
+void assert_close(struct hll *h, double n)
+{
+	assert(fabs(hll_count(h) - n) <= 4 * hll_error(h) * n + 1);
+}
+
+/* Test hll_create function */
+int test_hll_create(void)
+{
+	struct hll *h;
+
+	h = hll_create(PRECISION, get_int_size);
+
+	assert(h->m == 1 << PRECISION);
+	assert(h->dense == NULL);
+	assert(h->nsparse == 0);
+	assert(hll_count(h) == 0);
+	assert(fabs(hll_error(h) - 1.04 / 64) < 1e-9);
+
+	hll_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test counting int keys.
+ *
+ * Following tests are performed:
+ *
+ * 1. Small sets stay sparse and are counted almost exactly
+ * 2. Adding a key again does not change the count
+ * 3. The sketch turns dense at m / 4 registers
+ * 4. Counts up to a million are within 4 standard errors
+ */
+int test_hll_kint(void)
+{
+	int i;
+	double c;
+	struct hll *h;
+
+	h = hll_create(PRECISION, get_int_size);
+
+	for (i = 0; i < 100; i++)
+		hll_add(h, &i);
+	assert(h->dense == NULL);
+	assert(fabs(hll_count(h) - 100) < 3);
+
+	c = hll_count(h);
+	for (i = 0; i < 100; i++)
+		hll_add(h, &i);
+	assert(hll_count(h) == c);
+
+	for (; i < 2000; i++) {
+		hll_add(h, &i);
+		if (h->dense == NULL)
+			assert(h->nsparse <= h->m / 4);
+	}
+	assert(h->dense != NULL);
+	assert_close(h, 2000);
+
+	for (; i < 1000000; i++) {
+		hll_add(h, &i);
+		if (i == 9999 || i == 99999)
+			assert_close(h, i + 1);
+	}
+	assert_close(h, 1000000);
+
+	hll_destroy(h);
+
+	return 1;
+}
+
+/* Test counting str keys */
+int test_hll_kstr(void)
+{
+	int i;
+	char key[32];
+	struct hll *h;
+
+	h = hll_create(PRECISION, get_str_size);
+
+	for (i = 0; i < 50000; i++) {
+		sprintf(key, "user-%d", i % 20000);
+		hll_add(h, key);
+	}
+	assert_close(h, 20000);
+
+	hll_destroy(h);
+
+	return 1;
+}
+
+/* Test merging sparse and dense sketches both ways */
+int test_hll_merge(void)
+{
+	int i;
+	struct hll *a;
+	struct hll *b;
+	struct hll *c;
+
+	a = hll_create(PRECISION, get_int_size);
+	b = hll_create(PRECISION, get_int_size);
+	c = hll_create(PRECISION, get_int_size);
+
+	/* a dense, b sparse, overlapping */
+	for (i = 0; i < 50000; i++)
+		hll_add(a, &i);
+	for (i = 49900; i < 50200; i++)
+		hll_add(b, &i);
+	assert(a->dense != NULL && b->dense == NULL);
+
+	/* Sparse into sparse stays sparse */
+	hll_merge(c, b);
+	assert(c->dense == NULL && c->nsparse == b->nsparse);
+	assert(hll_count(c) == hll_count(b));
+
+	/* Dense into sparse */
+	hll_merge(c, a);
+	assert(c->dense != NULL);
+	assert_close(c, 50200);
+
+	/* Sparse into dense */
+	hll_merge(a, b);
+	assert(hll_count(a) == hll_count(c));
+
+	hll_destroy(a);
+	hll_destroy(b);
+	hll_destroy(c);
+
+	return 1;
+}
+
+/* Thread body: add keys to the thread's own sketch */
+void *adder(void *arg)
+{
+	int i;
+	struct thread_arg *ta;
+
+	ta = arg;
+	for (i = ta->first; i < ta->first + ta->count; i++)
+		hll_add(ta->h, &i);
+
+	return NULL;
+}
+
+/*
+ * Test counting with a sketch per thread, merged at the end. The
+ * key ranges of the threads overlap by half.
+ */
+int test_hll_threads(void)
+{
+	int i;
+	struct hll *h;
+	pthread_t tid[MAX_THREADS];
+	struct thread_arg ta[MAX_THREADS];
+
+	for (i = 0; i < MAX_THREADS; i++) {
+		ta[i].h = hll_create(PRECISION, get_int_size);
+		ta[i].first = i * KEYS_PER_THREAD / 2;
+		ta[i].count = KEYS_PER_THREAD;
+		pthread_create(&tid[i], NULL, adder, &ta[i]);
+	}
+
+	h = hll_create(PRECISION, get_int_size);
+	for (i = 0; i < MAX_THREADS; i++) {
+		pthread_join(tid[i], NULL);
+		hll_merge(h, ta[i].h);
+		hll_destroy(ta[i].h);
+	}
+	assert_close(h, (MAX_THREADS + 1) * KEYS_PER_THREAD / 2);
+
+	hll_destroy(h);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_hll_create();
+	test_hll_kint();
+	test_hll_kstr();
+	test_hll_merge();
+	test_hll_threads();
+
+	return 0;
+}
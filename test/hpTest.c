@@ -2,7 +2,7 @@
  * test/hpTest.c: Test heap.c implementation
  *
  * St: 2016-09-26 Mon 09:21 PM
- * Up: 2016-10-04 Tue 08:55 PM
+ * Up: 2026-10-17 Sat 08:39 AM
  *
  * Author: SPS
  *
@@ -42,6 +42,7 @@
 #define TEST_ERR 1
 #define INIT_HEAP_CAP 5
 #define INIT_INSERT_COUNT 10
+#define BUILD_COUNT 1000
 
 /*
  * Check if there is a TEST ERROR
@@ -319,11 +320,510 @@ int test_heap_str(void)
 }
 
 
+/*
+ * Check heap property and that the position map agrees with the array.
+ *
+ * @h: Pointer to the heap structure
+ */
+int hp_handles_ok(struct heap *h)
+{
+	size_t i;
+	int cmp;
+
+	for (i = 0; i < h->nmemb; i++) {
+		if (h->hpos[Hp_hslot(h->hparr[i]->handle)] != (int) i)
+			return 0;
+		if (i == 0)
+			continue;
+		cmp = h->k_cmp(h->hparr[(i - 1) / 2]->key, h->hparr[i]->key);
+		if ((h->type == MIN_HEAP && cmp > 0) ||
+		    (h->type == MAX_HEAP && cmp < 0))
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Test handles: hp_get_pos, hp_contains, hp_update_key and hp_remove.
+ *
+ * @type: MIN_HEAP or MAX_HEAP
+ */
+int test_hp_handles(char type)
+{
+	struct heap *h;
+	struct hp_data *d;
+	int handles[INIT_INSERT_COUNT];
+	int i;
+	int j;
+	int prev;
+	int cmp;
+
+	h = hp_create(INIT_HEAP_CAP, type,
+	              cpy_i, cpy_i, cmp_i, cmp_i, dval_i, dval_i);
+
+	/* Handles are handed out in order and follow their element */
+	for (i = 0; i < INIT_INSERT_COUNT; i++) {
+		j = i * 10;
+		handles[i] = hp_insert(h, &j, &i);
+		assert(handles[i] == i);
+		assert(hp_contains(h, i) == 1);
+		assert(hp_handles_ok(h) == 1);
+	}
+	assert(hp_get_pos(h, -1) == -1);
+	assert(hp_get_pos(h, INIT_INSERT_COUNT) == -1);
+
+	/* Move one element to the front and one to the back */
+	j = (type == MIN_HEAP) ? -5 : 500;
+	hp_update_key(h, handles[7], &j);
+	assert(hp_handles_ok(h) == 1);
+	assert(hp_get_pos(h, handles[7]) == 0);
+	j = (type == MIN_HEAP) ? 1000 : -1000;
+	hp_update_key(h, handles[0], &j);
+	assert(hp_handles_ok(h) == 1);
+
+	/* Remove from the middle; removed handles are gone */
+	hp_remove(h, handles[3]);
+	hp_remove(h, handles[5]);
+	hp_remove(h, handles[5]);
+	assert(h->nmemb == INIT_INSERT_COUNT - 2);
+	assert(hp_contains(h, handles[3]) == 0);
+	assert(hp_contains(h, handles[5]) == 0);
+	assert(hp_handles_ok(h) == 1);
+
+	/* A freed slot is given out again, but old handles miss it */
+	j = 35;
+	i = hp_insert(h, &j, &j);
+	assert(Hp_hslot(i) == handles[5] || Hp_hslot(i) == handles[3]);
+	assert(i != handles[5] && i != handles[3]);
+	assert(hp_contains(h, i) == 1);
+	assert(hp_contains(h, handles[3]) == 0);
+	assert(hp_contains(h, handles[5]) == 0);
+	hp_remove(h, handles[3]);
+	hp_remove(h, handles[5]);
+	assert(h->nmemb == INIT_INSERT_COUNT - 1);
+	assert(hp_handles_ok(h) == 1);
+
+	/* A popped element's handle misses the element after it too */
+	d = hp_extract_m(h);
+	assert(hp_contains(h, d->handle) == 0);
+	j = *(int *) d->key;
+	prev = hp_insert(h, &j, &j);
+	assert(Hp_hslot(prev) == Hp_hslot(d->handle));
+	hp_remove(h, d->handle);
+	assert(hp_contains(h, prev) == 1);
+	assert(h->nmemb == INIT_INSERT_COUNT - 1);
+	assert(hp_handles_ok(h) == 1);
+	dval_i(d->key);
+	dval_i(d->val);
+	free(d);
+
+	/* Extraction comes out in order and without the removed keys */
+	prev = 0;
+	for (i = 0; hp_is_empty(h) == 0; i++) {
+		d = hp_extract_m(h);
+		assert(*(int *) d->key != 30 && *(int *) d->key != 50);
+		if (i > 0) {
+			cmp = cmp_i(&prev, d->key);
+			assert(type == MIN_HEAP ? cmp <= 0 : cmp >= 0);
+		}
+		prev = *(int *) d->key;
+		assert(hp_handles_ok(h) == 1);
+		dval_i(d->key);
+		dval_i(d->val);
+		free(d);
+	}
+	assert(i == INIT_INSERT_COUNT - 1);
+
+	hp_destroy(h);
+
+	return 1;
+}
+
+/* Copy an int, which must be there */
+void *cpy_nonnull_i(void *src)
+{
+	assert(src != NULL);
+
+	return cpy_i(src);
+}
+
+/*
+ * Test hp_build in both modes: heap property, handles, and that
+ * members from the slab can be removed, updated and destroyed.
+ *
+ * @type: MIN_HEAP or MAX_HEAP
+ * @mode: HP_COPY or HP_ADOPT
+ */
+int test_hp_build(char type, int mode)
+{
+	struct heap *h;
+	struct hp_data *d;
+	int *karr;
+	void **keys;
+	void **vals;
+	int i;
+	int j;
+	int prev;
+	int cmp;
+
+	karr = malloc(BUILD_COUNT * sizeof(int));
+	keys = malloc(BUILD_COUNT * sizeof(void *));
+	vals = malloc(BUILD_COUNT * sizeof(void *));
+	assert(karr && keys && vals);
+
+	for (i = 0; i < BUILD_COUNT; i++) {
+		karr[i] = (i * 37) % BUILD_COUNT;
+		if (mode == HP_ADOPT) {
+			keys[i] = cpy_i(&karr[i]);
+			vals[i] = cpy_i(&i);
+		} else {
+			keys[i] = &karr[i];
+			vals[i] = &karr[i];
+		}
+	}
+
+	h = hp_build(0, type, keys, vals, BUILD_COUNT, mode,
+	             cpy_i, cpy_i, cmp_i, cmp_i, dval_i, dval_i);
+	assert(hp_get_size(h) == BUILD_COUNT);
+	assert(hp_handles_ok(h) == 1);
+
+	/* Member i has handle i and its own key */
+	for (i = 0; i < BUILD_COUNT; i++) {
+		assert(hp_contains(h, i) == 1);
+		assert(*(int *) h->hparr[hp_get_pos(h, i)]->key == karr[i]);
+	}
+
+	/* Slab members and inserted ones live side by side */
+	hp_remove(h, 5);
+	j = (type == MIN_HEAP) ? -1 : BUILD_COUNT;
+	hp_update_key(h, 9, &j);
+	assert(hp_get_pos(h, 9) == 0);
+	j = BUILD_COUNT / 2;
+	hp_insert(h, &j, &j);
+	assert(hp_handles_ok(h) == 1);
+
+	/* Extract half in order, leave the rest for hp_destroy */
+	for (i = 0; i < BUILD_COUNT / 2; i++) {
+		d = hp_extract_m(h);
+		if (i > 0) {
+			cmp = cmp_i(&prev, d->key);
+			assert(type == MIN_HEAP ? cmp <= 0 : cmp >= 0);
+		}
+		prev = *(int *) d->key;
+		dval_i(d->key);
+		dval_i(d->val);
+		free(d);
+	}
+	assert(hp_handles_ok(h) == 1);
+
+	hp_destroy(h);
+
+	/* Empty build */
+	h = hp_build(4, type, keys, vals, 0, mode,
+	             cpy_i, cpy_i, cmp_i, cmp_i, dval_i, dval_i);
+	assert(hp_is_empty(h) == 1);
+	hp_destroy(h);
+
+	/* No vals: all NULL, and v_cpy is never given NULL */
+	if (mode == HP_ADOPT)
+		for (i = 0; i < BUILD_COUNT; i++)
+			keys[i] = cpy_i(&karr[i]);
+	h = hp_build(0, type, keys, NULL, BUILD_COUNT, mode,
+	             cpy_i, cpy_nonnull_i, cmp_i, cmp_i, dval_i, dval_i);
+	assert(hp_handles_ok(h) == 1);
+	for (i = 0; i < BUILD_COUNT; i++)
+		assert(h->hparr[i]->val == NULL);
+	hp_destroy(h);
+
+	free(karr);
+	free(keys);
+	free(vals);
+
+	return 1;
+}
+
+/*
+ * Test hp_build_block: keys and vals stay in the two blocks, are
+ * never freed one by one, and are copied when handed out.
+ *
+ * @type: MIN_HEAP or MAX_HEAP
+ */
+int test_hp_build_block(char type)
+{
+	struct heap *h;
+	struct hp_data *d;
+	int *kblock;
+	int *vblock;
+	void *k;
+	void *v;
+	int i;
+	int j;
+
+	kblock = malloc(BUILD_COUNT * sizeof(int));
+	vblock = malloc(BUILD_COUNT * sizeof(int));
+	assert(kblock && vblock);
+	for (i = 0; i < BUILD_COUNT; i++) {
+		kblock[i] = (i * 37) % BUILD_COUNT;
+		vblock[i] = i;
+	}
+
+	h = hp_build_block(0, type, kblock, sizeof(int), vblock, sizeof(int),
+	                   BUILD_COUNT, cpy_i, cpy_i, cmp_i, cmp_i,
+	                   dval_i, dval_i);
+	assert(hp_handles_ok(h) == 1);
+
+	/* Member i is key i and val i of the blocks */
+	for (i = 0; i < BUILD_COUNT; i++) {
+		d = h->hparr[hp_get_pos(h, i)];
+		assert(d->key == &kblock[i] && d->val == &vblock[i]);
+	}
+
+	/* Block keys are replaced and removed without k_dval */
+	j = (type == MIN_HEAP) ? -1 : BUILD_COUNT;
+	hp_update_key(h, 3, &j);
+	assert(hp_get_pos(h, 3) == 0);
+	hp_remove(h, 4);
+	hp_pop_into(h, NULL, NULL);
+	assert(hp_handles_ok(h) == 1);
+
+	/* Handed out keys and vals are copies */
+	assert(hp_pop_into(h, &k, &v) == 1);
+	assert(k < (void *) kblock || k >= (void *) (kblock + BUILD_COUNT));
+	assert(v < (void *) vblock || v >= (void *) (vblock + BUILD_COUNT));
+	dval_i(k);
+	dval_i(v);
+	d = hp_extract_m(h);
+	dval_i(d->key);
+	dval_i(d->val);
+	free(d);
+
+	/* Inserted members live beside block ones */
+	j = BUILD_COUNT / 2;
+	hp_insert(h, &j, &j);
+	assert(hp_handles_ok(h) == 1);
+
+	hp_destroy(h);
+
+	/* Keys only */
+	kblock = malloc(BUILD_COUNT * sizeof(int));
+	assert(kblock);
+	for (i = 0; i < BUILD_COUNT; i++)
+		kblock[i] = BUILD_COUNT - i;
+	h = hp_build_block(0, type, kblock, sizeof(int), NULL, 0,
+	                   BUILD_COUNT, cpy_i, cpy_i, cmp_i, cmp_i,
+	                   dval_i, dval_i);
+	assert(hp_handles_ok(h) == 1);
+	assert(h->hparr[0]->val == NULL);
+	hp_destroy(h);
+
+	return 1;
+}
+
+/* Keys and vals copied and not yet freed by a heap */
+int nalloc;
+
+/* Copy an int, counting it */
+void *cpy_count_i(void *src)
+{
+	nalloc++;
+
+	return cpy_i(src);
+}
+
+/* Free an int, counting it */
+void dval_count_i(void *ival)
+{
+	nalloc--;
+	dval_i(ival);
+}
+
+/*
+ * Test hp_peek_ref, hp_pop_into, hp_insert_owned and reuse of
+ * removed members, in a scheduler like peek, pop, reinsert loop.
+ */
+int test_hp_peek_pop(void)
+{
+	struct heap *h;
+	struct hp_data *hpd;
+	struct hp_data *d;
+	const void *pk;
+	const void *pv;
+	struct hp_data **arr;
+	int *pos;
+	void *k;
+	void *v;
+	int i;
+	int j;
+	int prev;
+	int ncpy;
+
+	h = hp_create(INIT_HEAP_CAP, MIN_HEAP, cpy_count_i, cpy_count_i,
+	              cmp_i, cmp_i, dval_count_i, dval_count_i);
+	assert(hp_peek_ref(h, &pk, &pv) == 0);
+	assert(hp_pop_into(h, &k, &v) == 0);
+
+	for (i = 0; i < BUILD_COUNT; i++) {
+		j = (i * 37) % BUILD_COUNT;
+		hp_insert(h, &j, &i);
+	}
+
+	/* Peek gives the root itself, not a copy */
+	assert(hp_peek_ref(h, &pk, &pv) == 1);
+	assert(pk == h->hparr[0]->key && pv == h->hparr[0]->val);
+	assert(*(const int *) pk == 0);
+
+	/* Pop moves key and val out, and keeps the member as spare */
+	hpd = h->hparr[0];
+	assert(hp_pop_into(h, &k, &v) == 1);
+	assert(k == pk && v == pv);
+	assert(h->spare == hpd);
+	assert(hp_get_size(h) == BUILD_COUNT - 1);
+
+	/* The next insert takes the spare member */
+	j = BUILD_COUNT;
+	hp_insert(h, &j, &j);
+	assert(h->spare == NULL);
+	assert(h->hparr[hp_get_pos(h, hpd->handle)] == hpd);
+	dval_count_i(k);
+	dval_count_i(v);
+
+	/*
+	 * Peek, pop, and reinsert further on, as a scheduler does: the
+	 * same key, val and member go round, and nothing is copied,
+	 * freed, or allocated (the arrays are not even grown).
+	 */
+	prev = 0;
+	arr = h->hparr;
+	pos = h->hpos;
+	ncpy = nalloc;
+	for (i = 0; i < BUILD_COUNT; i++) {
+		assert(hp_peek_ref(h, &pk, NULL) == 1);
+		j = *(const int *) pk;
+		assert(j >= prev);
+		prev = j;
+		hpd = h->hparr[0];
+		assert(hp_pop_into(h, &k, &v) == 1);
+		*(int *) k += BUILD_COUNT;
+		assert(hp_insert_owned(h, k, v) == hpd->handle);
+		assert(h->spare == NULL);
+		assert(h->hparr[hp_get_pos(h, hpd->handle)] == hpd);
+		assert(hpd->key == k && hpd->val == v);
+	}
+	assert(nalloc == ncpy);
+	assert(h->hparr == arr && h->hpos == pos);
+	assert(hp_handles_ok(h) == 1);
+
+	/* hp_find_m copies the val with v_cpy */
+	d = hp_find_m(h);
+	assert(cmp_i(d->key, h->hparr[0]->key) == 0);
+	assert(cmp_i(d->val, h->hparr[0]->val) == 0);
+	dval_count_i(d->key);
+	dval_count_i(d->val);
+	free(d);
+
+	/* Leave spare members for hp_destroy */
+	hp_pop_into(h, NULL, NULL);
+	hp_pop_into(h, NULL, NULL);
+	assert(h->spare != NULL);
+
+	hp_destroy(h);
+	assert(nalloc == 0);
+
+	return 1;
+}
+
+/*
+ * Test hp_sort_inplace and the drain cursor.
+ *
+ * @type: MIN_HEAP or MAX_HEAP
+ */
+int test_hp_sort_drain(char type)
+{
+	struct heap *h;
+	struct hp_drain it;
+	struct hp_data **sarr;
+	void *k;
+	void *v;
+	int i;
+	int j;
+	int prev;
+	int cmp;
+
+	h = hp_create(INIT_HEAP_CAP, type,
+	              cpy_i, cpy_i, cmp_i, cmp_i, dval_i, dval_i);
+	for (i = 0; i < BUILD_COUNT; i++) {
+		j = (i * 37) % (BUILD_COUNT / 2);
+		hp_insert(h, &j, &i);
+	}
+
+	/* get_sorted_arr leaves the heap alone */
+	sarr = get_sorted_arr(h);
+	assert(hp_get_size(h) == BUILD_COUNT);
+	assert(hp_handles_ok(h) == 1);
+
+	/* Sorted in place, in the same order, and still a heap */
+	hp_sort_inplace(h);
+	assert(hp_get_size(h) == BUILD_COUNT);
+	assert(hp_handles_ok(h) == 1);
+	for (i = 0; i < BUILD_COUNT; i++) {
+		assert(cmp_i(h->hparr[i]->key, sarr[i]->key) == 0);
+		if (i > 0) {
+			cmp = cmp_i(h->hparr[i - 1]->key, h->hparr[i]->key);
+			assert(type == MIN_HEAP ? cmp <= 0 : cmp >= 0);
+		}
+		dval_i(sarr[i]->key);
+		dval_i(sarr[i]->val);
+		free(sarr[i]);
+	}
+	free(sarr);
+
+	/* Drain half in order, then stop early */
+	hp_drain_begin(h, &it);
+	for (i = 0; i < BUILD_COUNT / 2; i++) {
+		assert(hp_drain_next(&it, &k, &v) == 1);
+		if (i > 0) {
+			cmp = cmp_i(&prev, k);
+			assert(type == MIN_HEAP ? cmp <= 0 : cmp >= 0);
+		}
+		prev = *(int *) k;
+	}
+	hp_drain_end(&it);
+	assert(hp_get_size(h) == BUILD_COUNT - BUILD_COUNT / 2);
+	assert(hp_handles_ok(h) == 1);
+
+	/* Drain the rest to the end */
+	hp_drain_begin(h, &it);
+	for (i = 0; hp_drain_next(&it, &k, NULL) == 1; i++) {
+		cmp = cmp_i(&prev, k);
+		assert(type == MIN_HEAP ? cmp <= 0 : cmp >= 0);
+		prev = *(int *) k;
+	}
+	assert(i == BUILD_COUNT - BUILD_COUNT / 2);
+	assert(hp_is_empty(h) == 1);
+
+	hp_destroy(h);
+
+	return 1;
+}
+
+
 /* main: start */
 int main(void)
 {
 	test_heap_int();
 	test_heap_str();
+	test_hp_handles(MIN_HEAP);
+	test_hp_handles(MAX_HEAP);
+	test_hp_build(MIN_HEAP, HP_COPY);
+	test_hp_build(MAX_HEAP, HP_COPY);
+	test_hp_build(MIN_HEAP, HP_ADOPT);
+	test_hp_build(MAX_HEAP, HP_ADOPT);
+	test_hp_build_block(MIN_HEAP);
+	test_hp_build_block(MAX_HEAP);
+	test_hp_peek_pop();
+	test_hp_sort_drain(MIN_HEAP);
+	test_hp_sort_drain(MAX_HEAP);
 	return 0;
 }
 
@@ -2,7 +2,7 @@
  * test/htTest.c:
  *
  * St: 2016-09-27 Tue 01:50 PM
- * Up: 2016-09-27 Tue 11:38 PM
+ * Up: 2026-10-17 Sat 08:37 AM
  *
  * Author: SPS
  *
@@ -34,6 +34,7 @@
 #include<stdlib.h>
 #include<string.h>
 #include<assert.h>
+#include<time.h>
 
 #include"funcutils.h"
 #include"../src/mylib.h"
@@ -41,6 +42,11 @@
 #define SKIP
 #define TEST_ERR 1
 #define TOT_SLOTS 5
+#define GROW_INSERT_COUNT 1000
+#define BATCH_COUNT 100
+#define BENCH_KEYS (1 << 20)
+#define MAX_FP_RATE 0.02
+#define SCAN_THREADS 4
 
 /*
  * Different hash table types
@@ -55,7 +61,7 @@
  *
  * Following tests are performed:
  *
- * 1. h->tot_slots is correct
+ * 1. h->tot_slots is TOT_SLOTS rounded up to a power of 2
  * 2. Agnostic of h->table, as there is no straight forward
  *    way to test its correctness.
  * 3. h->k_cpy is correct
@@ -69,7 +75,9 @@
  */
 int test_ht_create(struct ht *h, int type)
 {
-	assert(h->tot_slots == TOT_SLOTS);
+	assert(h->tot_slots >= TOT_SLOTS);
+	assert(h->tot_slots < 2 * TOT_SLOTS);
+	assert((h->tot_slots & (h->tot_slots - 1)) == 0);
 
 	switch(type) {
 	case KINT_VINT:
@@ -246,6 +254,826 @@ int test_ht_kstr_vstr(void)
 	return 1;
 }
 
+/*
+ * Test that hash table grows incrementally as members are added.
+ *
+ * Following tests are performed:
+ *
+ * 1. Table starts growing once load factor goes beyond max_load
+ * 2. All members are found while the table is growing, and after
+ * 3. Growing finishes and tot_slots goes up
+ * 4. h->nmemb is right after inserts and deletes
+ * 5. Table does not grow if growing is turned off
+ * 6. A duplicate key still gets the newest val after a grow
+ */
+int test_ht_grow(void)
+{
+	int i;
+	int k;
+	int v;
+	int seen_rehash;
+	struct ht *h;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	seen_rehash = 0;
+	for (i = 0; i < GROW_INSERT_COUNT; i++) {
+		v = i * 2;
+		ht_insert(h, &i, &v);
+		if (ht_is_rehashing(h))
+			seen_rehash = 1;
+		assert(ht_search(h, &i) == 1);
+	}
+	assert(seen_rehash == 1);
+	assert(ht_tot_memb(h) == GROW_INSERT_COUNT);
+
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		assert(ht_search(h, &i) == 1);
+	i = GROW_INSERT_COUNT;
+	assert(ht_search(h, &i) == 0);
+
+	/* Searches above have moved every slot by now */
+	assert(ht_is_rehashing(h) == 0);
+	assert(h->tot_slots > TOT_SLOTS);
+	assert(h->nmemb <= h->max_load * h->tot_slots);
+
+	for (i = 0; i < GROW_INSERT_COUNT; i += 2)
+		ht_delete(h, &i);
+	assert(ht_tot_memb(h) == GROW_INSERT_COUNT / 2);
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		assert(ht_search(h, &i) == i % 2);
+
+	ht_destroy(h);
+
+	/* No growing if max load is 0 */
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	v = h->tot_slots;
+	ht_set_max_load(h, 0);
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		ht_insert(h, &i, &i);
+	assert(ht_is_rehashing(h) == 0);
+	assert(h->tot_slots == v);
+	ht_destroy(h);
+
+	/* Newest duplicate wins before, during and after a grow */
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	k = 7;
+	v = 1;
+	ht_insert(h, &k, &v);
+	v = 2;
+	ht_insert(h, &k, &v);
+	assert(*(int *) ht_get(h, &k) == 2);
+	for (i = 100; !ht_is_rehashing(h); i++)
+		ht_insert(h, &i, &i);
+	v = 3;
+	ht_insert(h, &k, &v);
+	assert(*(int *) ht_get(h, &k) == 3);
+	for (i = 100; ht_is_rehashing(h); i++)
+		ht_search(h, &i);
+	assert(*(int *) ht_get(h, &k) == 3);
+	ht_delete(h, &k);
+	assert(*(int *) ht_get(h, &k) == 2);
+	ht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test ht_iter_begin and ht_iter_next.
+ *
+ * Following tests are performed:
+ *
+ * 1. An empty table yields nothing
+ * 2. Every member is yielded once, also in the middle of a rehash
+ * 3. Yielded pointers are those stored in the table, not copies
+ */
+int test_ht_iter(void)
+{
+	int i;
+	int n;
+	int *key;
+	int *val;
+	char *seen;
+	struct ht *h;
+	struct ht_iter it;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	ht_iter_begin(h, &it);
+	assert(ht_iter_next(&it, NULL, NULL) == 0);
+	assert(ht_iter_next(&it, NULL, NULL) == 0);
+
+	/* Stop inserting while the table is growing */
+	for (n = 0; n < GROW_INSERT_COUNT; n++) {
+		i = n * 2;
+		ht_insert(h, &n, &i);
+		if (n > TOT_SLOTS && ht_is_rehashing(h))
+			break;
+	}
+	n++;
+	assert(ht_is_rehashing(h) == 1);
+
+	seen = calloc(n, 1);
+	assert(seen);
+
+	/* Lookups during the walk do not move members under it */
+	ht_iter_begin(h, &it);
+	for (i = 0; ht_iter_next(&it, (void **) &key, (void **) &val); i++) {
+		assert(*key >= 0 && *key < n);
+		assert(seen[*key] == 0);
+		seen[*key] = 1;
+		assert(*val == *key * 2);
+		assert(ht_get(h, key) == val);
+		assert(ht_search(h, &i) == 1);
+	}
+	assert(i == n);
+	assert(ht_is_rehashing(h) == 1);
+	assert(h->walkers == 0);
+
+	/* A walk ended early lets the rehash go on */
+	ht_iter_begin(h, &it);
+	assert(ht_iter_next(&it, NULL, NULL) == 1);
+	ht_iter_end(&it);
+	ht_iter_end(&it);
+	assert(ht_iter_next(&it, NULL, NULL) == 0);
+	assert(h->walkers == 0);
+	for (i = 0; i < n && ht_is_rehashing(h); i++)
+		ht_search(h, &i);
+	assert(ht_is_rehashing(h) == 0);
+
+	free(seen);
+	ht_destroy(h);
+
+	return 1;
+}
+
+/* Sums kept by each worker of ht_parallel_for_each */
+struct scan_sum {
+	long keys[SCAN_THREADS];
+	long memb[SCAN_THREADS];
+};
+
+/* Table being scanned, for lookups from scan_add */
+struct ht *scan_table;
+
+/* Add a member to the sums of a worker */
+void scan_add(void *key, void *val, void *arg, int worker)
+{
+	struct scan_sum *sum;
+
+	sum = (struct scan_sum *) arg;
+	assert(*(int *) val == *(int *) key * 2);
+	assert(ht_get(scan_table, key) == val);
+	sum->keys[worker] += *(int *) key;
+	sum->memb[worker]++;
+}
+
+/*
+ * Test ht_parallel_for_each: all members are seen once, when the
+ * table is growing and when it is not, for a few thread counts.
+ */
+int test_ht_parallel_for_each(void)
+{
+	int i;
+	int v;
+	int t;
+	long keys;
+	long memb;
+	struct ht *h;
+	struct scan_sum sum;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	for (i = 0; i < GROW_INSERT_COUNT; i++) {
+		v = i * 2;
+		ht_insert(h, &i, &v);
+	}
+	scan_table = h;
+
+	for (t = 1; t <= SCAN_THREADS; t++) {
+		memset(&sum, 0, sizeof(sum));
+		ht_parallel_for_each(h, t, scan_add, &sum);
+
+		keys = 0;
+		memb = 0;
+		for (i = 0; i < SCAN_THREADS; i++) {
+			keys += sum.keys[i];
+			memb += sum.memb[i];
+			if (i >= t)
+				assert(sum.memb[i] == 0);
+		}
+		assert(memb == GROW_INSERT_COUNT);
+		assert(keys == (long) GROW_INSERT_COUNT *
+		               (GROW_INSERT_COUNT - 1) / 2);
+
+		/* Finish any rehash for the next round */
+		for (i = 0; i < GROW_INSERT_COUNT; i++)
+			ht_search(h, &i);
+	}
+
+	ht_destroy(h);
+
+	return 1;
+}
+
+/* A bad hash function: every key hashes to 0 */
+size_t hash_zero(struct ht *h, void *key)
+{
+	return 0;
+}
+
+/*
+ * Test ht_stats.
+ *
+ * Following tests are performed:
+ *
+ * 1. Load, used slots and chain histogram match the table
+ * 2. A hash_func sending every key to one slot shows in max_chain
+ *    and cmps_per_lookup
+ * 3. Operation counters count when built with HT_STATS, else are 0
+ */
+int test_ht_stats(void)
+{
+	int i;
+	size_t n;
+	struct ht *h;
+	struct ht_stats st;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	ht_stats(h, &st);
+	assert(st.nmemb == 0 && st.used_slots == 0 && st.max_chain == 0);
+	assert(st.chain_hist[0] == st.tot_slots);
+
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		ht_insert(h, &i, &i);
+	for (i = 0; i < 2 * GROW_INSERT_COUNT; i++)
+		ht_search(h, &i);
+
+	ht_stats(h, &st);
+	assert(st.nmemb == GROW_INSERT_COUNT);
+	assert(st.load == (double) st.nmemb / st.tot_slots);
+	n = 0;
+	for (i = 0; i < HT_STATS_HIST; i++)
+		n += st.chain_hist[i];
+	assert(n == st.tot_slots);
+	assert(st.chain_hist[0] == st.tot_slots - st.used_slots);
+	assert(st.max_chain < HT_STATS_HIST);
+
+#ifdef HT_STATS
+	assert(st.lookups >= 2 * GROW_INSERT_COUNT);
+	assert(st.hits >= GROW_INSERT_COUNT);
+	assert(st.misses >= GROW_INSERT_COUNT);
+	assert(st.resizes > 0);
+	assert(st.cmps_per_lookup < 2);
+#else
+	assert(st.lookups == 0 && st.key_cmps == 0 && st.resizes == 0);
+#endif
+
+	ht_destroy(h);
+
+	/* Every key in slot 0 */
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	ht_set_hash(h, hash_zero, 0);
+	ht_set_max_load(h, 0);
+	for (i = 0; i < BATCH_COUNT; i++)
+		ht_insert(h, &i, &i);
+	for (i = 0; i < BATCH_COUNT; i++)
+		ht_search(h, &i);
+
+	ht_stats(h, &st);
+	assert(st.used_slots == 1);
+	assert(st.max_chain == BATCH_COUNT);
+	assert(st.chain_hist[HT_STATS_HIST - 1] == 1);
+#ifdef HT_STATS
+	assert(st.cmps_per_lookup > BATCH_COUNT / 4);
+#endif
+
+	ht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test string keys kept in the table's arena.
+ *
+ * Following tests are performed:
+ *
+ * 1. Keys are found, replaced, deleted and walked as without arena
+ * 2. Keys sharing a prefix, or the same hash, are told apart
+ * 3. Keys live in a few chunks, with their hash and length
+ * 4. A key bigger than a chunk gets a chunk of its own
+ */
+int test_ht_key_arena(void)
+{
+	int i;
+	int n;
+	char key[32];
+	char *big;
+	char *kptr;
+	struct ht *h;
+	struct ht_iter it;
+	struct ht_arena_key *hdr;
+
+	h = ht_create(TOT_SLOTS, cpy_s, cpy_i, cmp_s, cmp_i, get_str_size);
+	ht_set_key_arena(h, 0);
+
+	for (i = 0; i < GROW_INSERT_COUNT; i++) {
+		sprintf(key, "key%d", i);
+		ht_insert(h, key, &i);
+	}
+	assert(ht_tot_memb(h) == GROW_INSERT_COUNT);
+	assert(h->arena->nchunks == 1);
+
+	for (i = 0; i < GROW_INSERT_COUNT; i++) {
+		sprintf(key, "key%d", i);
+		assert(*(int *) ht_get(h, key) == i);
+	}
+	assert(ht_search(h, "key") == 0);
+	assert(ht_search(h, "key10000") == 0);
+
+	i = -1;
+	ht_upsert(h, "key7", &i);
+	assert(*(int *) ht_get(h, "key7") == -1);
+	assert(ht_tot_memb(h) == GROW_INSERT_COUNT);
+
+	ht_delete(h, "key7");
+	assert(ht_search(h, "key7") == 0);
+	assert(h->arena->dead > 0);
+
+	/* Stored keys carry hash and length */
+	n = 0;
+	ht_iter_begin(h, &it);
+	while (ht_iter_next(&it, (void **) &kptr, NULL)) {
+		hdr = (struct ht_arena_key *) kptr - 1;
+		assert(hdr->len == strlen(kptr));
+		assert(hdr->hash == h->hash_func(h, kptr));
+		n++;
+	}
+	assert(n == GROW_INSERT_COUNT - 1);
+
+	/* Same hash, different keys */
+	ht_destroy(h);
+	h = ht_create(TOT_SLOTS, cpy_s, cpy_i, cmp_s, cmp_i, get_str_size);
+	ht_set_hash(h, hash_zero, 0);
+	ht_set_key_arena(h, 64);
+	i = 1;
+	ht_insert(h, "ab", &i);
+	i = 2;
+	ht_insert(h, "abc", &i);
+	assert(*(int *) ht_get(h, "ab") == 1);
+	assert(*(int *) ht_get(h, "abc") == 2);
+	assert(ht_search(h, "a") == 0);
+
+	big = malloc(200);
+	assert(big);
+	memset(big, 'x', 199);
+	big[199] = '\0';
+	ht_insert(h, big, &i);
+	assert(ht_search(h, big) == 1);
+	assert(h->arena->nchunks == 2);
+	free(big);
+
+	ht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test ht_build_bulk.
+ *
+ * Following tests are performed:
+ *
+ * 1. All members are found, with 1 to SCAN_THREADS threads
+ * 2. The table is sized once and is not growing afterwards
+ * 3. With duplicate keys the last val is found, as with ht_insert
+ * 4. Bloom filter and key arena tables load right
+ */
+int test_ht_build_bulk(void)
+{
+	int i;
+	int t;
+	int *k;
+	int *v;
+	int *vptr;
+	void **keys;
+	void **vals;
+	char (*s)[16];
+	struct ht *h;
+
+	k = malloc(GROW_INSERT_COUNT * sizeof(int));
+	v = malloc(GROW_INSERT_COUNT * sizeof(int));
+	s = malloc(GROW_INSERT_COUNT * sizeof(*s));
+	keys = malloc(GROW_INSERT_COUNT * sizeof(void *));
+	vals = malloc(GROW_INSERT_COUNT * sizeof(void *));
+	assert(k && v && s && keys && vals);
+
+	/* Keys 0 .. 899, the last 100 again with other vals */
+	for (i = 0; i < GROW_INSERT_COUNT; i++) {
+		k[i] = i % (GROW_INSERT_COUNT - 100);
+		v[i] = i;
+		keys[i] = &k[i];
+		vals[i] = &v[i];
+	}
+
+	for (t = 1; t <= SCAN_THREADS; t++) {
+		h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i,
+		              get_int_size);
+		if (t == SCAN_THREADS)
+			ht_set_bloom(h, BLOOM_BITS_PER_KEY);
+		/* Deleted members leave empty lists behind */
+		ht_insert(h, &t, &t);
+		ht_delete(h, &t);
+
+		ht_build_bulk(h, keys, vals, GROW_INSERT_COUNT, t);
+
+		assert(ht_tot_memb(h) == GROW_INSERT_COUNT);
+		assert(ht_is_rehashing(h) == 0);
+		assert(h->nmemb <= h->max_load * h->tot_slots);
+
+		for (i = 0; i < GROW_INSERT_COUNT - 100; i++) {
+			vptr = ht_get(h, &i);
+			assert(vptr != NULL);
+			if (i < 100)
+				assert(*vptr == i + GROW_INSERT_COUNT - 100);
+			else
+				assert(*vptr == i);
+		}
+		i = GROW_INSERT_COUNT;
+		assert(ht_search(h, &i) == 0);
+
+		ht_destroy(h);
+	}
+
+	/* str keys in an arena */
+	for (i = 0; i < GROW_INSERT_COUNT; i++) {
+		sprintf(s[i], "key%d", i);
+		keys[i] = s[i];
+	}
+	h = ht_create(TOT_SLOTS, cpy_s, cpy_i, cmp_s, cmp_i, get_str_size);
+	ht_set_key_arena(h, 0);
+	ht_build_bulk(h, keys, vals, GROW_INSERT_COUNT, SCAN_THREADS);
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		assert(*(int *) ht_get(h, s[i]) == i);
+	ht_destroy(h);
+
+	free(k);
+	free(v);
+	free(s);
+	free(keys);
+	free(vals);
+
+	return 1;
+}
+
+/*
+ * Test hash function of hash table.
+ *
+ * Following tests are performed:
+ *
+ * 1. Keys with same bytes in different order land in different
+ *    slots often enough, i.e. hash is order sensitive
+ * 2. A different seed changes the hash values
+ * 3. Chains stay short for similar string keys
+ */
+int test_ht_hash(void)
+{
+	int i;
+	int diff;
+	size_t hash;
+	size_t longest;
+	char key[8];
+	char rev[8];
+	struct ht *h;
+
+	h = ht_create(1024, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+	ht_set_max_load(h, 0);
+
+	/* "ab" and "ba" etc. must not always collide */
+	diff = 0;
+	for (i = 0; i < 100; i++) {
+		sprintf(key, "k%03d", i);
+		rev[0] = key[3]; rev[1] = key[2]; rev[2] = key[1];
+		rev[3] = key[0]; rev[4] = '\0';
+		if (h->hash_func(h, key) != h->hash_func(h, rev))
+			diff++;
+	}
+	assert(diff >= 90);
+
+	/* Seed changes hash value */
+	hash = h->hash_func(h, "name");
+	ht_set_hash(h, NULL, HASH_SEED + 1);
+	assert(h->hash_func(h, "name") != hash);
+
+	/* 1024 similar keys in 1024 slots: no long chains */
+	for (i = 0; i < 1024; i++) {
+		sprintf(key, "key%d", i);
+		ht_insert(h, key, key);
+	}
+	longest = 0;
+	for (i = 0; i < h->tot_slots; i++)
+		if (h->table[i] != NULL && h->table[i]->nmemb > longest)
+			longest = h->table[i]->nmemb;
+	assert(longest < 10);
+
+	ht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test ht_get, ht_upsert and ht_get_or_insert.
+ *
+ * Following tests are performed:
+ *
+ * 1. ht_get returns pointer to stored val, NULL if no such key
+ * 2. ht_upsert inserts a missing key and replaces val of a present
+ *    one, without adding a duplicate
+ * 3. ht_get_or_insert returns the stored val if key is present,
+ *    else inserts and returns the new val
+ * 4. Pointers from ht_get stay valid while the table grows
+ */
+int test_ht_get_upsert(void)
+{
+	int i;
+	int v;
+	int *vptr;
+	int *vptr7;
+	struct ht *h;
+
+	h = ht_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+
+	ht_insert(h, "name", "lahm");
+	assert(strcmp(ht_get(h, "name"), "lahm") == 0);
+	assert(ht_get(h, "game") == NULL);
+
+	assert(ht_upsert(h, "name", "thomas") == 0);
+	assert(ht_tot_memb(h) == 1);
+	assert(strcmp(ht_get(h, "name"), "thomas") == 0);
+
+	assert(ht_upsert(h, "game", "football") == 1);
+	assert(ht_tot_memb(h) == 2);
+	assert(strcmp(ht_get(h, "game"), "football") == 0);
+
+	assert(strcmp(ht_get_or_insert(h, "game", "cricket"), "football") == 0);
+	assert(ht_tot_memb(h) == 2);
+	assert(strcmp(ht_get_or_insert(h, "team", "bayern"), "bayern") == 0);
+	assert(ht_tot_memb(h) == 3);
+	assert(ht_get(h, "team") == ht_get_or_insert(h, "team", "x"));
+
+	ht_delete(h, "name");
+	assert(ht_get(h, "name") == NULL);
+	assert(ht_tot_memb(h) == 2);
+
+	ht_destroy(h);
+
+	/* Counting with ht_get_or_insert, across growing */
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	v = 0;
+	i = 7;
+	vptr7 = ht_get_or_insert(h, &i, &v);
+	for (i = 0; i < GROW_INSERT_COUNT; i++) {
+		vptr = ht_get_or_insert(h, &i, &v);
+		(*vptr)++;
+		vptr = ht_get_or_insert(h, &i, &v);
+		(*vptr)++;
+	}
+	assert(ht_tot_memb(h) == GROW_INSERT_COUNT);
+	assert(h->tot_slots > TOT_SLOTS);
+	assert(*vptr7 == 2);
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		assert(*(int *) ht_get(h, &i) == 2);
+
+	ht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test ht_search_batch and ht_get_batch.
+ *
+ * Following tests are performed:
+ *
+ * 1. Batch results match ht_get for present and missing keys
+ * 2. Batches that are not a multiple of HT_BATCH_GROUP, and empty
+ *    batches, work
+ * 3. Batches work while the table is growing
+ */
+int test_ht_batch(void)
+{
+	int i;
+	int k[GROW_INSERT_COUNT];
+	int found[GROW_INSERT_COUNT];
+	void *keys[GROW_INSERT_COUNT];
+	void *vals[GROW_INSERT_COUNT];
+	struct ht *h;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	/* Every second key of 0 .. 2 * BATCH_COUNT - 1 is present */
+	for (i = 0; i < 2 * BATCH_COUNT; i += 2)
+		ht_insert(h, &i, &i);
+
+	for (i = 0; i < 2 * BATCH_COUNT; i++) {
+		k[i] = i;
+		keys[i] = &k[i];
+	}
+
+	assert(ht_search_batch(h, keys, 2 * BATCH_COUNT - 3, found) ==
+	       BATCH_COUNT - 1);
+	assert(ht_get_batch(h, keys, 2 * BATCH_COUNT - 3, vals) ==
+	       BATCH_COUNT - 1);
+	for (i = 0; i < 2 * BATCH_COUNT - 3; i++) {
+		assert(found[i] == !(i % 2));
+		assert(vals[i] == ht_get(h, &i));
+		if (vals[i] != NULL)
+			assert(*(int *) vals[i] == i);
+	}
+	assert(ht_get_batch(h, keys, 0, vals) == 0);
+
+	ht_destroy(h);
+
+	/* Interleave batches with inserts that grow the table */
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	for (i = 0; i < GROW_INSERT_COUNT; i++) {
+		k[i] = i;
+		keys[i] = &k[i];
+		ht_insert(h, &i, &i);
+		assert(ht_search_batch(h, keys, i + 1, found) == i + 1);
+	}
+	assert(ht_get_batch(h, keys, GROW_INSERT_COUNT, vals) ==
+	       GROW_INSERT_COUNT);
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		assert(*(int *) vals[i] == i);
+
+	ht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test bloom filter in front of lookups.
+ *
+ * Following tests are performed:
+ *
+ * 1. Members are found, with the filter set before or after
+ *    inserting, across growing of table and filter
+ * 2. Absent keys are not found, and the observed false positive
+ *    rate is low
+ * 3. Deleted keys are not found and the filter gets rebuilt
+ * 4. Filter can be removed
+ */
+int test_ht_bloom(void)
+{
+	int i;
+	struct ht *h;
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	assert(h->bloom == NULL);
+	assert(ht_bloom_fp_rate(h) == 0);
+
+	for (i = 0; i < GROW_INSERT_COUNT / 2; i++)
+		ht_insert(h, &i, &i);
+	ht_set_bloom(h, BLOOM_BITS_PER_KEY);
+	assert(h->bloom->nkeys == GROW_INSERT_COUNT / 2);
+	for (i = GROW_INSERT_COUNT / 2; i < GROW_INSERT_COUNT; i++)
+		ht_insert(h, &i, &i);
+	assert(h->bloom->nkeys == GROW_INSERT_COUNT);
+	assert(h->bloom->cap >= GROW_INSERT_COUNT);
+
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		assert(*(int *) ht_get(h, &i) == i);
+	for (i = GROW_INSERT_COUNT; i < 100 * GROW_INSERT_COUNT; i++)
+		assert(ht_search(h, &i) == 0);
+	assert(ht_bloom_fp_rate(h) < MAX_FP_RATE);
+
+	/* Deleting most keys makes the filter rebuild */
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		if (i % 4 != 0)
+			ht_delete(h, &i);
+	assert(ht_tot_memb(h) == GROW_INSERT_COUNT / 4);
+	assert(h->bloom->nkeys - h->bloom_stale == GROW_INSERT_COUNT / 4);
+	assert(h->bloom_stale * 2 <= h->bloom->nkeys);
+	for (i = 0; i < GROW_INSERT_COUNT; i++)
+		assert(ht_search(h, &i) == (i % 4 == 0));
+	assert(ht_bloom_fp_rate(h) < MAX_FP_RATE);
+
+	ht_set_bloom(h, 0);
+	assert(h->bloom == NULL);
+	assert(ht_search(h, &i) == 0);
+	i = 4;
+	assert(ht_search(h, &i) == 1);
+
+	ht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Print lookup throughput of ht_get one key at a time and of
+ * ht_get_batch, on a table too big for cache, with keys in random
+ * order.
+ */
+int bench_ht_batch(void)
+{
+	int i;
+	int *k;
+	void **keys;
+	void **vals;
+	double secs;
+	struct ht *h;
+	struct timespec t0;
+	struct timespec t1;
+
+	h = ht_create(BENCH_KEYS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	k = malloc(BENCH_KEYS * sizeof(int));
+	keys = malloc(BENCH_KEYS * sizeof(void *));
+	vals = malloc(BENCH_KEYS * sizeof(void *));
+	assert(k && keys && vals);
+
+	for (i = 0; i < BENCH_KEYS; i++) {
+		ht_insert(h, &i, &i);
+		k[i] = ((unsigned) i * 2654435761U) % BENCH_KEYS;
+		keys[i] = &k[i];
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < BENCH_KEYS; i++)
+		vals[i] = ht_get(h, keys[i]);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("ht: ht_get:       %.2f M lookups/s\n", BENCH_KEYS / secs / 1e6);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	assert(ht_get_batch(h, keys, BENCH_KEYS, vals) == BENCH_KEYS);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("ht: ht_get_batch: %.2f M lookups/s\n", BENCH_KEYS / secs / 1e6);
+
+	free(k);
+	free(keys);
+	free(vals);
+
+	ht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Time loading BENCH_KEYS members with ht_insert, and with
+ * ht_build_bulk on 1 and SCAN_THREADS threads.
+ */
+int bench_ht_build_bulk(void)
+{
+	int i;
+	int t;
+	int *k;
+	void **keys;
+	double secs;
+	struct ht *h;
+	struct timespec t0;
+	struct timespec t1;
+
+	k = malloc(BENCH_KEYS * sizeof(int));
+	keys = malloc(BENCH_KEYS * sizeof(void *));
+	assert(k && keys);
+
+	for (i = 0; i < BENCH_KEYS; i++) {
+		k[i] = ((unsigned) i * 2654435761U) % BENCH_KEYS;
+		keys[i] = &k[i];
+	}
+
+	h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < BENCH_KEYS; i++)
+		ht_insert(h, keys[i], keys[i]);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("ht: ht_insert:        %.2f M inserts/s\n",
+	       BENCH_KEYS / secs / 1e6);
+	ht_destroy(h);
+
+	for (t = 1; t <= SCAN_THREADS; t *= SCAN_THREADS) {
+		h = ht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i,
+		              get_int_size);
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		ht_build_bulk(h, keys, keys, BENCH_KEYS, t);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		secs = (t1.tv_sec - t0.tv_sec) +
+		       (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		printf("ht: ht_build_bulk(%d): %.2f M inserts/s\n", t,
+		       BENCH_KEYS / secs / 1e6);
+		assert(ht_tot_memb(h) == BENCH_KEYS);
+		ht_destroy(h);
+	}
+
+	free(k);
+	free(keys);
+
+	return 1;
+}
+
 /* main: start */
 int main(void)
 {
@@ -253,6 +1081,18 @@ int main(void)
 	test_ht_kint_vstr();
 	test_ht_kstr_vint();
 	test_ht_kstr_vstr();
+	test_ht_grow();
+	test_ht_iter();
+	test_ht_parallel_for_each();
+	test_ht_stats();
+	test_ht_key_arena();
+	test_ht_build_bulk();
+	test_ht_hash();
+	test_ht_get_upsert();
+	test_ht_batch();
+	test_ht_bloom();
+	bench_ht_batch();
+	bench_ht_build_bulk();
 
 	return 0;
 }
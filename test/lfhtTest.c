@@ -0,0 +1,248 @@
+/*
+ * test/lfhtTest.c: Test lock free hash table implementation
+ *
+ * St: 2026-10-17 Sat 07:12 AM
+ * Up: 2026-10-17 Sat 07:12 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<pthread.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define TOT_SLOTS 5
+#define INSERT_COUNT 1000
+#define MAX_THREADS 8
+#define KEYS_PER_THREAD 2000
+#define LOOKUPS_PER_THREAD 50000
+
+/* Work for one test thread */
+struct thread_arg {
+	struct lfht *h;
+	int first;          /* first key of the thread */
+	int count;          /* number of keys */
+	long found;         /* keys found by a reader */
+};
+
+/* Test lfht_create function */
+int test_lfht_create(void)
+{
+	struct lfht *h;
+
+	h = lfht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	/* Bucket count is rounded up to a power of 2 */
+	assert(h->tot_slots == 8);
+	assert(lfht_tot_memb(h) == 0);
+
+	assert(test_cpy_i(h->k_cpy) == 1);
+	assert(test_cmp_i(h->k_cmp) == 1);
+	assert(test_cpy_i(h->v_cpy) == 1);
+	assert(test_cmp_i(h->v_cmp) == 1);
+	assert(test_get_size_i(h->get_key_size) == 1);
+
+	lfht_destroy(h);
+
+	return 1;
+}
+
+/* Test lock free hash table from one thread */
+int test_lfht_kint_vint(void)
+{
+	int i;
+	int v;
+	int *vptr;
+	struct lfht *h;
+
+	h = lfht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = i * 3;
+		assert(lfht_insert(h, &i, &v) == 1);
+	}
+	assert(lfht_tot_memb(h) == INSERT_COUNT);
+	assert(h->tot_slots * LFHT_MAX_LOAD >= INSERT_COUNT);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		vptr = lfht_get(h, &i);
+		assert(*vptr == i * 3);
+		free(vptr);
+	}
+	i = INSERT_COUNT;
+	assert(lfht_search(h, &i) == 0);
+	assert(lfht_get(h, &i) == NULL);
+
+	/* Insert with an existing key replaces the val */
+	i = 7;
+	v = 700;
+	assert(lfht_insert(h, &i, &v) == 0);
+	assert(lfht_tot_memb(h) == INSERT_COUNT);
+	vptr = lfht_get(h, &i);
+	assert(*vptr == 700);
+	free(vptr);
+
+	for (i = 1; i < INSERT_COUNT; i += 2)
+		lfht_delete(h, &i);
+	assert(lfht_tot_memb(h) == INSERT_COUNT / 2);
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(lfht_search(h, &i) == !(i % 2));
+
+	/* Deleting a missing key has no effect */
+	i = 1;
+	lfht_delete(h, &i);
+	assert(lfht_tot_memb(h) == INSERT_COUNT / 2);
+
+	lfht_destroy(h);
+
+	return 1;
+}
+
+/* Test lock free hash table with str key and str val */
+int test_lfht_kstr_vstr(void)
+{
+	struct lfht *h;
+
+	h = lfht_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+
+	lfht_insert(h, "name", "lahm");
+	lfht_insert(h, "game", "football");
+	lfht_insert(h, "ab", "thomas");
+	lfht_insert(h, "ba", "thomas");
+	lfht_insert(h, "name", "phillip");
+	assert(lfht_tot_memb(h) == 4);
+
+	assert(lfht_search(h, "name") == 1);
+	assert(lfht_search(h, "tameee") == 0);
+	lfht_delete(h, "ab");
+	assert(lfht_search(h, "ab") == 0);
+	assert(lfht_search(h, "ba") == 1);
+
+	lfht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Thread body: insert keys first .. first + count - 1, then delete
+ * the odd ones and insert them again, so deleted nodes get retired
+ * while readers may still be on them.
+ */
+void *writer(void *arg)
+{
+	int i;
+	struct thread_arg *ta;
+
+	ta = arg;
+	for (i = ta->first; i < ta->first + ta->count; i++)
+		lfht_insert(ta->h, &i, &i);
+	for (i = ta->first + 1; i < ta->first + ta->count; i += 2)
+		lfht_delete(ta->h, &i);
+	for (i = ta->first + 1; i < ta->first + ta->count; i += 2)
+		lfht_insert(ta->h, &i, &i);
+
+	return NULL;
+}
+
+/* Thread body: look keys up, counting hits */
+void *reader(void *arg)
+{
+	int i;
+	int j;
+	int *vptr;
+	struct thread_arg *ta;
+
+	ta = arg;
+	ta->found = 0;
+	for (j = 0; j < LOOKUPS_PER_THREAD; j++) {
+		i = ta->first + j % ta->count;
+		vptr = lfht_get(ta->h, &i);
+		if (vptr != NULL) {
+			assert(*vptr == i);
+			ta->found++;
+			free(vptr);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Test concurrent inserts and deletes (which make the table grow
+ * and retire nodes) running next to readers, then check that every
+ * key made it.
+ */
+int test_lfht_threads(void)
+{
+	int i;
+	int *vptr;
+	struct lfht *h;
+	pthread_t tid[2 * MAX_THREADS];
+	struct thread_arg ta[2 * MAX_THREADS];
+
+	h = lfht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	for (i = 0; i < MAX_THREADS; i++) {
+		ta[i].h = h;
+		ta[i].first = i * KEYS_PER_THREAD;
+		ta[i].count = KEYS_PER_THREAD;
+		pthread_create(&tid[i], NULL, writer, &ta[i]);
+
+		ta[MAX_THREADS + i] = ta[i];
+		pthread_create(&tid[MAX_THREADS + i], NULL, reader,
+		               &ta[MAX_THREADS + i]);
+	}
+	for (i = 0; i < 2 * MAX_THREADS; i++)
+		pthread_join(tid[i], NULL);
+
+	assert(lfht_tot_memb(h) == MAX_THREADS * KEYS_PER_THREAD);
+	for (i = 0; i < MAX_THREADS * KEYS_PER_THREAD; i++) {
+		vptr = lfht_get(h, &i);
+		assert(vptr != NULL && *vptr == i);
+		free(vptr);
+	}
+
+	lfht_destroy(h);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_lfht_create();
+	test_lfht_kint_vint();
+	test_lfht_kstr_vstr();
+	test_lfht_threads();
+
+	return 0;
+}
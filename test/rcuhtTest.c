@@ -0,0 +1,398 @@
+/*
+ * test/rcuhtTest.c: Test RCU hash table implementation
+ *
+ * St: 2026-10-17 Sat 07:39 AM
+ * Up: 2026-10-17 Sat 08:40 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include<pthread.h>
+#include<time.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define TOT_SLOTS 5
+#define INSERT_COUNT 1000
+#define MAX_THREADS 8
+#define KEYS_PER_THREAD 2000
+#define LOOKUPS_PER_THREAD 50000
+#define NEST_KEYS 64
+#define NEST_ROUNDS 2000
+#define BENCH_KEYS (1 << 16)
+#define BENCH_LOOKUPS (1 << 22)
+
+/* Work for one test thread */
+struct thread_arg {
+	struct rcuht *h;
+	int first;          /* first key of the thread */
+	int count;          /* number of keys */
+	long found;         /* keys found by a reader */
+};
+
+/* Test rcuht_create function */
+int test_rcuht_create(void)
+{
+	struct rcuht *h;
+
+	h = rcuht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	/* Slot count is rounded up to a power of 2 */
+	assert(h->table->tot_slots == 8);
+	assert(rcuht_tot_memb(h) == 0);
+
+	assert(test_cpy_i(h->k_cpy) == 1);
+	assert(test_cmp_i(h->k_cmp) == 1);
+	assert(test_cpy_i(h->v_cpy) == 1);
+	assert(test_cmp_i(h->v_cmp) == 1);
+	assert(test_get_size_i(h->get_key_size) == 1);
+
+	rcuht_destroy(h);
+
+	return 1;
+}
+
+/* Test RCU hash table from one thread */
+int test_rcuht_kint_vint(void)
+{
+	int i;
+	int v;
+	int *vptr;
+	struct rcuht *h;
+
+	h = rcuht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = i * 3;
+		assert(rcuht_insert(h, &i, &v) == 1);
+	}
+	assert(rcuht_tot_memb(h) == INSERT_COUNT);
+	assert(h->table->tot_slots * RCUHT_MAX_LOAD >= INSERT_COUNT);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		vptr = rcuht_get(h, &i);
+		assert(*vptr == i * 3);
+		free(vptr);
+	}
+	i = INSERT_COUNT;
+	assert(rcuht_search(h, &i) == 0);
+	assert(rcuht_get(h, &i) == NULL);
+
+	/* Insert with an existing key replaces the val */
+	i = 7;
+	v = 700;
+	assert(rcuht_insert(h, &i, &v) == 0);
+	assert(rcuht_tot_memb(h) == INSERT_COUNT);
+
+	rcuht_read_lock(h);
+	vptr = rcuht_lookup(h, &i);
+	assert(*vptr == 700);
+	i = INSERT_COUNT;
+	assert(rcuht_lookup(h, &i) == NULL);
+	rcuht_read_unlock(h);
+
+	for (i = 1; i < INSERT_COUNT; i += 2)
+		rcuht_delete(h, &i);
+	assert(rcuht_tot_memb(h) == INSERT_COUNT / 2);
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(rcuht_search(h, &i) == !(i % 2));
+
+	/* Deleting a missing key has no effect */
+	i = 1;
+	rcuht_delete(h, &i);
+	assert(rcuht_tot_memb(h) == INSERT_COUNT / 2);
+
+	rcuht_destroy(h);
+
+	return 1;
+}
+
+/* Test RCU hash table with str key and str val */
+int test_rcuht_kstr_vstr(void)
+{
+	char *val;
+	struct rcuht *h;
+
+	h = rcuht_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+
+	rcuht_insert(h, "name", "lahm");
+	rcuht_insert(h, "game", "football");
+	rcuht_insert(h, "ab", "thomas");
+	rcuht_insert(h, "ba", "thomas");
+	rcuht_insert(h, "name", "phillip");
+	assert(rcuht_tot_memb(h) == 4);
+
+	assert(rcuht_search(h, "name") == 1);
+	val = rcuht_get(h, "name");
+	assert(strcmp(val, "phillip") == 0);
+	free(val);
+	assert(rcuht_search(h, "tameee") == 0);
+	rcuht_delete(h, "ab");
+	assert(rcuht_search(h, "ab") == 0);
+	assert(rcuht_search(h, "ba") == 1);
+
+	rcuht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Thread body: insert keys first .. first + count - 1, replace their
+ * vals, then delete the odd ones and insert them again, so nodes
+ * and tables get retired while readers may still be on them.
+ */
+void *writer(void *arg)
+{
+	int i;
+	struct thread_arg *ta;
+
+	ta = arg;
+	for (i = ta->first; i < ta->first + ta->count; i++)
+		rcuht_insert(ta->h, &i, &i);
+	for (i = ta->first; i < ta->first + ta->count; i++)
+		rcuht_insert(ta->h, &i, &i);
+	for (i = ta->first + 1; i < ta->first + ta->count; i += 2)
+		rcuht_delete(ta->h, &i);
+	for (i = ta->first + 1; i < ta->first + ta->count; i += 2)
+		rcuht_insert(ta->h, &i, &i);
+
+	return NULL;
+}
+
+/* Thread body: look keys up without copying, counting hits */
+void *reader(void *arg)
+{
+	int i;
+	int j;
+	int *vptr;
+	struct thread_arg *ta;
+
+	ta = arg;
+	ta->found = 0;
+	for (j = 0; j < LOOKUPS_PER_THREAD; j++) {
+		i = ta->first + j % ta->count;
+		rcuht_read_lock(ta->h);
+		vptr = rcuht_lookup(ta->h, &i);
+		if (vptr != NULL) {
+			assert(*vptr == i);
+			ta->found++;
+		}
+		rcuht_read_unlock(ta->h);
+	}
+
+	return NULL;
+}
+
+/*
+ * Test concurrent inserts, replaces and deletes (which make the
+ * table grow and retire nodes) running next to readers, then check
+ * that every key made it.
+ */
+int test_rcuht_threads(void)
+{
+	int i;
+	int *vptr;
+	struct rcuht *h;
+	pthread_t tid[2 * MAX_THREADS];
+	struct thread_arg ta[2 * MAX_THREADS];
+
+	h = rcuht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	for (i = 0; i < MAX_THREADS; i++) {
+		ta[i].h = h;
+		ta[i].first = i * KEYS_PER_THREAD;
+		ta[i].count = KEYS_PER_THREAD;
+		pthread_create(&tid[i], NULL, writer, &ta[i]);
+
+		ta[MAX_THREADS + i] = ta[i];
+		pthread_create(&tid[MAX_THREADS + i], NULL, reader,
+		               &ta[MAX_THREADS + i]);
+	}
+	for (i = 0; i < 2 * MAX_THREADS; i++)
+		pthread_join(tid[i], NULL);
+
+	assert(rcuht_tot_memb(h) == MAX_THREADS * KEYS_PER_THREAD);
+	for (i = 0; i < MAX_THREADS * KEYS_PER_THREAD; i++) {
+		vptr = rcuht_get(h, &i);
+		assert(vptr != NULL && *vptr == i);
+		free(vptr);
+	}
+
+	rcuht_destroy(h);
+
+	return 1;
+}
+
+/* Set by test_rcuht_nested when its reader is done */
+_Atomic int nest_done;
+
+/*
+ * Thread body: replace and delete keys 0 .. NEST_KEYS - 1 until the
+ * reader is done, so their vals keep getting retired and freed.
+ */
+void *nest_writer(void *arg)
+{
+	int i;
+	struct rcuht *h;
+
+	h = arg;
+	while (!atomic_load(&nest_done))
+		for (i = 0; i < NEST_KEYS; i++) {
+			rcuht_insert(h, &i, &i);
+			rcuht_delete(h, &i);
+			rcuht_insert(h, &i, &i);
+		}
+
+	return NULL;
+}
+
+/*
+ * Test that a val got by rcuht_lookup stays valid while rcuht_get,
+ * rcuht_search and nested sections are used in the same read
+ * section, with a writer freeing vals next to it.
+ */
+int test_rcuht_nested(void)
+{
+	int i;
+	int j;
+	int k;
+	int *v;
+	int *vptr;
+	struct rcuht *h;
+	pthread_t tid;
+
+	h = rcuht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	for (i = 0; i < NEST_KEYS; i++)
+		rcuht_insert(h, &i, &i);
+
+	atomic_store(&nest_done, 0);
+	pthread_create(&tid, NULL, nest_writer, h);
+
+	for (j = 0; j < NEST_ROUNDS; j++) {
+		i = j % NEST_KEYS;
+		rcuht_read_lock(h);
+		vptr = rcuht_lookup(h, &i);
+		for (k = 0; vptr != NULL && k < NEST_KEYS; k++) {
+			v = rcuht_get(h, &k);
+			free(v);
+			rcuht_search(h, &k);
+			rcuht_read_lock(h);
+			rcuht_read_unlock(h);
+			assert(*vptr == i);
+		}
+		rcuht_read_unlock(h);
+	}
+
+	atomic_store(&nest_done, 1);
+	pthread_join(tid, NULL);
+
+	rcuht_destroy(h);
+
+	return 1;
+}
+
+/* Thread body of the bench: BENCH_LOOKUPS / count lookups */
+void *bench_reader(void *arg)
+{
+	int i;
+	int j;
+	struct thread_arg *ta;
+
+	ta = arg;
+	ta->found = 0;
+	for (j = 0; j < BENCH_LOOKUPS / ta->count; j++) {
+		i = (ta->first + j * 7) & (BENCH_KEYS - 1);
+		rcuht_read_lock(ta->h);
+		ta->found += rcuht_lookup(ta->h, &i) != NULL;
+		rcuht_read_unlock(ta->h);
+	}
+
+	return NULL;
+}
+
+/*
+ * Time a fixed number of lookups split over 1, 2, 4 and 8 reader
+ * threads. With lock free readers the time should drop with more
+ * threads, as far as there are cores.
+ */
+int bench_rcuht_read(void)
+{
+	int i;
+	int n;
+	double secs;
+	struct rcuht *h;
+	struct timespec t0;
+	struct timespec t1;
+	pthread_t tid[MAX_THREADS];
+	struct thread_arg ta[MAX_THREADS];
+
+	h = rcuht_create(BENCH_KEYS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+	for (i = 0; i < BENCH_KEYS; i++)
+		rcuht_insert(h, &i, &i);
+
+	for (n = 1; n <= MAX_THREADS; n *= 2) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (i = 0; i < n; i++) {
+			ta[i].h = h;
+			ta[i].first = i * 1013;
+			ta[i].count = n;
+			pthread_create(&tid[i], NULL, bench_reader, &ta[i]);
+		}
+		for (i = 0; i < n; i++) {
+			pthread_join(tid[i], NULL);
+			assert(ta[i].found == BENCH_LOOKUPS / n);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+
+		secs = (t1.tv_sec - t0.tv_sec) +
+		       (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		printf("rcuht: %d readers: %.2f M lookups/s\n", n,
+		       BENCH_LOOKUPS / secs / 1e6);
+	}
+
+	rcuht_destroy(h);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_rcuht_create();
+	test_rcuht_kint_vint();
+	test_rcuht_kstr_vstr();
+	test_rcuht_threads();
+	test_rcuht_nested();
+	bench_rcuht_read();
+
+	return 0;
+}
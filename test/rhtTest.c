@@ -0,0 +1,320 @@
+/*
+ * test/rhtTest.c: Test Robin Hood hash table implementation
+ *
+ * St: 2026-10-17 Sat 07:02 AM
+ * Up: 2026-10-17 Sat 08:13 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define TOT_SLOTS 5
+#define INSERT_COUNT 1000
+
+/*
+ * Check that no member sits at a distance from its home slot
+ * larger than the member in the slot before it allows, i.e. that
+ * the Robin Hood invariant holds everywhere.
+ *
+ * @h: Pointer to the hash table structure
+ */
+int rht_is_sane(struct rht *h)
+{
+	size_t i;
+	size_t mask;
+	size_t nmemb;
+	size_t dist;
+	size_t prev;
+
+	mask = h->tot_slots - 1;
+	nmemb = 0;
+
+	for (i = 0; i < h->tot_slots; i++) {
+		if (h->slots[i].key == NULL)
+			continue;
+		nmemb++;
+		dist = (i - (h->slots[i].hash & mask)) & mask;
+		if (dist == 0)
+			continue;
+		/* Previous slot must be taken and not closer to home */
+		prev = (i - 1) & mask;
+		assert(h->slots[prev].key != NULL);
+		assert(((prev - (h->slots[prev].hash & mask)) & mask) + 1 >= dist);
+	}
+
+	assert(nmemb == h->nmemb);
+
+	return 1;
+}
+
+/* Test rht_create function */
+int test_rht_create(void)
+{
+	struct rht *h;
+
+	h = rht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	/* Slot count is rounded up to a power of 2 */
+	assert(h->tot_slots >= TOT_SLOTS);
+	assert((h->tot_slots & (h->tot_slots - 1)) == 0);
+	assert(h->nmemb == 0);
+
+	assert(test_cpy_i(h->k_cpy) == 1);
+	assert(test_cmp_i(h->k_cmp) == 1);
+	assert(test_cpy_i(h->v_cpy) == 1);
+	assert(test_cmp_i(h->v_cmp) == 1);
+	assert(test_get_size_i(h->get_key_size) == 1);
+
+	rht_destroy(h);
+
+	return 1;
+}
+
+/* Test Robin Hood hash table with int key and int val */
+int test_rht_kint_vint(void)
+{
+	int i;
+	int v;
+	int idx;
+	struct rht *h;
+
+	h = rht_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	/* Insert enough members to make the table grow a few times */
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = i * 3;
+		idx = rht_insert(h, &i, &v);
+		assert(cmp_i(h->slots[idx].key, &i) == 0);
+		assert(cmp_i(h->slots[idx].val, &v) == 0);
+	}
+	assert(h->nmemb == INSERT_COUNT);
+	assert(h->nmemb * RHT_LOAD_DEN <= h->tot_slots * RHT_LOAD_NUM);
+	assert(rht_is_sane(h) == 1);
+
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(rht_search(h, &i) == 1);
+	i = INSERT_COUNT;
+	assert(rht_search(h, &i) == 0);
+	i = -1;
+	assert(rht_search(h, &i) == 0);
+
+	/* Insert with an existing key replaces the val */
+	i = 7;
+	v = 700;
+	idx = rht_insert(h, &i, &v);
+	assert(h->nmemb == INSERT_COUNT);
+	assert(*(int *) h->slots[idx].val == 700);
+
+	/* Delete every odd key */
+	for (i = 1; i < INSERT_COUNT; i += 2)
+		rht_delete(h, &i);
+	assert(h->nmemb == INSERT_COUNT / 2);
+	assert(rht_is_sane(h) == 1);
+
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(rht_search(h, &i) == !(i % 2));
+
+	/* Deleting a missing key has no effect */
+	i = 1;
+	rht_delete(h, &i);
+	assert(h->nmemb == INSERT_COUNT / 2);
+
+	rht_destroy(h);
+
+	return 1;
+}
+
+/* Test Robin Hood hash table with str key and str val */
+int test_rht_kstr_vstr(void)
+{
+	struct rht *h;
+
+	h = rht_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+
+	rht_insert(h, "name", "lahm");
+	rht_insert(h, "game", "football");
+	rht_insert(h, "place", "munich");
+	rht_insert(h, "country", "germany");
+	rht_insert(h, "team", "bayern");
+	rht_insert(h, "name", "phillip");
+	rht_insert(h, "ab", "thomas");
+	rht_insert(h, "ba", "thomas");
+	assert(h->nmemb == 7);
+
+	assert(rht_search(h, "name") == 1);
+	assert(strcmp(rht_get(h, "name"), "phillip") == 0);
+	assert(rht_get(h, "tameee") == NULL);
+	assert(rht_search(h, "tameee") == 0);
+	assert(rht_search(h, "ab") == 1);
+	rht_delete(h, "ab");
+	assert(rht_search(h, "ab") == 0);
+	assert(rht_search(h, "ba") == 1);
+	assert(rht_is_sane(h) == 1);
+
+	rht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test fixed size mode with int key and a two int val.
+ *
+ * Following tests are performed:
+ *
+ * 1. Slots are 8 byte aligned and hold hash, key and val inline
+ * 2. Insert, search, get, replace and delete work across growing
+ * 3. rht_get returns pointer to the inline val
+ */
+int test_rht_fixed(void)
+{
+	int i;
+	int v[2];
+	int *vptr;
+	long idx;
+	struct rht *h;
+
+	h = rht_create_fixed(TOT_SLOTS, sizeof(int), sizeof(v));
+
+	assert(h->slot_size == 24);
+	assert(h->slots == NULL);
+	assert(h->nmemb == 0);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v[0] = i;
+		v[1] = i * 3;
+		idx = rht_insert(h, &i, v);
+		assert(memcmp(h->fixed + idx * h->slot_size + sizeof(uint64_t),
+		              &i, sizeof(int)) == 0);
+	}
+	assert(h->nmemb == INSERT_COUNT);
+	assert(h->nmemb * RHT_LOAD_DEN <= h->tot_slots * RHT_LOAD_NUM);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		vptr = rht_get(h, &i);
+		assert(vptr[0] == i && vptr[1] == i * 3);
+	}
+	i = INSERT_COUNT;
+	assert(rht_search(h, &i) == 0);
+	assert(rht_get(h, &i) == NULL);
+
+	/* Insert with an existing key replaces the val in place */
+	i = 7;
+	v[0] = 700;
+	v[1] = 701;
+	rht_insert(h, &i, v);
+	assert(h->nmemb == INSERT_COUNT);
+	vptr = rht_get(h, &i);
+	assert(vptr[0] == 700 && vptr[1] == 701);
+
+	/* Delete every odd key */
+	for (i = 1; i < INSERT_COUNT; i += 2)
+		rht_delete(h, &i);
+	assert(h->nmemb == INSERT_COUNT / 2);
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(rht_search(h, &i) == !(i % 2));
+	i = 8;
+	vptr = rht_get(h, &i);
+	assert(vptr[0] == 8 && vptr[1] == 24);
+
+	rht_destroy(h);
+
+	return 1;
+}
+
+/*
+ * Test that fixed size vals are aligned for their type, also after
+ * an odd sized key.
+ */
+int test_rht_fixed_align(void)
+{
+	int i;
+	long v;
+	long *vptr;
+	char k[3];
+	double d;
+	double *dptr;
+	struct rht *h;
+
+	/* int key, long val */
+	h = rht_create_fixed(TOT_SLOTS, sizeof(int), sizeof(long));
+	assert(h->val_off % sizeof(long) == 0);
+	assert(h->slot_size % sizeof(long) == 0);
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = (long) i << 33;
+		rht_insert(h, &i, &v);
+	}
+	for (i = 0; i < INSERT_COUNT; i++) {
+		vptr = rht_get(h, &i);
+		assert((uintptr_t) vptr % sizeof(long) == 0);
+		assert(*vptr == (long) i << 33);
+	}
+	rht_destroy(h);
+
+	/* 3 byte key, double val */
+	h = rht_create_fixed(TOT_SLOTS, sizeof(k), sizeof(double));
+	for (i = 0; i < INSERT_COUNT; i++) {
+		memset(k, 0, sizeof(k));
+		memcpy(k, &i, 2);
+		d = i / 4.0;
+		rht_insert(h, k, &d);
+	}
+	for (i = 0; i < INSERT_COUNT; i++) {
+		memset(k, 0, sizeof(k));
+		memcpy(k, &i, 2);
+		dptr = rht_get(h, k);
+		assert((uintptr_t) dptr % sizeof(double) == 0);
+		assert(*dptr == i / 4.0);
+	}
+	rht_destroy(h);
+
+	/* Small vals need no padding */
+	h = rht_create_fixed(TOT_SLOTS, 1, 1);
+	assert(h->val_off == sizeof(uint64_t) + 1);
+	assert(h->slot_size == sizeof(uint64_t) + sizeof(uint64_t));
+	rht_destroy(h);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_rht_create();
+	test_rht_kint_vint();
+	test_rht_kstr_vstr();
+	test_rht_fixed();
+	test_rht_fixed_align();
+
+	return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * test/swtTest.c: Test swiss table implementation
+ *
+ * St: 2026-10-17 Sat 07:06 AM
+ * Up: 2026-10-17 Sat 07:06 AM
+ *
+ * Author: SPS
+ *
+ * This file is copyright 2016 SPS.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT.  IN NO EVENT SHALL SPS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+
+#include"funcutils.h"
+#include"../src/mylib.h"
+
+#define SKIP
+#define TOT_SLOTS 5
+#define INSERT_COUNT 1000
+
+/* Number of calls to cmp_i_count */
+static long cmp_count;
+
+/*
+ * Compare two int, counting the calls.
+ *
+ * @val1: Pointer to first int
+ * @val2: Pointer to second int
+ */
+int cmp_i_count(void *val1, void *val2)
+{
+	cmp_count++;
+
+	return cmp_i(val1, val2);
+}
+
+/*
+ * Check that control bytes agree with nmemb and that the cloned
+ * control bytes match the first group.
+ *
+ * @h: Pointer to the hash table structure
+ */
+int swt_is_sane(struct swt *h)
+{
+	size_t i;
+	size_t nmemb;
+
+	nmemb = 0;
+	for (i = 0; i < h->tot_slots; i++)
+		if (h->ctrl[i] >= 0)
+			nmemb++;
+	assert(nmemb == h->nmemb);
+
+	for (i = 0; i < SWT_GROUP_WIDTH; i++)
+		assert(h->ctrl[h->tot_slots + i] == h->ctrl[i]);
+
+	assert(h->nmemb * 8 <= h->tot_slots * 7);
+
+	return 1;
+}
+
+/* Test swt_create function */
+int test_swt_create(void)
+{
+	struct swt *h;
+
+	h = swt_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i, cmp_i, get_int_size);
+
+	assert(h->tot_slots >= SWT_GROUP_WIDTH);
+	assert((h->tot_slots & (h->tot_slots - 1)) == 0);
+	assert(h->nmemb == 0);
+
+	assert(test_cpy_i(h->k_cpy) == 1);
+	assert(test_cmp_i(h->k_cmp) == 1);
+	assert(test_cpy_i(h->v_cpy) == 1);
+	assert(test_cmp_i(h->v_cmp) == 1);
+	assert(test_get_size_i(h->get_key_size) == 1);
+
+	swt_destroy(h);
+
+	return 1;
+}
+
+/* Test swiss table with int key and int val */
+int test_swt_kint_vint(void)
+{
+	int i;
+	int v;
+	int idx;
+	int round;
+	struct swt *h;
+
+	h = swt_create(TOT_SLOTS, cpy_i, cpy_i, cmp_i_count, cmp_i,
+	               get_int_size);
+
+	for (i = 0; i < INSERT_COUNT; i++) {
+		v = i * 3;
+		idx = swt_insert(h, &i, &v);
+		assert(cmp_i(h->slots[idx].key, &i) == 0);
+		assert(cmp_i(h->slots[idx].val, &v) == 0);
+	}
+	assert(h->nmemb == INSERT_COUNT);
+	assert(swt_is_sane(h) == 1);
+
+	for (i = 0; i < INSERT_COUNT; i++)
+		assert(swt_search(h, &i) == 1);
+
+	/* Misses should almost never reach k_cmp */
+	cmp_count = 0;
+	for (i = INSERT_COUNT; i < 2 * INSERT_COUNT; i++)
+		assert(swt_search(h, &i) == 0);
+	assert(cmp_count < INSERT_COUNT / 4);
+
+	/* Insert with an existing key replaces the val */
+	i = 7;
+	v = 700;
+	idx = swt_insert(h, &i, &v);
+	assert(h->nmemb == INSERT_COUNT);
+	assert(*(int *) h->slots[idx].val == 700);
+
+	/* Churn: delete and insert again, leaving deleted slots */
+	for (round = 0; round < 5; round++) {
+		for (i = 1; i < INSERT_COUNT; i += 2)
+			swt_delete(h, &i);
+		assert(h->nmemb == INSERT_COUNT / 2);
+		assert(swt_is_sane(h) == 1);
+		for (i = 0; i < INSERT_COUNT; i++)
+			assert(swt_search(h, &i) == !(i % 2));
+		for (i = 1; i < INSERT_COUNT; i += 2)
+			swt_insert(h, &i, &i);
+		assert(h->nmemb == INSERT_COUNT);
+	}
+
+	/* Deleting a missing key has no effect */
+	i = -1;
+	swt_delete(h, &i);
+	assert(h->nmemb == INSERT_COUNT);
+
+	for (i = 0; i < INSERT_COUNT; i++)
+		swt_delete(h, &i);
+	assert(h->nmemb == 0);
+	assert(swt_is_sane(h) == 1);
+
+	swt_destroy(h);
+
+	return 1;
+}
+
+/* Test swiss table with str key and str val */
+int test_swt_kstr_vstr(void)
+{
+	struct swt *h;
+
+	h = swt_create(TOT_SLOTS, cpy_s, cpy_s, cmp_s, cmp_s, get_str_size);
+
+	swt_insert(h, "name", "lahm");
+	swt_insert(h, "game", "football");
+	swt_insert(h, "place", "munich");
+	swt_insert(h, "country", "germany");
+	swt_insert(h, "team", "bayern");
+	swt_insert(h, "name", "phillip");
+	swt_insert(h, "ab", "thomas");
+	swt_insert(h, "ba", "thomas");
+	assert(h->nmemb == 7);
+
+	assert(swt_search(h, "name") == 1);
+	assert(swt_search(h, "tameee") == 0);
+	assert(swt_search(h, "ab") == 1);
+	swt_delete(h, "ab");
+	assert(swt_search(h, "ab") == 0);
+	assert(swt_search(h, "ba") == 1);
+	assert(swt_is_sane(h) == 1);
+
+	swt_destroy(h);
+
+	return 1;
+}
+
+/* main: start */
+int main(void)
+{
+	test_swt_create();
+	test_swt_kint_vint();
+	test_swt_kstr_vstr();
+
+	return 0;
+}